@@ -59,6 +59,14 @@ namespace ttrk{
 
     virtual bool ClassifyFrame(boost::shared_ptr<sv::Frame> frame);
 
+    /**
+    * Classify the pixels of a frame which are near a model, leaving the rest of the classification map zero.
+    * @param[in] frame The frame to classify.
+    * @param[in] sdf The signed distance function of the models' projections, the same size as the whole frame.
+    * @return Whether the frame was classified.
+    */
+    virtual bool ClassifyFrame(boost::shared_ptr<sv::Frame> frame, const cv::Mat &sdf);
+
     /**
      * A function for training the classifier of choice. Will accept data in the form returned by the TrainData class.
      * @param[in] training_data The training data to be used for training.
@@ -108,6 +116,13 @@ namespace ttrk{
 
   protected:
 
+    /**
+    * Get the maximum response of a bank of Gabor filters at 16 orientations, a texture feature for the random forests.
+    * @param[in] bgr The 8 bit BGR image.
+    * @param[out] gabor The CV_32FC1 response.
+    */
+    void GetGabor(const cv::Mat &bgr, cv::Mat &gabor) const;
+
     Colour colourspace_; /**< Colourspace settings for the classifier. */
 
     size_t var_mask_; /**< Bitmask for specifying which Colorspaces/features to use. */
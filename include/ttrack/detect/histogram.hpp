@@ -7,6 +7,8 @@ namespace ttrk{
 
   const int histogram_channel_num = 3;
   const int histogram_bin_num = 32;
+  const int histogram_bin_shift = 3; /**< An 8 bit value's bin is value >> histogram_bin_shift. */
+  static_assert((256 >> histogram_bin_shift) == histogram_bin_num, "Error, the histogram bins must evenly divide the 8 bit range.");
 
   template<int HISTOGRAM_CHANNEL_NUM, int HISTOGRAM_BIN_NUM>
   struct InternalHistogram {
@@ -35,6 +37,9 @@ namespace ttrk{
   *
   * The class for handling classification with a histogram. Can handle large numbers of classes in principal but for now just
   * does 3 classes. Will extend if have time.
+  *
+  * Frames are classified through a lookup table from each quantized BGR colour to the probability of each class, the product of the
+  * channel histograms. It is rebuilt whenever the histograms are (re)loaded, so classifying a pixel is one gather from the table.
   */
   class Histogram : public BaseClassifier {
 
@@ -42,8 +47,21 @@ namespace ttrk{
 
     Histogram();
 
+    /**
+    * Classify every pixel of a frame.
+    * @param[in] frame The frame to classify.
+    * @return Whether the frame was classified.
+    */
     virtual bool ClassifyFrame(boost::shared_ptr<sv::Frame> frame);
 
+    /**
+    * Classify the pixels of a frame which are near a model, leaving the rest of the classification map zero.
+    * @param[in] frame The frame to classify.
+    * @param[in] sdf The signed distance function of the models' projections, the same size as the whole frame. If it is empty every pixel is classified.
+    * @return Whether the frame was classified.
+    */
+    virtual bool ClassifyFrame(boost::shared_ptr<sv::Frame> frame, const cv::Mat &sdf);
+
     /**
     * A function for training the classifier of choice. Will accept data in the form returned by the TrainData class.
     * @param[in] training_data The training data to be used for training.
@@ -91,6 +109,22 @@ namespace ttrk{
 
   protected:
 
+    /**
+    * Bake the histograms into the lookup table. Called whenever they change.
+    */
+    void BuildLookupTable();
+
+    /**
+    * Get the lookup table index of a colour.
+    * @param[in] b The blue value.
+    * @param[in] g The green value.
+    * @param[in] r The red value.
+    * @return The index of the colour's first class probability, divided by the number of classes.
+    */
+    static size_t GetLookupTableIndex(const unsigned char b, const unsigned char g, const unsigned char r) {
+      return ((size_t)(b >> histogram_bin_shift) * histogram_bin_num + (g >> histogram_bin_shift)) * histogram_bin_num + (r >> histogram_bin_shift);
+    }
+
     int num_classes_;
 
     float bin_divider_;
@@ -101,6 +135,9 @@ namespace ttrk{
     InternalHistogram<histogram_channel_num, histogram_bin_num> foreground_shaft_;
     InternalHistogram<histogram_channel_num, histogram_bin_num> background_;
 
+    std::vector<float> lookup_table_; /**< num_classes_ probabilities for each quantized colour, indexed by GetLookupTableIndex. Empty until the histograms are loaded. */
+    std::vector<size_t> row_indices_; /**< The lookup table index of each pixel in the row being classified. */
+
   };
 }
 
@@ -18,7 +18,15 @@ namespace ttrk{
 
     MultiClassRandomForest(const size_t num_classes) : num_classes_(num_classes) {}
 
-    virtual bool ClassifyFrame(boost::shared_ptr<sv::Frame> frame) override;
+    using RandomForest::PredictProb;
+
+    /**
+    * Classify the pixels of a frame which are near a model.
+    * @param[in] frame The frame to classify.
+    * @param[in] sdf_image The signed distance function of the models' projections, the same size as the whole frame.
+    * @return Whether the frame was classified.
+    */
+    virtual bool ClassifyFrame(boost::shared_ptr<sv::Frame> frame, const cv::Mat &sdf_image) override;
 
     /**
     * Check if the loaded classifier supports classifying multiple classes or if it just does binary classification.
@@ -28,6 +36,14 @@ namespace ttrk{
 
   protected:
 
+    /**
+    * Get the fraction of trees voting for each class.
+    * @param[in] sample The features of a pixel.
+    * @param[out] probabilities The probability of each class.
+    * @param[in] size The number of classes.
+    */
+    void PredictProb(const cv::Mat &sample, float *probabilities, const int size);
+
     size_t num_classes_;
 
   };
@@ -24,6 +24,21 @@ namespace ttrk{
      */
     virtual void TrainClassifier(boost::shared_ptr<cv::Mat> training_data, boost::shared_ptr<cv::Mat> labels, boost::shared_ptr<std::string> root_dir);
 
+    /**
+    * Train the forest on per pixel features.
+    * @param[in] training_data One row of features per sample.
+    * @param[in] training_labels The class label of each sample.
+    */
+    virtual void TrainClassifier(const cv::Mat &training_data, const cv::Mat &training_labels);
+
+    /**
+    * Classify the pixels of a frame which are near a model, leaving the rest of the classification map zero.
+    * @param[in] frame The frame to classify.
+    * @param[in] sdf The signed distance function of the models' projections, the same size as the whole frame.
+    * @return Whether the frame was classified.
+    */
+    virtual bool ClassifyFrame(boost::shared_ptr<sv::Frame> frame, const cv::Mat &sdf) override;
+
     /**
      * A discrete prediction on the class a pixel belongs to.
      * @param[in] pixel The pixel from the NDImage.
@@ -63,6 +78,13 @@ namespace ttrk{
 
   protected:
 
+    /**
+    * Get the fraction of trees voting for the background and foreground.
+    * @param[in] sample The features of a pixel.
+    * @param[out] probabilities The background and foreground probabilities.
+    */
+    void PredictProb(const cv::Mat &sample, float *probabilities);
+
     CvRTrees forest_; /**< The internal representation of a random forest. */
 
   };
@@ -15,20 +15,28 @@ namespace ttrk{
 
     Descriptor() {};
     
-    Descriptor(const cv::Vec3f pt, const cv::Vec3f normal, const cv::Mat &descriptor);
+    Descriptor(const cv::Vec3f pt, const cv::Vec3f normal, const cv::Mat &descriptor, const size_t times_matched = 0, const size_t total_num_attempts = 0);
     
     cv::Mat GetDescriptor() { return descriptor_; }
     cv::Mat GetDescriptor() const { return descriptor_.clone(); }
 
     double GetPercentageHits() { if (total_num_attempts_ > 0) return (double)times_matched_ / total_num_attempts_; else return 0; }
 
+    cv::Vec3f GetModelPoint() const { return cv::Vec3f(coordinate_[0], coordinate_[1], coordinate_[2]); }
+    cv::Vec3f GetModelNormal() const { return cv::Vec3f(normal_[0], normal_[1], normal_[2]); }
+
     size_t GetTimesMatched() const { return times_matched_; }
     size_t GetTotalNumberOfAttempts() const { return total_num_attempts_; }
 
     void IncrementNumberOfMatches() { times_matched_++; }
     void IncrementTotalNumberOfAttempts() { total_num_attempts_++; }
     
-    bool ShouldUseThisDescriptor(Pose &pose) const;
+    /**
+    * Check if the descriptor's surface faces the camera at a pose, i.e. it could be seen.
+    * @param[in] pose The pose of the model.
+    * @return True if the point is in front of the camera and its normal points towards it.
+    */
+    bool ShouldUseThisDescriptor(const Pose &pose) const;
 
     ci::Vec3f ciGetPointInEyeSpace(Pose &pose) const;
     cv::Vec3f cvGetPointInEyeSpace(Pose &pose) const { auto i = ciGetPointInEyeSpace(pose); return cv::Vec3f(i[0], i[1], i[2]); }
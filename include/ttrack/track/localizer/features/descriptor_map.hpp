@@ -0,0 +1,81 @@
+#ifndef __DESCRIPTOR_MAP_HPP__
+#define __DESCRIPTOR_MAP_HPP__
+
+#include <vector>
+
+#include "descriptor.hpp"
+#include "../../../utils/camera.hpp"
+
+namespace ttrk {
+
+  /**
+  * @class DescriptorMap
+  * @brief The feature descriptors seen on a model's surface, stored in model coordinates so they can be matched at any pose.
+  *
+  * The map grows as new surface points are registered and is bounded in size, evicting the descriptors that matched least often. Given a
+  * predicted pose the descriptors on surfaces facing the camera are projected into the frame and only matched against keypoints near their
+  * projection, so a model can be re-registered without a previous frame to match against.
+  */
+  class DescriptorMap {
+
+  public:
+
+    /**
+    * Create an empty map.
+    * @param[in] max_size The most descriptors to keep.
+    */
+    explicit DescriptorMap(const size_t max_size = 500);
+
+    /**
+    * Add a descriptor, evicting the least useful one if the map is full.
+    * @param[in] descriptor The descriptor with its model space point and normal.
+    */
+    void Add(const Descriptor &descriptor);
+
+    /**
+    * Match the descriptors facing the camera to the nearest keypoint descriptor within a radius of their projection. Every descriptor that
+    * is tried counts as an attempt, RecordMatch counts the ones that were used.
+    * @param[in] pose The predicted pose of the model.
+    * @param[in] camera The camera the keypoints were found in.
+    * @param[in] keypoints The keypoints in the frame.
+    * @param[in] descriptors The keypoint descriptors, one row per keypoint, of the same type as the map's.
+    * @param[in] radius The largest distance in pixels between a projection and its keypoint.
+    * @param[in] norm_type The descriptor distance.
+    * @param[out] matches The matches, queryIdx indexes the map and trainIdx the keypoints.
+    * @param[out] projections The projection of each matched map descriptor.
+    */
+    void Match(const Pose &pose, const boost::shared_ptr<MonocularCamera> camera, const std::vector<cv::KeyPoint> &keypoints, const cv::Mat &descriptors, const float radius, const int norm_type, std::vector<cv::DMatch> &matches, std::vector<cv::Point2f> &projections);
+
+    /**
+    * Record that a match from Match was used.
+    * @param[in] index The map index of the descriptor.
+    */
+    void RecordMatch(const size_t index) { descriptors_[index].IncrementNumberOfMatches(); }
+
+    /**
+    * Get a descriptor.
+    * @param[in] index The map index.
+    * @return The descriptor.
+    */
+    const Descriptor &GetDescriptor(const size_t index) const { return descriptors_[index]; }
+
+    /**
+    * Get all the descriptors, for saving the map.
+    * @return The descriptors.
+    */
+    const std::vector<Descriptor> &GetDescriptors() const { return descriptors_; }
+
+    size_t Size() const { return descriptors_.size(); }
+    bool Empty() const { return descriptors_.empty(); }
+    size_t GetMaxSize() const { return max_size_; }
+
+  protected:
+
+    std::vector<Descriptor> descriptors_; /**< The descriptors. */
+    size_t max_size_; /**< The most descriptors to keep. */
+
+  };
+
+}
+
+#endif
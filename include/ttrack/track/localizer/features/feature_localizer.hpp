@@ -7,6 +7,8 @@
 #include "../../model/pose.hpp"
 #include "../../model/model.hpp"
 #include "../../../utils/camera.hpp"
+#include "../../../utils/frame_pyramid.hpp"
+#include "point_registration_solver.hpp"
 
 namespace ttrk {
 
@@ -25,22 +27,54 @@ namespace ttrk {
 
     std::vector<float> GetDerivativesForPoints(boost::shared_ptr<Model> current_model, const Pose &pose);
 
+    /**
+    * Build the robust Gauss-Newton system for registering the model's tracked points at a pose, from the same points as GetDerivativesForPoints.
+    * @param[in] current_model The model.
+    * @param[in] pose The pose to linearise about.
+    * @param[out] jtj The weighted \f$ \mathbf{J}^T\mathbf{J} \f$ of the point projections.
+    * @param[out] jtr The weighted \f$ \mathbf{J}^T\mathbf{r} \f$, half the gradient GetDerivativesForPoints returns when no point is downweighted.
+    * @return The number of points in the system.
+    */
+    size_t GetPointRegistrationSystem(boost::shared_ptr<Model> current_model, const Pose &pose, cv::Matx<float, 7, 7> &jtj, cv::Matx<float, 7, 1> &jtr);
+
+    /**
+    * Set the robust loss used by GetPointRegistrationSystem.
+    * @param[in] loss The loss.
+    * @param[in] loss_scale The reprojection distance in pixels where the loss stops being quadratic.
+    */
+    void SetPointRegistrationLoss(const PointRegistrationSolver::RobustLoss loss, const float loss_scale) { point_solver_ = PointRegistrationSolver(loss, loss_scale); }
+
     std::vector<float> GetArticulatedDerivativesForPoints(boost::shared_ptr<Model> current_model, const cv::Mat &articulated_index_image);
 
     std::vector<float> GetArticulatedPointDerivative(const cv::Vec3f &world_previous, const cv::Vec2f &image_previous, const cv::Vec2f &image_new, const boost::shared_ptr<Model> current_model, const size_t articulated_component_idx);
 
     void UpdatePointsOnArticulatedModelAfterDerivatives(boost::shared_ptr<Model> current_model, const cv::Mat &articulated_index_image);
 
+    /**
+    * Set the grayscale/pyramid cache of the frame being tracked so every model reuses it rather than converting the frame itself.
+    * @param[in] pyramid The cache or null to convert the frame in each call.
+    */
+    void SetFramePyramid(boost::shared_ptr<sv::FramePyramid> pyramid) { frame_pyramid_ = pyramid; }
+
     void UpdateFrameCount(){
       frame_count_++;
     }
 
-    void SetFrontIntersectionImage(cv::Mat &im, boost::shared_ptr<Model> current_model) {
-
-
-      current_model->mps.front_intersection_image_ = im.clone();
+    /**
+    * Set the model's front intersection image for the current render and build the integral image of the pixels where the model is
+    * hidden behind something else (see Localizer::occlusion_image), so IsOccluded can test any window in constant time.
+    * @param[in] im The front intersection image.
+    * @param[in] current_model The model it was rendered from.
+    */
+    void SetFrontIntersectionImage(cv::Mat &im, boost::shared_ptr<Model> current_model);
 
-    }
+    /**
+    * Check if any pixel in a window is occluded, i.e. another surface is in front of the model there.
+    * @param[in] current_model The model, whose front intersection image has been set.
+    * @param[in] window The window in image coordinates. It is clipped to the image.
+    * @return True if at least one pixel in the window is occluded.
+    */
+    static bool IsOccluded(const boost::shared_ptr<Model> current_model, const cv::Rect &window);
 
     std::vector<float> GetIntensityDerivative(const cv::Vec3f &world_previous, const float &dx, const float &dy, const Pose &pose);
 
@@ -67,8 +101,28 @@ namespace ttrk {
     
     std::vector<cv::Point2f> GetPointsOnPreviousImage(boost::shared_ptr<Model> current_model);
 
+    /**
+    * Get the cache set with SetFramePyramid if it was built from the frame being tracked.
+    * @param[in] current_frame The frame passed to the tracker.
+    * @return The cache or null if there is none for this frame.
+    */
+    boost::shared_ptr<sv::FramePyramid> GetFramePyramid(const cv::Mat &current_frame) const;
+
+    /**
+    * Get the grayscale version of the frame being tracked, from the cache if there is one. The cached image is shared with every model so it
+    * must not be written to.
+    * @param[in] current_frame The BGR or grayscale frame passed to the tracker.
+    * @return The grayscale frame.
+    */
+    cv::Mat GetGrayFrame(const cv::Mat &current_frame) const;
+
     boost::shared_ptr<MonocularCamera> camera_;
 
+    boost::shared_ptr<sv::FramePyramid> frame_pyramid_; /**< The cache for the frame being tracked. */
+
+    PointRegistrationSolver point_solver_; /**< Holds the point registration system between iterations so its storage is reused. */
+    std::vector<ci::Vec3f> point_jacobian_; /**< The pose jacobian of the point being added to the system. */
+
     float current_error_;
 
     size_t frame_count_;
@@ -0,0 +1,55 @@
+#ifndef __FEATURE_MANAGER_HPP__
+#define __FEATURE_MANAGER_HPP__
+
+#include <vector>
+
+#include "../../../headers.hpp"
+#include "../../model/model.hpp"
+
+namespace ttrk {
+
+  /**
+  * @class FeatureManager
+  * @brief Decides where a feature tracker needs new points, so the model is covered without detecting over the whole frame.
+  *
+  * The image is divided into square cells. A cell that contains pixels of a component but none of that component's tracked points is
+  * empty, and when too many of a component's cells are empty new points are detected only in the empty cells. Each top up is bounded by
+  * the bounding box of the empty cells and a fixed number of new points, so detection costs nothing while the coverage holds and a
+  * bounded amount when it doesn't.
+  */
+  class FeatureManager {
+
+  public:
+
+    /**
+    * Create a manager.
+    * @param[in] cell_size The side of each cell in pixels.
+    * @param[in] min_coverage The fraction of a component's cells that must hold a tracked point before no top up is needed.
+    * @param[in] max_new_points_per_frame The most points a top up should add across all components.
+    */
+    FeatureManager(const int cell_size = 40, const float min_coverage = 0.5f, const size_t max_new_points_per_frame = 20);
+
+    /**
+    * Get the pixels to detect new points in for a component.
+    * @param[in] mps The model's point set, after tracking. points_test[0] holds the current point positions.
+    * @param[in] component_mask The pixels of the component that points can be detected on.
+    * @param[in] component_idx The component, matched against TrackedPoint::component_idx, or -1 to count every point.
+    * @param[out] top_up_mask The component pixels in the empty cells, cropped to roi.
+    * @param[out] roi The bounding box of the empty cells.
+    * @return True if the component's coverage is too low and there is somewhere to detect.
+    */
+    bool GetTopUpMask(const ModelPointSet &mps, const cv::Mat &component_mask, const int component_idx, cv::Mat &top_up_mask, cv::Rect &roi) const;
+
+    size_t GetMaxNewPointsPerFrame() const { return max_new_points_per_frame_; }
+
+  protected:
+
+    int cell_size_; /**< The side of each cell in pixels. */
+    float min_coverage_; /**< The fraction of cells that must hold a point. */
+    size_t max_new_points_per_frame_; /**< The most points to add in a frame. */
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef __KEYPOINT_GRID_HPP__
+#define __KEYPOINT_GRID_HPP__
+
+#include <vector>
+#include <cstring>
+#include <boost/cstdint.hpp>
+#include <opencv2/features2d/features2d.hpp>
+
+namespace ttrk {
+
+  /**
+  * Count the set bits in a 64 bit word.
+  * @param[in] x The word.
+  * @return The number of set bits.
+  */
+  inline int PopCount(boost::uint64_t x){
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    //no hardware popcount is assumed so this also runs on CPUs without the POPCNT instruction
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+  }
+
+  /**
+  * Get the Hamming distance between two packed binary descriptors, 64 bits at a time.
+  * @param[in] a The first descriptor.
+  * @param[in] b The second descriptor.
+  * @param[in] length The length of each descriptor in bytes.
+  * @return The number of bits that differ.
+  */
+  inline int HammingDistance(const unsigned char *a, const unsigned char *b, const int length){
+
+    int distance = 0;
+    int i = 0;
+    for (; i + 8 <= length; i += 8){
+      boost::uint64_t wa, wb;
+      std::memcpy(&wa, a + i, 8);
+      std::memcpy(&wb, b + i, 8);
+      distance += PopCount(wa ^ wb);
+    }
+    for (; i < length; ++i) distance += PopCount((boost::uint64_t)(a[i] ^ b[i]));
+
+    return distance;
+
+  }
+
+  /**
+  * @class KeypointGrid
+  * @brief Buckets keypoints into square cells so descriptor matching only compares keypoints that are close in the image.
+  *
+  * With the cell size equal to the matching radius a query only has to look at the 3x3 cells around it, so matching a frame against
+  * the last one costs roughly (keypoints x keypoints per neighbourhood) descriptor distances instead of (keypoints x keypoints).
+  */
+  class KeypointGrid {
+
+  public:
+
+    /**
+    * Bucket the keypoints.
+    * @param[in] keypoints The keypoints. Only their positions are kept.
+    * @param[in] cell_size The side of each cell in pixels.
+    */
+    KeypointGrid(const std::vector<cv::KeyPoint> &keypoints, const float cell_size);
+
+    /**
+    * Get the keypoints within a radius of a point.
+    * @param[in] point The point.
+    * @param[in] radius The radius in pixels.
+    * @param[out] indexes The indexes of the keypoints in the vector the grid was built from.
+    */
+    void GetKeypointsNear(const cv::Point2f &point, const float radius, std::vector<int> &indexes) const;
+
+    /**
+    * Find the nearest descriptor among the grid's keypoints for each query keypoint, only searching the keypoints within a radius. This
+    * is exact within the radius, queries with no keypoints in range get no match.
+    * @param[in] query_keypoints The query keypoints.
+    * @param[in] query_descriptors The query descriptors, one row per query keypoint.
+    * @param[in] train_descriptors The descriptors of the grid's keypoints, one row per keypoint.
+    * @param[in] radius The largest distance in pixels between a query and its match.
+    * @param[in] norm_type The descriptor distance, cv::NORM_L2 for SIFT or cv::NORM_HAMMING for binary descriptors.
+    * @param[out] matches The matches with queryIdx/trainIdx indexing the query/grid keypoints.
+    */
+    void Match(const std::vector<cv::KeyPoint> &query_keypoints, const cv::Mat &query_descriptors, const cv::Mat &train_descriptors, const float radius, const int norm_type, std::vector<cv::DMatch> &matches) const;
+
+  protected:
+
+    void GetCell(const cv::Point2f &point, int &cell_x, int &cell_y) const;
+
+    std::vector<cv::Point2f> points_; /**< The keypoint positions. */
+    std::vector< std::vector<int> > cells_; /**< The indexes of the keypoints in each cell, row major. */
+    cv::Point2f origin_; /**< The top left corner of the grid. */
+    float cell_size_; /**< The side of each cell in pixels. */
+    int grid_cols_; /**< The number of cells across. */
+    int grid_rows_; /**< The number of cells down. */
+
+  };
+
+}
+
+#endif
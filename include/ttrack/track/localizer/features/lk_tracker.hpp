@@ -10,6 +10,8 @@
 #include "../../model/model.hpp"
 #include "../../../constants.hpp"
 #include "feature_localizer.hpp"
+#include "feature_manager.hpp"
+#include "pyramidal_lk.hpp"
 
 namespace ttrk{
 
@@ -21,17 +23,45 @@ namespace ttrk{
 
     virtual void TrackLocalPoints(cv::Mat &current_frame, boost::shared_ptr<Model> current_model);
 
+    /**
+    * Track the points of an articulated model, topping up each component's points where its coverage has dropped.
+    * @param[in] current_frame The frame to track the points into.
+    * @param[in] current_model The model.
+    * @param[in] component_image The component index of each pixel.
+    */
+    virtual void TrackLocalPoints(cv::Mat &current_frame, boost::shared_ptr<Model> current_model, const cv::Mat &component_image);
+
     virtual void InitializeTracker(cv::Mat &current_frame, const boost::shared_ptr<Model> current_model);
 
     virtual void InitializeTracker(cv::Mat &current_frame, const boost::shared_ptr<Model> current_model, const cv::Mat &component_image);
 
   protected:
 
+    /**
+    * Track the points from the previous frame, dropping the ones LK loses or whose backward track doesn't return to where they started.
+    * @param[in] current_frame The frame to track the points into.
+    * @param[in] current_model The model.
+    * @return True if the model still has enough points to be tracked, false if it needs reinitialising.
+    */
+    bool TrackPoints(cv::Mat &current_frame, boost::shared_ptr<Model> current_model);
+
+    /**
+    * Detect new points in the parts of the model the feature manager finds uncovered.
+    * @param[in] current_model The model, after TrackPoints.
+    * @param[in] component_image The component index of each pixel, or empty for a rigid model.
+    */
+    void TopUpPoints(boost::shared_ptr<Model> current_model, const cv::Mat &component_image);
+
     cv::Size win_size_;
     cv::TermCriteria term_crit_;
     
     float current_error_;
 
+    FeatureManager feature_manager_; /**< Decides where new points are needed. */
+    float max_forward_backward_error_; /**< The furthest in pixels a point can be from its start after tracking forward then back. */
+
+    PyramidalLK lk_; /**< Tracks the points forward and back on the cached pyramids. */
+
   };
 
   class ArticulatedLKTracker : public LKTracker {
@@ -0,0 +1,106 @@
+#ifndef __POINT_REGISTRATION_SOLVER_HPP__
+#define __POINT_REGISTRATION_SOLVER_HPP__
+
+#include <vector>
+#include <stdexcept>
+#include <cinder/Vector.h>
+#include <opencv2/core/core.hpp>
+
+namespace ttrk {
+
+  /**
+  * @class PointRegistrationSolver
+  * @brief Builds the Gauss-Newton system for registering a model's tracked points to where they were found in the frame.
+  *
+  * Each point adds a 2 x DOF block to the jacobian of the projections and a residual, its projection minus where it was found. Both are
+  * kept in buffers that are reused from one iteration to the next. Each point is weighted by a robust loss on its reprojection distance,
+  * so points that LK or descriptor matching put in the wrong place pull less (Huber) or not at all (Tukey). GetSystem returns
+  * \f$ \mathbf{J}^T\mathbf{W}\mathbf{J} \f$ and \f$ \mathbf{J}^T\mathbf{W}\mathbf{r} \f$ in the form the region terms accumulate their hessian
+  * approximation and jacobian, so the two can be summed into one step.
+  */
+  class PointRegistrationSolver {
+
+  public:
+
+    enum RobustLoss { LEAST_SQUARES, HUBER, TUKEY };
+
+    /**
+    * Create a solver.
+    * @param[in] loss The robust loss on each point's reprojection distance.
+    * @param[in] loss_scale The distance in pixels beyond which a Huber weighted point is downweighted or a Tukey weighted point is ignored.
+    */
+    PointRegistrationSolver(const RobustLoss loss = HUBER, const float loss_scale = 5.0f);
+
+    /**
+    * Clear the points to build a new system, keeping the storage.
+    * @param[in] fx The camera's horizontal focal length.
+    * @param[in] fy The camera's vertical focal length.
+    * @param[in] number_of_dofs The number of degrees of freedom in each point's jacobian.
+    */
+    void Reset(const float fx, const float fy, const size_t number_of_dofs);
+
+    /**
+    * Add a point to the system.
+    * @param[in] point_in_camera_coords The point transformed by the current pose.
+    * @param[in] projection The projection of the point.
+    * @param[in] found_image_point Where the point was found in the frame.
+    * @param[in] point_jacobian The derivative of the point in camera coordinates w.r.t each degree of freedom, as from Pose::ComputeJacobian.
+    */
+    void AddPoint(const cv::Vec3f &point_in_camera_coords, const cv::Vec2f &projection, const cv::Vec2f &found_image_point, const std::vector<ci::Vec3f> &point_jacobian);
+
+    /**
+    * Get the weighted normal equations of the points added since the last Reset.
+    * @param[out] jtj \f$ \mathbf{J}^T\mathbf{W}\mathbf{J} \f$.
+    * @param[out] jtr \f$ \mathbf{J}^T\mathbf{W}\mathbf{r} \f$, the gradient of the robust error.
+    */
+    template<int DOFS>
+    void GetSystem(cv::Matx<float, DOFS, DOFS> &jtj, cv::Matx<float, DOFS, 1> &jtr) const {
+
+      if (DOFS != (int)number_of_dofs_) throw std::runtime_error("Error, the point registration system has a different number of degrees of freedom.");
+      GetSystem(jtj.val, jtr.val);
+
+    }
+
+    /**
+    * Get the robust error of the points added since the last Reset.
+    * @return The sum of each point's loss.
+    */
+    float GetError() const { return error_; }
+
+    size_t GetNumberOfPoints() const { return number_of_points_; }
+
+  protected:
+
+    /**
+    * Accumulate the normal equations into row-major storage.
+    * @param[out] jtj number_of_dofs_ x number_of_dofs_ values.
+    * @param[out] jtr number_of_dofs_ values.
+    */
+    void GetSystem(float *jtj, float *jtr) const;
+
+    /**
+    * Get the loss and IRLS weight of a reprojection distance.
+    * @param[in] distance The distance in pixels.
+    * @param[out] weight The weight to give the point's rows.
+    * @return The loss.
+    */
+    float GetLoss(const float distance, float &weight) const;
+
+    RobustLoss loss_; /**< The robust loss. */
+    float loss_scale_; /**< The scale of the robust loss in pixels. */
+
+    float fx_; /**< The horizontal focal length. */
+    float fy_; /**< The vertical focal length. */
+    size_t number_of_dofs_; /**< The columns of the jacobian. */
+    size_t number_of_points_; /**< The points added since the last Reset. */
+
+    std::vector<float> jacobian_; /**< The 2N x DOF jacobian, row-major, only the first number_of_points_ blocks are in use. */
+    std::vector<float> residuals_; /**< The 2N residuals. */
+    std::vector<float> weights_; /**< The N point weights. */
+    float error_; /**< The summed loss. */
+
+  };
+
+}
+
+#endif
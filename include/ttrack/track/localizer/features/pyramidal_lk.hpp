@@ -0,0 +1,90 @@
+#ifndef __PYRAMIDAL_LK_HPP__
+#define __PYRAMIDAL_LK_HPP__
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+namespace ttrk {
+
+  /**
+  * @class PyramidalLK
+  * @brief A pyramidal Lucas-Kanade tracker for the few dozen points a model carries, which tracks each point forward and back in one call.
+  *
+  * It works on the interleaved image/gradient pyramids from cv::buildOpticalFlowPyramid, so it can share the pyramids cached by
+  * sv::FramePyramid. Unlike cv::calcOpticalFlowPyrLK there is no per call setup beyond one set of patch buffers shared by every point,
+  * and the patches are bilinearly sampled and compared a row at a time with SSE2 where it is available. Each point's residual is the mean
+  * absolute intensity difference across its window at the finest level.
+  */
+  class PyramidalLK {
+
+  public:
+
+    /**
+    * Create a tracker.
+    * @param[in] win_size The window around each point. The pyramids must have been built for at least this size.
+    * @param[in] max_level The highest pyramid level to start from, if the pyramids have it.
+    * @param[in] criteria When to stop iterating at each level, as for cv::calcOpticalFlowPyrLK.
+    * @param[in] min_eigen_threshold The smallest minimum eigenvalue of a window's gradient matrix that can be tracked, in the units of cv::calcOpticalFlowPyrLK.
+    */
+    PyramidalLK(const cv::Size win_size = cv::Size(31, 31), const int max_level = 3, const cv::TermCriteria criteria = cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 0.03), const float min_eigen_threshold = 0.001f);
+
+    /**
+    * Track points from the previous frame into the current one and then back again.
+    * @param[in] previous_pyramid The previous frame's pyramid with gradients.
+    * @param[in] current_pyramid The current frame's pyramid with gradients.
+    * @param[in] previous_points The points in the previous frame.
+    * @param[out] current_points The points in the current frame.
+    * @param[out] status 1 for each point tracked both ways, 0 for each point lost in either direction.
+    * @param[out] forward_backward_error The distance between each point and where it tracks back to, or FLT_MAX for a lost point.
+    * @param[out] residuals The forward residual of each point, or FLT_MAX for a lost point.
+    */
+    void Track(const std::vector<cv::Mat> &previous_pyramid, const std::vector<cv::Mat> &current_pyramid, const std::vector<cv::Point2f> &previous_points, std::vector<cv::Point2f> &current_points, std::vector<unsigned char> &status, std::vector<float> &forward_backward_error, std::vector<float> &residuals) const;
+
+    /**
+    * Track points from the previous frame into the current one.
+    * @param[in] previous_pyramid The previous frame's pyramid with gradients.
+    * @param[in] current_pyramid The current frame's pyramid with gradients.
+    * @param[in] previous_points The points in the previous frame.
+    * @param[out] current_points The points in the current frame.
+    * @param[out] status 1 for each point tracked, 0 for each point lost.
+    * @param[out] residuals The residual of each point, or FLT_MAX for a lost point.
+    */
+    void TrackForward(const std::vector<cv::Mat> &previous_pyramid, const std::vector<cv::Mat> &current_pyramid, const std::vector<cv::Point2f> &previous_points, std::vector<cv::Point2f> &current_points, std::vector<unsigned char> &status, std::vector<float> &residuals) const;
+
+    cv::Size GetWindowSize() const { return win_size_; }
+    int GetMaxLevel() const { return max_level_; }
+
+  protected:
+
+    /**
+    * Track one point through the pyramid levels.
+    * @param[in] from_pyramid The pyramid the point is in.
+    * @param[in] to_pyramid The pyramid to track the point into.
+    * @param[in] levels The highest level to start from.
+    * @param[in] from The point.
+    * @param[out] to The tracked point.
+    * @param[out] residual The mean absolute difference between the windows at the finest level.
+    * @param[in,out] patch Space for the template window and its gradients and one sampled row, reused between points.
+    * @return True if the point was tracked, false if its window left the image or had too little texture.
+    */
+    bool TrackPoint(const std::vector<cv::Mat> &from_pyramid, const std::vector<cv::Mat> &to_pyramid, const int levels, const cv::Point2f &from, cv::Point2f &to, float &residual, std::vector<float> &patch) const;
+
+    /**
+    * Check the pyramids have gradients and get the highest level both have.
+    * @param[in] previous_pyramid The previous frame's pyramid.
+    * @param[in] current_pyramid The current frame's pyramid.
+    * @return The highest level to start from.
+    */
+    int GetLevels(const std::vector<cv::Mat> &previous_pyramid, const std::vector<cv::Mat> &current_pyramid) const;
+
+    cv::Size win_size_; /**< The window around each point. */
+    int max_level_; /**< The highest pyramid level to start from. */
+    int max_iterations_; /**< The most iterations at each level. */
+    float epsilon_squared_; /**< Iterating stops when an update moves the point less than this squared distance. */
+    float min_eigen_threshold_; /**< The smallest trackable minimum eigenvalue per pixel, in image gradient units. */
+
+  };
+
+}
+
+#endif
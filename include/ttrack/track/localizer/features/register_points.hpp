@@ -1,6 +1,8 @@
 #ifndef __REGISTER_POINTS_HPP__
 #define __REGISTER_POINTS_HPP__
 
+#include <algorithm>
+
 #include "../../../headers.hpp"
 #include "../../model/pose.hpp"
 #include "../../../utils/camera.hpp"
@@ -28,10 +30,70 @@ namespace ttrk {
 
     void ComputeRootSiftFeatureFromSiftFeatures(cv::Mat &sift_descriptors) const;
 
+    /**
+    * Detect SIFT keypoints in a frame and compute their RootSIFT descriptors.
+    * @param[in] gray The grayscale frame.
+    * @param[in] mask The pixels to detect keypoints in.
+    * @param[out] keypoints The keypoints.
+    * @param[out] descriptors The descriptors, one row per keypoint.
+    */
+    virtual void DescribeFrame(const cv::Mat &gray, const cv::Mat &mask, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors) const;
+
+    /**
+    * Get the distance used to match the descriptors computed by DescribeFrame.
+    * @return The OpenCV norm type.
+    */
+    virtual int GetDescriptorNorm() const { return cv::NORM_L2; }
+
+    /**
+    * Get the largest descriptor distance a match can have to be used.
+    * @param[in] min_distance The smallest distance of all the matches in the frame.
+    * @return The distance threshold.
+    */
+    virtual double GetMatchThreshold(const double min_distance) const { return std::max(2 * min_distance, 0.1); }
+
+    /**
+    * Get the largest distance in pixels a keypoint can move between frames and still be matched.
+    * @return The distance.
+    */
+    virtual float GetMaxKeypointMotion() const { return 40.0f; }
+
     Pose pose_;
 
   };
 
+  /**
+  * @class ORBRegistration
+  * @brief Point registration with ORB keypoints and binary descriptors in place of SIFT.
+  *
+  * The descriptors are matched by Hamming distance with a popcount over the packed bits, which is a fraction of the cost of SIFT, so
+  * the motion gate can be wider to recover from fast motion.
+  */
+  class ORBRegistration : public PointRegistration {
+
+  public:
+
+    /**
+    * Create the tracker.
+    * @param[in] camera The camera the frames come from.
+    * @param[in] max_features The most keypoints to detect in a frame.
+    */
+    ORBRegistration(boost::shared_ptr<MonocularCamera> camera, const int max_features = 500);
+
+  protected:
+
+    virtual void DescribeFrame(const cv::Mat &gray, const cv::Mat &mask, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors) const;
+
+    virtual int GetDescriptorNorm() const { return cv::NORM_HAMMING; }
+
+    virtual double GetMatchThreshold(const double min_distance) const;
+
+    virtual float GetMaxKeypointMotion() const { return 80.0f; }
+
+    int max_features_; /**< The most keypoints to detect in a frame. */
+
+  };
+
 
 }
 
@@ -0,0 +1,32 @@
+#ifndef __INTERSECTION_IMAGE_HPP__
+#define __INTERSECTION_IMAGE_HPP__
+
+#include "../../../headers.hpp"
+
+namespace ttrk {
+
+  /**
+  * Unproject a row of rendered depth to the 3D points on the front and back surfaces of the model. Uses SSE2 when it is available and falls
+  * back to scalar code for the last few pixels of the row and on other platforms.
+  * @param[in] front_depth The front depth row, 4 floats per pixel (as read back from the framebuffer) with the depth in the first.
+  * @param[in] back_depth The back depth row, laid out the same way.
+  * @param[in] rays The unprojected image plane row, 2 floats (x/z, y/z) per pixel.
+  * @param[out] front_intersection The front intersection points, 3 floats per pixel, GL_FAR where the pixel does not see the model.
+  * @param[out] back_intersection The back intersection points, laid out the same way.
+  * @param[in] width The number of pixels in the row.
+  */
+  void ComputeIntersectionRow(const float *front_depth, const float *back_depth, const float *rays, float *front_intersection, float *back_intersection, const int width);
+
+  /**
+  * Unproject rendered front and back depth images to intersection images in a single pass.
+  * @param[in] front_depth The front depth image, CV_32FC4.
+  * @param[in] back_depth The back depth image, CV_32FC4.
+  * @param[in] unprojected_image_plane The camera's unprojected image plane, CV_32FC2 and the same size as the depth images.
+  * @param[out] front_intersection_image The front intersection image, CV_32FC3. Not reallocated if it is already the right size and type.
+  * @param[out] back_intersection_image The back intersection image, CV_32FC3. Not reallocated if it is already the right size and type.
+  */
+  void ComputeIntersectionImagesFromDepth(const cv::Mat &front_depth, const cv::Mat &back_depth, const cv::Mat &unprojected_image_plane, cv::Mat &front_intersection_image, cv::Mat &back_intersection_image);
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef __LEVEL_SET_FUNCTIONS_HPP__
+#define __LEVEL_SET_FUNCTIONS_HPP__
+
+#include <vector>
+#include <cstring>
+#include <boost/cstdint.hpp>
+
+namespace ttrk {
+
+  /**
+  * @class HeavisideTable
+  * @brief Tabulated smoothed Heaviside and delta functions for a fixed band width.
+  *
+  * The region terms evaluate these several times for every pixel in the band, so rather than calling sin/cos each time they are sampled
+  * once over [-width, width] and linearly interpolated. The sampling is chosen from the width so the interpolation error is below 1e-6, which
+  * for the default width of 3 is a couple of thousand samples per table. Outside the band the heaviside is exactly 0 or 1 and the delta is
+  * exactly 0, as in the analytic versions.
+  */
+  class HeavisideTable {
+
+  public:
+
+    /**
+    * Build the tables.
+    * @param[in] width The heaviside width (in pixels).
+    */
+    explicit HeavisideTable(const int width = 3);
+
+    /**
+    * Rebuild the tables for a different width. Does nothing if the width is unchanged.
+    * @param[in] width The heaviside width.
+    */
+    void SetWidth(const int width);
+
+    /**
+    * Get the width the tables were built for.
+    * @return The width.
+    */
+    int GetWidth() const { return width_; }
+
+    /**
+    * Look up the smoothed heaviside function.
+    * @param[in] x The sdf value.
+    * @return The heaviside value between 0 and 1.
+    */
+    float Heaviside(const float x) const {
+      if (x >= width_) return 1.0f;
+      if (x <= -width_) return 0.0f;
+      return Interpolate(heaviside_, x);
+    }
+
+    /**
+    * Look up the smoothed delta function.
+    * @param[in] x The sdf value.
+    * @return The delta value.
+    */
+    float Delta(const float x) const {
+      if (x >= width_ || x <= -width_) return 0.0f;
+      return Interpolate(delta_, x);
+    }
+
+    /**
+    * The analytic smoothed heaviside function the table samples.
+    * @param[in] x The sdf value.
+    * @param[in] width The heaviside width.
+    * @return The heaviside value between 0 and 1.
+    */
+    static float AnalyticHeaviside(const float x, const int width);
+
+    /**
+    * The analytic smoothed delta function (the derivative of the heaviside) the table samples.
+    * @param[in] x The sdf value.
+    * @param[in] width The heaviside width.
+    * @return The delta value.
+    */
+    static float AnalyticDelta(const float x, const int width);
+
+  protected:
+
+    /**
+    * Linearly interpolate a table at a point inside the band.
+    * @param[in] table The samples.
+    * @param[in] x The sdf value, strictly between -width and width.
+    * @return The interpolated value.
+    */
+    float Interpolate(const std::vector<float> &table, const float x) const {
+      const float t = (x + width_) * samples_per_pixel_;
+      const int i = (int)t;
+      const float a = t - i;
+      return table[i] + a * (table[i + 1] - table[i]);
+    }
+
+    int width_; /**< The heaviside width the tables were built for. */
+    int samples_per_pixel_; /**< The number of samples per unit of sdf. */
+    std::vector<float> heaviside_; /**< The heaviside samples from -width to width, with one extra at the end so i + 1 is always valid. */
+    std::vector<float> delta_; /**< The delta samples, laid out the same way. */
+
+  };
+
+  /**
+  * A fast natural log for the region error terms. It splits off the exponent and evaluates a short series for the mantissa, so it has no
+  * branches or library calls and the compiler can vectorize loops over it. The error is below 1e-6, relative to max(1, |log(x)|), for positive
+  * normal floats. Zero, negative, denormal and non-finite inputs are
+  * not handled.
+  * @param[in] x The value, positive.
+  * @return log(x).
+  */
+  inline float FastLog(const float x){
+
+    boost::uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+
+    //x = m * 2^e with m in [sqrt(1/2), sqrt(2)) so the series below converges quickly
+    const boost::uint32_t offset = bits - 0x3f3504f3u;
+    const int exponent = (int)(offset >> 23) - ((offset & 0x80000000u) ? 512 : 0);
+    bits -= (boost::uint32_t)exponent << 23;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+
+    //log(m) = 2 atanh(s) with s = (m - 1)/(m + 1) and |s| < 0.172
+    const float s = (m - 1.0f) / (m + 1.0f);
+    const float s2 = s * s;
+    const float log_m = 2.0f * s * (1.0f + s2 * (1.0f / 3.0f + s2 * (1.0f / 5.0f + s2 * (1.0f / 7.0f))));
+
+    return log_m + exponent * 0.693147180559945f;
+
+  }
+
+}
+
+#endif
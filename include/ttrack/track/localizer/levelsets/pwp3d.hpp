@@ -11,6 +11,8 @@
 #include "../../../utils/image.hpp"
 #include "../../model/pose.hpp"
 #include "../../../utils/plotter.hpp"
+#include "../../../utils/scratch_arena.hpp"
+#include "level_set_functions.hpp"
 #include "../features/lk_tracker.hpp"
 
 namespace ttrk {
@@ -119,26 +121,26 @@ namespace ttrk {
     std::vector<float> ScaleRigidJacobian(cv::Matx<float, 7, 1> &jacobian, bool small_step = false) const;
 
     /**
-    * Compute a smoothed heaviside function output for a given value.
+    * Compute a smoothed heaviside function output for a given value. This is looked up in a table built for the heaviside width, falling back
+    * to the analytic function if the width has been changed without rebuilding it.
     * @param[in] x The input value.
     * @return The value scaled to between 0-1 with a smoothed logistic function manner.
     */
     float HeavisideFunction(const float x) const {
-      if (x > HEAVYSIDE_WIDTH) return 1.0f;
-      else if (x < -HEAVYSIDE_WIDTH) return 0.0f;
-      else return 0.5f*(1.0f + (x / float(HEAVYSIDE_WIDTH)) + (1.0f / float(M_PI))*sin((float(M_PI)*x) / float(HEAVYSIDE_WIDTH)));
+      if (heaviside_table_.GetWidth() == HEAVYSIDE_WIDTH) return heaviside_table_.Heaviside(x);
+      return HeavisideTable::AnalyticHeaviside(x, HEAVYSIDE_WIDTH);
       //return 0.5f + 0.5f*tanh(float(HEAVYSIDE_WIDTH)*x);
     }
 
     /**
     * Compute a smoothed delta function output for a given value. This is basically a Gaussian approximation where the standard deviation is close to zero.
-    * Warning this approximation is only valid close to the zero line.
+    * Warning this approximation is only valid close to the zero line. Looked up in the same way as HeavisideFunction.
     * @param[in] x The input value.
     * @return The output value.
     */
     float DeltaFunction(const float x) const {
-      if (std::abs(x) > HEAVYSIDE_WIDTH) return 0.0f;
-      else return (1.0f / (2.0f * HEAVYSIDE_WIDTH))*(1.0f + cos(float(M_PI)*x / HEAVYSIDE_WIDTH));
+      if (heaviside_table_.GetWidth() == HEAVYSIDE_WIDTH) return heaviside_table_.Delta(x);
+      return HeavisideTable::AnalyticDelta(x, HEAVYSIDE_WIDTH);
       //return (1.0f / 2.0f / HEAVYSIDE_WIDTH*(1.0f + cos(float(M_PI)*x / HEAVYSIDE_WIDTH)));
     }
     
@@ -190,6 +192,16 @@ namespace ttrk {
     */
     cv::Mat ComputeSDFImageAndSetProgressFrame(const cv::Mat contour_image, const cv::Mat &front_depth_image);
 
+    /**
+    * Unproject the rendered depth values to find the 3D point on the front and back surface of the model seen through each pixel.
+    * @param[in] camera The camera the depth was rendered from.
+    * @param[in] front_depth The front depth image from the renderer.
+    * @param[in] back_depth The back depth image from the renderer.
+    * @param[out] front_intersection_image The front intersection points, GL_FAR where the pixel does not see the model.
+    * @param[out] back_intersection_image The back intersection points, GL_FAR where the pixel does not see the model.
+    */
+    void ComputeIntersectionImages(const boost::shared_ptr<MonocularCamera> camera, const cv::Mat &front_depth, const cv::Mat &back_depth, cv::Mat &front_intersection_image, cv::Mat &back_intersection_image) const;
+
     /**
     * Render a single channel floating point sdf image as a heatmap.
     * @param[in] sdf_image The sdf image from the tracking as single channel floating point.
@@ -214,9 +226,12 @@ namespace ttrk {
     ci::gl::GlslProg front_depth_;  /**< Shader to compute the front depth buffer. */
     ci::gl::GlslProg back_depth_and_contour_;  /**< Shader to compute the back depth buffer and contour. */
 
+    ScratchArena scratch_; /**< Pooled buffers for the per-step images (depth, sdf, intersection and label images). */
+
     bool use_level_sets_; //hack to force only using feature localizer
     
     int HEAVYSIDE_WIDTH;  /**< Width of the heaviside blurring function. */
+    HeavisideTable heaviside_table_; /**< The heaviside and delta functions tabulated for HEAVYSIDE_WIDTH. */
 
     std::vector<float> region_scores;
     float best_region_score;
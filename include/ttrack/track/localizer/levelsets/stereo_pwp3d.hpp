@@ -31,6 +31,12 @@ namespace ttrk {
     * @param[in] model The model we are tracking. Pose is updated inside this loop.
     */
     virtual void TrackTargetInFrame(boost::shared_ptr<Model> model, boost::shared_ptr<sv::Frame> frame);
+
+    /**
+    * Get the error of the most recent alignment step.
+    * @return The error.
+    */
+    virtual float GetCurrentError() const { return errors_.empty() ? 0.0f : errors_.back(); }
     
 #ifdef USE_CERES 
 
@@ -78,6 +78,18 @@ namespace ttrk {
 
     void UpdateStepCount() { curr_step++; }
 
+    /**
+    * Get the number of optimization steps run on the current frame.
+    * @return The step count.
+    */
+    int GetStepCount() const { return curr_step; }
+
+    /**
+    * Get the error of the most recent optimization step, for logging.
+    * @return The error, or zero if the localizer doesn't keep track of it.
+    */
+    virtual float GetCurrentError() const { return 0.0f; }
+
     void ResetStepCount() { curr_step = 0; }
 
     void SetMaximumIterations(const size_t iter) { NUM_STEPS = iter; }
@@ -0,0 +1,116 @@
+#ifndef __LOCALIZER_RECORDING_HPP__
+#define __LOCALIZER_RECORDING_HPP__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <boost/cstdint.hpp>
+
+#include "../../headers.hpp"
+#include "../model/model.hpp"
+
+namespace ttrk {
+
+  /**
+  * @struct LocalizerInput
+  * @brief Everything the localizer reads when it tracks the models in a frame.
+  *
+  * This is captured before the first localizer step on a frame (the poses and point sets) and after it (the classification map) so
+  * replaying it runs the localizer on exactly the same input without decoding video, retraining the classifier or classifying the frame.
+  */
+  struct LocalizerInput {
+
+    LocalizerInput() : frame_index(0) {}
+
+    boost::uint64_t frame_index; /**< The tracker's frame count when the input was recorded. */
+    cv::Mat image; /**< The frame image, side by side for stereo. */
+    cv::Mat classification_map; /**< The classification map the localizer steps used. */
+    std::vector< std::vector<float> > poses; /**< The pose of each model before the first step, in the order of Model::GetPose. */
+    std::vector<ModelPointSet> point_sets; /**< The feature tracker state of each model before the first step. */
+
+  };
+
+  /**
+  * Copy a recorded point set into a model. TrackedPoint can't be assigned so this rebuilds the points.
+  * @param[in] source The recorded point set.
+  * @param[out] destination The model's point set.
+  */
+  void RestorePointSet(const ModelPointSet &source, ModelPointSet &destination);
+
+  /**
+  * @struct LocalizerRecordingHeader
+  * @brief The header at the start of a localizer input recording. It is followed by one variable length record per frame.
+  */
+  struct LocalizerRecordingHeader {
+
+    enum { VERSION = 3 };
+
+    char magic[8]; /**< "TTRKLOC" null terminated. */
+    boost::uint32_t version; /**< The format version. */
+
+  };
+
+  /**
+  * @class LocalizerInputWriter
+  * @brief Appends localizer inputs to a binary recording.
+  */
+  class LocalizerInputWriter {
+
+  public:
+
+    /**
+    * Create the recording, truncating it if it exists.
+    * @param[in] path The file to write.
+    */
+    explicit LocalizerInputWriter(const std::string &path);
+
+    /**
+    * Write the inputs for a frame.
+    * @param[in] input The inputs.
+    */
+    void Append(const LocalizerInput &input);
+
+    /**
+    * Get the number of frames written.
+    * @return The number of frames.
+    */
+    size_t GetNumberOfFrames() const { return num_frames_; }
+
+  protected:
+
+    std::ofstream ofs_; /**< The recording. */
+    size_t num_frames_; /**< The number of frames written. */
+
+  };
+
+  /**
+  * @class LocalizerInputReader
+  * @brief Reads the frames of a localizer input recording in order.
+  */
+  class LocalizerInputReader {
+
+  public:
+
+    /**
+    * Open the recording. Throws if the file is not a localizer input recording.
+    * @param[in] path The file to read.
+    */
+    explicit LocalizerInputReader(const std::string &path);
+
+    /**
+    * Read the next frame's inputs.
+    * @param[out] input The inputs.
+    * @return False if there are no frames left.
+    */
+    bool Read(LocalizerInput &input);
+
+  protected:
+
+    std::ifstream ifs_; /**< The recording. */
+    std::string path_; /**< The path of the recording, for error messages. */
+
+  };
+
+}
+
+#endif
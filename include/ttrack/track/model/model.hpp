@@ -14,11 +14,15 @@
 
 #include "pose.hpp"
 #include "../../utils/camera.hpp"
+#include "../../utils/frame_pyramid.hpp"
 #include "node.hpp"
 #include <ttrack/detect/detect.hpp>
+#include <ttrack/utils/profiler.hpp>
 
 namespace ttrk{
 
+  class DescriptorMap;
+
   struct TrackedPoint {
     
     TrackedPoint(const cv::Vec3f &mp, const cv::Vec2f &fp) : model_point(mp), frame_point(fp), found_image_point(fp), point_in_view(true), point_tracked_on_model(true) {}
@@ -55,8 +59,14 @@ namespace ttrk{
     std::vector<cv::Point2f> points_test[2];
     cv::Mat front_intersection_image_; //for masking
     cv::Mat previous_intersection_image_; 
+    cv::Mat occluded_pixels_; /**< 1 where the model is behind another surface in the current render, 0 elsewhere. */
+    cv::Mat occlusion_integral_; /**< The integral image of occluded_pixels_, for FeatureLocalizer::IsOccluded. */
     cv::Mat current_frame; //only for lk
     cv::Mat previous_frame;
+    boost::shared_ptr<sv::FramePyramid> previous_pyramid; /**< The cache previous_frame came from, null if it was converted without one. */
+    std::vector<cv::KeyPoint> previous_keypoints; /**< The keypoints PointRegistration found in previous_frame. */
+    cv::Mat previous_descriptors; /**< The RootSIFT descriptors of previous_keypoints, one per row. */
+    boost::shared_ptr<DescriptorMap> descriptor_map; /**< The descriptors PointRegistration has seen on the model's surface. */
     bool is_initialised;
 
 
@@ -66,7 +76,6 @@ namespace ttrk{
   struct ModelDebugInfo {
 
     cv::Mat tracked_feature_points;
-    cv::VideoWriter tracked_feature_points_writer;
 
   };
 
@@ -90,8 +99,13 @@ namespace ttrk{
 
     boost::shared_ptr<MonocularCamera> cam;
     std::vector<ICL_Tracked_Point> icl_data;
-    std::ofstream icl_output_file;
-    void WriteICLData(const cv::Mat &occlusion_image);
+
+    /**
+    * Get the positions of the ICL tracked points for the current pose, as written to the ICL results file.
+    * @param[in] occlusion_image The depth image used to check if each point is in view.
+    * @return The formatted points.
+    */
+    std::string GetICLDataAsString(const cv::Mat &occlusion_image);
 
     ModelPointSet mps;
     ModelDebugInfo debug_info;
@@ -193,9 +207,16 @@ namespace ttrk{
     const Node::Ptr GetModel() const { return model_; }
 
     /**
-    * Serialize the pose and write it to the file (see constructor).
+    * Serialize the pose in the format written to the save file (see constructor).
+    * @return The serialized pose.
+    */
+    std::string GetPoseAsString();
+
+    /**
+    * Get the file the pose is saved to.
+    * @return The save file.
     */
-    void WritePoseToFile();
+    const std::string &GetSaveFile() const { return save_file_; }
 
     /**
     * Get the total number of models as a string, useful for saving etc.
@@ -218,6 +239,7 @@ namespace ttrk{
     virtual bool PerformPicking(const ci::Vec3f &ray, ci::Vec3f &intersection, ci::Vec3f &normal) const;
 
     void RetrainModel(const cv::Mat &frame, const cv::Mat &sdf_based_mask, const cv::Mat &label_image){
+      ScopedTimer retrain_timer(PROFILE_RETRAIN);
       detector_->RetrainClassifier(frame, sdf_based_mask, label_image);
     }
 
@@ -225,6 +247,8 @@ namespace ttrk{
 
     void ClassifyFrame(boost::shared_ptr<sv::Frame> frame, cv::Mat &sdf_image) {
 
+      if (use_recorded_classification_) return;
+
       detector_->Run(frame, sdf_image);
       detector_->ResetHandleToFrame();
 
@@ -232,6 +256,13 @@ namespace ttrk{
 
     void InitDetector(const ClassifierType &classifier_type, const size_t &num_classes);
 
+    /**
+    * Stop the model classifying (and retraining on) frames, for replaying recorded localizer inputs where the frame already holds the
+    * classification map that was recorded with it.
+    * @param[in] use_recorded Whether to keep the classification map already in the frame.
+    */
+    void UseRecordedClassification(const bool use_recorded) { use_recorded_classification_ = use_recorded; }
+
     bool clasper_1_dislodged;
     bool clasper_2_dislodged;
 
@@ -269,6 +300,7 @@ namespace ttrk{
     */
     Model() {
       frame_count_ = 0;
+      use_recorded_classification_ = false;
       total_model_count_++;
     }
 
@@ -278,7 +310,6 @@ namespace ttrk{
     
     cv::Vec3f principal_axis_; /**< The principal axis of the shape, this is not entirely meaningful for all shapes but can be useful for things shaped like cylinders. */
 
-    std::ofstream ofs_; /**< A file to save the pose of the model at each frame. */
 
     static size_t total_model_count_; /** Count of all created models so when we create a new one it gets it's own file. */
 
@@ -288,6 +319,8 @@ namespace ttrk{
 
     size_t frame_count_;
 
+    bool use_recorded_classification_; /**< Skip classification and retraining as the frames already hold their classification maps. */
+
   };
 
 
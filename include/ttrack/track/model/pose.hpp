@@ -42,6 +42,13 @@ namespace ttrk {
     */
     std::vector<ci::Vec3f> ComputeJacobian(const ci::Vec3f &point) const;
 
+    /**
+    * Compute the rigid body jacobian for this pose for a particular 3D point into an existing vector, so a caller computing it for many points can reuse one buffer.
+    * @param[in] point The 3D point to compute the jacobian from.
+    * @param[out] jacobian The jacobian, resized to the number of degrees of freedom.
+    */
+    void ComputeJacobian(const ci::Vec3f &point, std::vector<ci::Vec3f> &jacobian) const;
+
     /**
     * Set the pose updates.
     * @param[in] updates The vector of updates for each degree of freedom.
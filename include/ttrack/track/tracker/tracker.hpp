@@ -10,6 +10,7 @@
 #include "../../headers.hpp"
 #include "../../utils/image.hpp"
 #include "../localizer/localizer.hpp"
+#include "../localizer/localizer_recording.hpp"
 #include "../model/model.hpp"
 #include "../temporal/temporal.hpp"
 #include <ttrack/detect/detect.hpp>
@@ -20,7 +21,7 @@ namespace ttrk{
   * @enum LocalizerType
   * The type of frame-by-frame pose localizer to use in tracking.
   */
-  enum LocalizerType { LevelSetForest, PWP3D_SIFT, PWP3D_LK, ComponentLS_SIFT, ComponentLS_LK, ArticulatedComponentLS_GradientDescent, ArticulatedComponentLS_WithSamping, CeresLevelSetSolver, PWP3D, ComponentLS, LK, ArticulatedComponentLS_GradientDescent_F2FLK };
+  enum LocalizerType { LevelSetForest, PWP3D_SIFT, PWP3D_LK, ComponentLS_SIFT, ComponentLS_LK, ArticulatedComponentLS_GradientDescent, ArticulatedComponentLS_WithSamping, CeresLevelSetSolver, PWP3D, ComponentLS, LK, ArticulatedComponentLS_GradientDescent_F2FLK, PWP3D_ORB };
 
 
  /**
@@ -113,6 +114,18 @@ namespace ttrk{
     */
     cv::Mat GetLocalizerProgressFrame() { return localizer_image_; }
 
+    /**
+    * Get the number of localizer steps run on the current frame.
+    * @return The step count.
+    */
+    int GetLocalizerStepCount() const { return localizer_->GetStepCount(); }
+
+    /**
+    * Get the localizer's error for the most recent step.
+    * @return The error.
+    */
+    float GetLocalizerError() const { return localizer_->GetCurrentError(); }
+
     bool IsFirstRun() { return localizer_->IsFirstRun(); }
 
     void SetLocalizerIterations(const size_t iterations) { localizer_->SetMaximumIterations(iterations); }
@@ -129,6 +142,22 @@ namespace ttrk{
       number_of_labels_ = number_of_labels; 
     }
 
+    /**
+    * Record the localizer's inputs for every frame from now on, see LocalizerInput.
+    * @param[in] path The recording file to write.
+    */
+    void RecordLocalizerInputs(const std::string &path) { localizer_recorder_.reset(new LocalizerInputWriter(path)); }
+
+    /**
+    * Run the localizer to convergence on a recorded frame. The models are set to the recorded poses and feature tracker state and
+    * use the recorded classification map rather than classifying the frame. With several models, every model sees the classification
+    * map as it was after the last model was classified.
+    * @param[in] input The recorded inputs.
+    * @param[in] frame A frame made from the recorded image, the classification map is copied into it.
+    * @return False if the models could not be initialised.
+    */
+    bool ReplayLocalizerInput(const LocalizerInput &input, boost::shared_ptr<sv::Frame> frame);
+
   protected:
 
     /**
@@ -177,6 +206,8 @@ namespace ttrk{
 
     cv::Mat localizer_image_; /**< Image from the localizer for visualizing progress in GUI. */
 
+    boost::scoped_ptr<LocalizerInputWriter> localizer_recorder_; /**< Records the localizer inputs of each frame, if set. */
+
   };
 
 }
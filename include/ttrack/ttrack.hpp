@@ -20,6 +20,13 @@
 #include "track/tracker/tracker.hpp"
 #include "detect/detect.hpp"
 #include "utils/handler.hpp"
+#include "utils/triple_buffer.hpp"
+#include "utils/gl_context.hpp"
+#include "utils/results_writer.hpp"
+#include "utils/trajectory_log.hpp"
+#include "utils/profiler.hpp"
+#include "utils/allocation_tracker.hpp"
+#include "utils/tracer.hpp"
 
 /**
  * @namespace ttrk
@@ -35,6 +42,28 @@ namespace ttrk{
 
    enum CameraType { MONOCULAR = 0, STEREO = 1 };
 
+  /**
+  * @struct TrackingSnapshot
+  * @brief The results of a single tracking step, published by the tracking thread for the GUI.
+  *
+  * Everything in here is owned by the snapshot: the tracking thread never writes to the images after publishing them so the GUI can
+  * read them while tracking carries on with the next step.
+  */
+  struct TrackingSnapshot {
+
+    TrackingSnapshot() : frame_index(0), converged(false), done(false) {}
+
+    size_t frame_index; /**< The index of the frame these results are for. */
+    bool converged; /**< Whether the localizer converged on this frame in this step, i.e. these are the final results for the frame. */
+    bool done; /**< Whether the input has run out. */
+    std::vector< std::vector<float> > poses; /**< The pose parameters of each tracked model. */
+    cv::Mat left_image; /**< The left (or only) input image. */
+    cv::Mat right_image; /**< The right input image, empty for monocular tracking. */
+    cv::Mat detector_image; /**< The detector output for this frame. */
+    cv::Mat localizer_image; /**< The localizer progress frame for this step. */
+
+  };
+
   /**
    * @class TTrack
    * @brief The main class for the project. Handles the interaction between all worker classes.
@@ -94,11 +123,55 @@ namespace ttrk{
     void TTrack::GetUpdate(std::vector<boost::shared_ptr<Model> > &models, const bool force_new_frame);
 
     /**
-     * A method for saving the current frame in output directory. 
+    * Start running the tracking in a separate thread. Results are published with each step and can be picked up with UpdateSnapshot. 
+    * Results for each converged frame are saved by the tracking thread, which waits for the GUI to hand over the rendered view with
+    * SaveFrame. If the platform has no shared GL contexts no thread is started and each call to UpdateSnapshot runs one step of the
+    * tracker on the calling thread instead.
+    */
+    void StartTrackingThread();
+
+    /**
+    * Stop the tracking thread and wait for it to finish the step it is running.
+    */
+    void StopTrackingThread();
+
+    /**
+    * Check if the tracking thread has been started.
+    * @return True if tracking is running in a separate thread.
+    */
+    bool IsThreaded() const { return tracking_thread_.joinable(); }
+
+    /**
+    * Pause or resume the tracking thread. The thread finishes the step it is running before pausing.
+    * @param[in] pause Whether to pause.
+    */
+    void PauseTracking(const bool pause) { pause_tracking_ = pause; }
+
+    /**
+    * Ask the tracking thread to give up on the current frame and load a new one.
+    */
+    void ForceNewFrame() { force_new_frame_ = true; }
+
+    /**
+    * Pick up the most recent snapshot published by the tracking thread. Does not block.
+    * @return True if there was a new snapshot, false if GetSnapshot still returns the previous one.
+    */
+    bool UpdateSnapshot();
+
+    /**
+    * Get the most recent snapshot picked up by UpdateSnapshot. Only valid until the next call to UpdateSnapshot.
+    * @return The snapshot.
+    */
+    const TrackingSnapshot &GetSnapshot() const { return snapshots_.GetReadBuffer(); }
+
+    /**
+     * Hand over the frame the GUI rendered for a converged snapshot. The tracking thread waits for it before moving on to the next
+     * frame and saves it to the output video/images, so every converged frame is saved in order.
      * @param[in] frame The frame to save.
+     * @param[in] frame_index The frame_index of the snapshot the frame was rendered from.
      * @param[in] flip Optional argument to flip the frame vertically before saving.
      */
-    void SaveFrame(const cv::Mat &frame, bool flip = false);
+    void SaveFrame(const cv::Mat &frame, const size_t frame_index, bool flip = false);
     
     /**
      * Setup the tracking system with the files it needs to find, localize and track the objects for stereo inputs.
@@ -113,8 +186,10 @@ namespace ttrk{
      * @param[in] starting_pose Temporary, will be removed. Just a hack until the initializer is done.
      * @param[in] starting_poses Hack in the starting poses for cases where we don't have strong auto initialization.
      * @param[in] number_of_labels The number of labels we are trying to classify. This includes the background label.
+     * @param[in] skip_frames The number of frames to skip at the start of the videos.
+     * @param[in] frame_cache_file A decoded frame cache. If it exists frames are read from it instead of the videos, if it doesn't the decoded frames are recorded to it. Empty to just use the videos.
      */
-    void SetUp(const std::string &model_parameter_file, const std::string &camera_calibration_file, const std::string &classifier_path, const std::string &results_dir, const LocalizerType &localizer_type, const ClassifierType classifier_type, const std::string &left_media_file, const std::string &right_media_file, const std::vector< std::vector<float> > &starting_pose, const size_t number_of_labels, const size_t skip_frames);
+    void SetUp(const std::string &model_parameter_file, const std::string &camera_calibration_file, const std::string &classifier_path, const std::string &results_dir, const LocalizerType &localizer_type, const ClassifierType classifier_type, const std::string &left_media_file, const std::string &right_media_file, const std::vector< std::vector<float> > &starting_pose, const size_t number_of_labels, const size_t skip_frames, const std::string &frame_cache_file);
     
     /**
     * Setup the tracking system with the files it needs to find, localize and track the objects for monocular inputs.
@@ -158,10 +233,22 @@ namespace ttrk{
     boost::shared_ptr<const sv::Frame> GetPtrToCurrentFrame() const;
 
     /**
-    * Save the results, if required
+    * Queue the results for the current frame to be written by the results writer. Returns without waiting for any I/O.
     */
     void SaveResults();
 
+    /**
+    * Write the per-stage timing histograms collected so far to profile.csv and profile.json in the results directory, and the per-frame
+    * allocations to allocations.csv if they are being tracked. This is also done when the tracker is destroyed.
+    */
+    void SaveProfile() const;
+
+    /**
+    * Start recording a timeline of the tracking pipeline to trace.json (Chrome trace format) in the results directory. The trace is
+    * written as it runs and is finished when the tracker is destroyed.
+    */
+    void StartTrace();
+
     /**
     * Get the current image from the detector.
     * @return The detector's current output.
@@ -198,6 +285,12 @@ namespace ttrk{
      */
     boost::shared_ptr<sv::Frame> GetPtrToNewFrame();
 
+    /**
+    * Set how new frames are deinterlaced as they are loaded, before anything else reads them.
+    * @param[in] mode The deinterlacing, DEINTERLACE_NONE by default.
+    */
+    void SetDeinterlaceMode(const sv::DeinterlaceMode mode) { deinterlace_mode_ = mode; }
+
     /**
      * Get a pointer to the classifier frame from the detection system.
      * @return The classified frame.
@@ -205,10 +298,35 @@ namespace ttrk{
     //boost::shared_ptr<sv::Frame> GetPtrToClassifiedFrame();
     
     /**
-     * The main method of the class. Called by RunImages or RunVideo which do the
-     * appropriate setup calls first. Loops calling the methods of the Tracker and the Detector.
+     * The main method of the tracking thread. Loops running the tracker and publishing the results until the input runs out or 
+     * StopTrackingThread is called.
      */
     void RunThreaded();
+
+    /**
+    * Run one step of the tracking loop: update the tracker, save the results of a converged frame and publish a snapshot.
+    * @return False once the input has run out.
+    */
+    bool StepTracking();
+
+    /**
+    * Run a single step of the tracker, loading a new frame if the last one has converged.
+    * @param[out] models The tracked models.
+    * @param[in] force_new_frame Load a new frame even if the tracker hasn't converged.
+    */
+    void UpdateTracker(std::vector<boost::shared_ptr<Model> > &models, const bool force_new_frame);
+
+    /**
+    * Save the frame the GUI rendered for the last converged snapshot with the handler.
+    * @param[in] wait Block until the GUI has handed the frame over (or the thread is stopped). Otherwise only save it if it is there.
+    */
+    void SaveRenderedFrame(const bool wait);
+
+    /**
+    * Copy the current tracking results into a snapshot and publish it to the GUI.
+    * @param[in] models The tracked models.
+    */
+    void PublishSnapshot(std::vector<boost::shared_ptr<Model> > &models);
     
     
     boost::scoped_ptr<Tracker> tracker_; /**< The class responsible for finding the instrument in the image. */
@@ -221,6 +339,32 @@ namespace ttrk{
     std::string results_dir_; /**< A string containing the results directory for the data in use. */
     
     CameraType camera_type_; /**< The camera type we are tracking with. */
+    sv::DeinterlaceMode deinterlace_mode_; /**< How new frames are deinterlaced when they are loaded. */
+
+    boost::scoped_ptr<ResultsWriter> results_writer_; /**< Writes the pose, ICL and debug video results in the background. */
+    std::vector<boost::shared_ptr<TrajectoryLogWriter> > trajectory_logs_; /**< A binary trajectory log for each tracked model. */
+    double frame_load_time_; /**< Time spent loading the current frame, in seconds. */
+    double frame_track_time_; /**< Time spent tracking in the current frame so far, in seconds. */
+
+    boost::scoped_ptr<SharedGLContext> tracking_context_; /**< The GL context the tracker renders with. Owns the localizer framebuffers. */
+
+    boost::thread tracking_thread_; /**< The thread running the tracker when StartTrackingThread is used. */
+    std::atomic<bool> stop_tracking_; /**< Signal for the tracking thread to exit. */
+    std::atomic<bool> pause_tracking_; /**< Signal for the tracking thread to pause. */
+    std::atomic<bool> force_new_frame_; /**< Signal for the tracking thread to load a new frame. */
+    bool step_on_caller_; /**< Set when StartTrackingThread couldn't start a thread, UpdateSnapshot runs the tracker instead. */
+
+    TripleBuffer<TrackingSnapshot> snapshots_; /**< The results published by the tracking thread. */
+    size_t frame_index_; /**< The number of frames loaded so far. */
+    boost::mutex rendered_frame_mutex_; /**< Protects the rendered frame handed over by the GUI. */
+    boost::condition_variable rendered_frame_ready_; /**< Signals the tracking thread that the GUI has handed over a rendered frame. */
+    size_t awaited_frame_index_; /**< The index of the converged frame whose rendering hasn't been saved yet, 0 for none. */
+    size_t rendered_frame_index_; /**< The frame_index of rendered_frame_. */
+    cv::Mat rendered_frame_; /**< The last frame rendered by the GUI, waiting to be saved. */
+    boost::shared_ptr<sv::Frame> published_frame_; /**< The frame whose images are in the last published snapshot, avoids copying the images every step. */
+    cv::Mat published_left_image_; /**< Copy of the left image of published_frame_, shared by the snapshots. */
+    cv::Mat published_right_image_; /**< Copy of the right image of published_frame_, shared by the snapshots. */
+    cv::Mat published_detector_image_; /**< Copy of the detector output for published_frame_, shared by the snapshots. */
 
   private:
 
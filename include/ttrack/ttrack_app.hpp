@@ -35,7 +35,7 @@ public:
   virtual void setup();
 
   /**
-  * Get the latest pose updates.
+  * Get the latest pose updates published by the tracking thread.
   */
   virtual void update();
 
@@ -181,12 +181,18 @@ protected:
    
   boost::shared_ptr<ttrk::StereoCamera> camera_; /**< The camera model we are using. */
   
-  std::vector<boost::shared_ptr<ttrk::Model> > models_to_draw_; /**< The set of models we are rendering/tracking. */
+  std::vector<boost::shared_ptr<ttrk::Model> > models_to_draw_; /**< Copies of the tracked models, posed with the latest tracking results for drawing. */
 
   bool force_new_frame_; /**< Force the gradient descent to stop converging and for a new frame to load. */
 
   bool run_tracking_; /**< Switch on and off the tracking. */
 
+  bool save_results_; /**< The latest tracking results are for a converged frame which we haven't saved yet. */
+
+  size_t displayed_frame_index_; /**< The index of the frame whose images we are displaying. */
+
+  size_t saved_frame_index_; /**< The index of the last frame we saved the results for. */
+
   MayaCamUI	maya_cam_; /**< Maya cam for interactive viewing. */
 
   Vec2i	mouse_pos_; /**< Current estimate of mouse position. */
@@ -0,0 +1,54 @@
+#ifndef __ALLOCATION_TRACKER_HPP__
+#define __ALLOCATION_TRACKER_HPP__
+
+#include "profiler.hpp"
+
+namespace ttrk {
+
+  /**
+  * @class AllocationTracker
+  * @brief Counts heap allocations and adds them to the profiler stage which is running on the allocating thread.
+  *
+  * Tracking needs the allocation hooks, a replacement global operator new and a cv::Mat allocator, which are only compiled in when
+  * TTRK_TRACK_ALLOCATIONS is defined (the WITH_ALLOCATION_TRACKING cmake option). Even then nothing is counted until Enable is called,
+  * after which every frame gets a sample of the bytes and number of allocations in each stage (see Profiler::WriteAllocationsCSV).
+  * Only allocations are counted, frees are not, as the aim is to find the temporaries which are allocated on every iteration.
+  */
+  class AllocationTracker {
+
+  public:
+
+    /**
+    * Start counting allocations.
+    * @return False if the allocation hooks were not compiled in, in which case nothing is counted.
+    */
+    static bool Enable();
+
+    /**
+    * Stop counting allocations.
+    */
+    static void Disable();
+
+    /**
+    * Check whether allocations are being counted.
+    * @return True if they are.
+    */
+    static bool IsEnabled();
+
+    /**
+    * Check whether the allocation hooks were compiled in.
+    * @return True if Enable can work.
+    */
+    static bool IsAvailable();
+
+    /**
+    * Count an allocation. Called by the hooks, it can also be called by code which gets memory some other way.
+    * @param[in] bytes The size of the allocation.
+    */
+    static void Record(const size_t bytes);
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef __BENCHMARK_HPP__
+#define __BENCHMARK_HPP__
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <functional>
+
+namespace ttrk {
+
+  /**
+  * @struct BenchmarkResult
+  * @brief The timings of a single benchmark case.
+  */
+  struct BenchmarkResult {
+
+    BenchmarkResult() : iterations(0), mean(0), median(0), min(0), max(0) {}
+
+    std::string name; /**< The name of the kernel being timed. */
+    std::string params; /**< The parameters of the case, e.g. the resolution and band width. */
+    size_t iterations; /**< The number of timed runs. */
+    double mean; /**< The mean run time in milliseconds. */
+    double median; /**< The median run time in milliseconds. */
+    double min; /**< The fastest run time in milliseconds. */
+    double max; /**< The slowest run time in milliseconds. */
+
+  };
+
+  /**
+  * @class Benchmark
+  * @brief Runs a set of timed cases and reports per-case statistics.
+  *
+  * Each case is run once untimed to warm up caches and lazily created buffers, then repeatedly until both the minimum number of
+  * iterations and the minimum time have been reached. Results can be saved as CSV and compared against a previous run to catch regressions.
+  */
+  class Benchmark {
+
+  public:
+
+    /**
+    * Create an empty benchmark.
+    * @param[in] min_time The minimum time to spend timing each case, in seconds.
+    * @param[in] min_iterations The minimum number of timed runs of each case.
+    * @param[in] max_iterations The maximum number of timed runs of each case, whatever the time spent.
+    */
+    explicit Benchmark(const double min_time = 1.0, const size_t min_iterations = 5, const size_t max_iterations = 1000);
+
+    /**
+    * Add a case.
+    * @param[in] name The name of the kernel being timed.
+    * @param[in] params The parameters of the case. The name and parameters together identify the case when comparing to a baseline.
+    * @param[in] run The function to time.
+    * @param[in] setup An optional untimed function called before every run, e.g. to restore state the run modifies.
+    */
+    void Add(const std::string &name, const std::string &params, const std::function<void()> &run, const std::function<void()> &setup = std::function<void()>());
+
+    /**
+    * Run every case whose name contains filter, logging each result as it finishes. A case which throws is reported and skipped.
+    * @param[in] log The stream to write progress to.
+    * @param[in] filter Only run cases whose name contains this string. Empty runs everything.
+    */
+    void Run(std::ostream &log, const std::string &filter = "");
+
+    /**
+    * Get the results of the cases which have been run.
+    * @return The results.
+    */
+    const std::vector<BenchmarkResult> &GetResults() const { return results_; }
+
+    /**
+    * Write the results as CSV with the columns name,params,iterations,mean_ms,median_ms,min_ms,max_ms.
+    * @param[in] path The file to write.
+    */
+    void WriteCSV(const std::string &path) const;
+
+    /**
+    * Read results previously written by WriteCSV.
+    * @param[in] path The file to read.
+    * @return The results.
+    */
+    static std::vector<BenchmarkResult> ReadCSV(const std::string &path);
+
+    /**
+    * Compare the median time of each case to the same case in a baseline, logging every case which has slowed down by more than the tolerance.
+    * Cases which are not in the baseline are ignored.
+    * @param[in] baseline The baseline results.
+    * @param[in] tolerance The allowed fractional slow down, e.g. 0.1 for 10%.
+    * @param[in] log The stream to write the regressions to.
+    * @return The number of cases which regressed.
+    */
+    size_t CompareToBaseline(const std::vector<BenchmarkResult> &baseline, const double tolerance, std::ostream &log) const;
+
+  protected:
+
+    /**
+    * @struct Case
+    * @brief A registered case.
+    */
+    struct Case {
+
+      std::string name; /**< The name of the kernel. */
+      std::string params; /**< The parameters of the case. */
+      std::function<void()> run; /**< The function to time. */
+      std::function<void()> setup; /**< Untimed function to call before each run, may be empty. */
+
+    };
+
+    /**
+    * Time a single case.
+    * @param[in] c The case.
+    * @return The timings.
+    */
+    BenchmarkResult RunCase(const Case &c) const;
+
+    double min_time_; /**< The minimum time to spend on each case in seconds. */
+    size_t min_iterations_; /**< The minimum number of timed runs of each case. */
+    size_t max_iterations_; /**< The maximum number of timed runs of each case. */
+
+    std::vector<Case> cases_; /**< The registered cases. */
+    std::vector<BenchmarkResult> results_; /**< The results of the cases which have been run. */
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __DEINTERLACE_HPP__
+#define __DEINTERLACE_HPP__
+
+#include <string>
+#include <cv.h>
+
+namespace sv {
+
+  /**
+  * How to remove the combing from frames captured as two interleaved fields.
+  */
+  enum DeinterlaceMode {
+    DEINTERLACE_NONE, /**< Leave the frame as it is. */
+    DEINTERLACE_EVEN_FIELD, /**< Keep the even rows and double each one over the odd row below it (line doubling). */
+    DEINTERLACE_ODD_FIELD, /**< Keep the odd rows and double each one over the even row above it. */
+    DEINTERLACE_BLEND /**< Replace each pair of rows with their average. */
+  };
+
+  /**
+  * Deinterlace a frame in place and convert it to grayscale in the same pass. Each pair of rows is read once, and as both rows of a pair
+  * end up the same only one gray row is computed and copied to the other. The gray values are the same as cv::cvtColor with CV_BGR2GRAY.
+  * A stereo frame is deinterlaced as a whole so both eyes get the same treatment.
+  * @param[in,out] frame The 8 bit BGR or grayscale frame.
+  * @param[out] gray The grayscale frame, always a new buffer so it can be shared with caches holding the previous one.
+  * @param[in] mode The deinterlacing to use.
+  */
+  void DeinterlaceAndConvertToGray(cv::Mat &frame, cv::Mat &gray, const DeinterlaceMode mode);
+
+  /**
+  * Convert a string from a config file (none, even, odd or blend) to a DeinterlaceMode.
+  * @param[in] mode_name The name of the mode, in any case.
+  * @return The mode.
+  */
+  DeinterlaceMode DeinterlaceModeFromString(const std::string &mode_name);
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef __FRAME_PYRAMID_HPP__
+#define __FRAME_PYRAMID_HPP__
+
+#include <vector>
+#include <cv.h>
+
+namespace sv {
+
+  /**
+  * @class FramePyramid
+  * @brief The grayscale version of a frame and its Lucas-Kanade pyramid, built once per frame and shared by every feature tracker and model.
+  *
+  * Both are built lazily on first use. The pyramid holds the interleaved image/gradient levels from cv::buildOpticalFlowPyramid so it can be
+  * passed straight to cv::calcOpticalFlowPyrLK or ttrk::PyramidalLK. The trackers keep the previous frame's pyramid by shared_ptr, so nothing here may be written to.
+  */
+  class FramePyramid {
+
+  public:
+
+    /**
+    * Create the cache for an image. Nothing is computed until it is needed.
+    * @param[in] image The BGR or grayscale image. The pixels are shared, not copied.
+    */
+    explicit FramePyramid(cv::Mat image);
+
+    /**
+    * Create the cache for an image whose grayscale version has already been made, e.g. while deinterlacing it.
+    * @param[in] image The BGR or grayscale image. The pixels are shared, not copied.
+    * @param[in] gray The CV_8UC1 version of the image, the same size. The pixels are shared, not copied.
+    */
+    FramePyramid(cv::Mat image, cv::Mat gray);
+
+    /**
+    * Get the image the cache was built from.
+    * @return The image.
+    */
+    const cv::Mat &GetImage() const { return image_; }
+
+    /**
+    * Check whether the cache was built from an image, i.e. the two share the same pixels and size.
+    * @param[in] image The image to check.
+    * @return True if the image is the one the cache was built from.
+    */
+    bool IsBuiltFrom(const cv::Mat &image) const { return image.data == image_.data && image.size() == image_.size(); }
+
+    /**
+    * Get the grayscale image, converting the image on the first call.
+    * @return The CV_8UC1 image.
+    */
+    const cv::Mat &GetGray();
+
+    /**
+    * Get the Lucas-Kanade pyramid with gradients, building it on the first call or if it was built with different parameters.
+    * @param[in] win_size The window size that will be passed to cv::calcOpticalFlowPyrLK.
+    * @param[in] max_level The highest pyramid level.
+    * @return The pyramid levels.
+    */
+    const std::vector<cv::Mat> &GetPyramid(const cv::Size win_size, const int max_level);
+
+  protected:
+
+    cv::Mat image_; /**< The image the cache was built from. */
+    cv::Mat gray_; /**< The grayscale image, empty until GetGray is called. */
+    std::vector<cv::Mat> pyramid_; /**< The pyramid levels, empty until GetPyramid is called. */
+    cv::Size pyramid_win_size_; /**< The window size the pyramid was built for. */
+    int pyramid_max_level_; /**< The highest level the pyramid was built for. */
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef __GL_CONTEXT_HPP__
+#define __GL_CONTEXT_HPP__
+
+namespace ttrk {
+
+  /**
+  * @class SharedGLContext
+  * @brief An OpenGL context which shares textures, buffers and shaders with the context that is current when it is created.
+  *
+  * Used to give the tracking thread its own context so that the localizers can render into their framebuffers while the GUI draws.
+  * Framebuffer objects are not shared between contexts so anything that creates them must do so while this context is current.
+  */
+  class SharedGLContext {
+
+  public:
+
+    /**
+    * Create a new context sharing with the calling thread's current context. Throws if there is no current context. On platforms
+    * without shared contexts nothing is created and MakeCurrent and Release do nothing.
+    */
+    SharedGLContext();
+
+    /**
+    * Delete the context. It must not be current on any thread.
+    */
+    ~SharedGLContext();
+
+    /**
+    * Make this context current on the calling thread, remembering whichever context was current before.
+    */
+    void MakeCurrent();
+
+    /**
+    * Restore the context which was current on the calling thread before MakeCurrent was called.
+    */
+    void Release();
+
+    /**
+    * Check whether a context was actually created, i.e. whether it can be made current on a thread other than the one that created it.
+    * @return False on platforms without shared contexts.
+    */
+    bool IsShared() const { return gl_context_ != 0x0; }
+
+  protected:
+
+    void *device_context_; /**< The platform drawable the context renders to. */
+    void *gl_context_; /**< The platform context handle. */
+
+    void *previous_device_context_; /**< The drawable that was current before MakeCurrent. */
+    void *previous_gl_context_; /**< The context that was current before MakeCurrent. */
+
+  private:
+
+    SharedGLContext(const SharedGLContext &);
+    SharedGLContext &operator=(const SharedGLContext &);
+
+  };
+
+}
+
+#endif
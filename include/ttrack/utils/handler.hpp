@@ -4,6 +4,13 @@
 #include <vector>
 #include <utility>
 #include <string>
+#include <fstream>
+#include <boost/cstdint.hpp>
+#include <map>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 #include "../headers.hpp"
 #include "image.hpp"
@@ -159,6 +166,139 @@ namespace ttrk{
 
   };
 
+  /**
+  * @struct FrameCacheHeader
+  * @brief The header of a decoded frame cache file.
+  *
+  * The header is followed by the raw pixel data of each frame, every frame starts on a FRAME_ALIGNMENT byte boundary so frame i is at
+  * sizeof(FrameCacheHeader) + i * frame_stride.
+  */
+  struct FrameCacheHeader {
+
+    enum { VERSION = 1, FRAME_ALIGNMENT = 64 };
+
+    char magic[8]; /**< "TTRKFRM" null terminated. */
+    boost::uint32_t version; /**< The format version. */
+    boost::int32_t rows; /**< The height of every frame. */
+    boost::int32_t cols; /**< The width of every frame. */
+    boost::int32_t type; /**< The OpenCV type of every frame. */
+    boost::uint64_t frame_stride; /**< The number of bytes between the start of consecutive frames. */
+    boost::uint64_t num_frames; /**< The number of frames, zero if the recording was not closed cleanly. */
+    char padding[24]; /**< Pads the header to FRAME_ALIGNMENT bytes. */
+
+  };
+
+  /**
+  * @class CacheRecordingHandler
+  * @brief Passes through the frames from another handler, recording them to a frame cache file as they are read.
+  *
+  * The frames are recorded after any skipping and resizing the wrapped handler does, so a replay with a CachedFrameHandler sees exactly
+  * the same input without having to decode it again.
+  */
+  class CacheRecordingHandler : public Handler {
+
+  public:
+
+    /**
+    * Wrap a handler and start recording.
+    * @param[in] source The handler to read frames from. This handler takes ownership of it.
+    * @param[in] cache_url The frame cache file to write.
+    */
+    CacheRecordingHandler(Handler *source, const std::string &cache_url);
+
+    /**
+    * Write the final frame count and close the cache file.
+    */
+    ~CacheRecordingHandler();
+
+    /**
+    * Get a new frame from the wrapped handler and append it to the cache.
+    * @return The new frame.
+    */
+    virtual cv::Mat GetNewFrame();
+
+    /**
+    * Save the frame using the wrapped handler.
+    * @param[in] image The frame to save.
+    */
+    virtual void SaveFrame(const cv::Mat image) { source_->SaveFrame(image); }
+
+    /**
+    * Check if the wrapped handler has run out of frames.
+    * @return True for no frames left.
+    */
+    virtual bool Done() { return source_->Done(); }
+
+    virtual int GetFrameWidth() { return source_->GetFrameWidth(); }
+
+    virtual int GetFrameHeight() { return source_->GetFrameHeight(); }
+
+  protected:
+
+    boost::scoped_ptr<Handler> source_; /**< The handler the frames come from. */
+    std::ofstream cache_; /**< The cache file. */
+    FrameCacheHeader header_; /**< The header, rewritten with the frame geometry after the first frame and with the frame count when the recording is closed. */
+
+  };
+
+  /**
+  * @class CachedFrameHandler
+  * @brief Serves frames from a frame cache file recorded by CacheRecordingHandler.
+  *
+  * The file is memory mapped copy-on-write and the frames returned point directly into the mapping so no decoding or copying is done
+  * unless the caller writes to the frame. The frames are only valid while the handler exists.
+  */
+  class CachedFrameHandler : public Handler {
+
+  public:
+
+    /**
+    * Map the cache file.
+    * @param[in] input_url The frame cache file.
+    * @param[in] output_url The output video file.
+    */
+    CachedFrameHandler(const std::string &input_url, const std::string &output_url);
+
+    /**
+    * Get the next frame from the cache.
+    * @return The frame, pointing into the mapped file.
+    */
+    virtual cv::Mat GetNewFrame();
+
+    /**
+    * Save a frame to the output video file.
+    * @param[in] image The frame to save.
+    */
+    virtual void SaveFrame(const cv::Mat image);
+
+    virtual int GetFrameWidth() { return header_.cols; }
+
+    virtual int GetFrameHeight() { return header_.rows; }
+
+    /**
+    * Get the number of frames in the cache.
+    * @return The number of frames.
+    */
+    size_t GetNumberOfFrames() const { return num_frames_; }
+
+  protected:
+
+    boost::scoped_ptr<boost::interprocess::file_mapping> file_; /**< The cache file. */
+    boost::scoped_ptr<boost::interprocess::mapped_region> region_; /**< The mapping of the cache file. */
+    FrameCacheHeader header_; /**< A copy of the cache header. */
+    size_t num_frames_; /**< The number of frames in the cache. */
+    size_t next_frame_; /**< The index of the next frame to serve. */
+    cv::VideoWriter writer_; /**< The video output interface. */
+
+  };
+
+  /**
+  * @class ImageHandler
+  * @brief Loads a directory of images in filename order.
+  *
+  * Images are decoded ahead of time by a small pool of threads into a bounded reorder buffer, so GetNewFrame usually just hands over a
+  * frame that has already been loaded.
+  */
   class ImageHandler : public Handler {
 
   public:
@@ -167,11 +307,18 @@ namespace ttrk{
     * Create a image handler for image sequences.
     * @param[in] input_url The input directory where files are stored.
     * @param[in] output_url The output directory where processed files are saved.
+    * @param[in] num_threads The number of threads to decode images with.
+    * @param[in] max_prefetched The maximum number of decoded images to hold ahead of the one being used.
     */
-    ImageHandler(const std::string &input_url, const std::string &output_url);
+    ImageHandler(const std::string &input_url, const std::string &output_url, const size_t num_threads = 2, const size_t max_prefetched = 8);
+
+    /**
+    * Stop the decoding threads.
+    */
+    virtual ~ImageHandler();
     
     /**
-    * Load the next image from the directory.
+    * Get the next image in filename order, waiting for it to be decoded if it isn't ready.
     * @return The next image.
     */
     virtual cv::Mat GetNewFrame();
@@ -186,23 +333,93 @@ namespace ttrk{
     * Get the width of the frames we are using. Assumes all frames are the same size.
     * @return The frame width.
     */
-    virtual int GetFrameWidth() { if(!paths_.size()) return 0; auto i = cv::imread(paths_[0]); return i.cols; }
+    virtual int GetFrameWidth() { return frame_size_.width; }
 
     /**
-    * Get the width of the frames we are using. Assumes all frames are the same size.
-    * @return The frame width.
+    * Get the height of the frames we are using. Assumes all frames are the same size.
+    * @return The frame height.
     */
-    virtual int GetFrameHeight() { if(!paths_.size()) return 0; auto i = cv::imread(paths_[0]); return i.rows; }
+    virtual int GetFrameHeight() { return frame_size_.height; }
 
-  private:
+  protected:
+
+    /**
+    * Find the images in a directory, sorted by filename.
+    * @param[in] directory The directory to search.
+    * @return The image filenames.
+    */
+    static std::vector<std::string> FindImages(const std::string &directory);
 
-    std::vector<std::string> paths_; /**< The image urls to load and process. */
-    std::vector<std::string>::const_iterator open_iter_; /**< The images still to open. */
+    /**
+    * Decode a frame. Called from the decoding threads.
+    * @param[in] idx The index of the frame in paths_.
+    * @return The frame.
+    */
+    virtual cv::Mat LoadFrame(const size_t idx);
+
+    /**
+    * The main loop of each decoding thread.
+    */
+    void Prefetch();
+
+    /**
+    * Stop the decoding threads and wait for them to exit. Subclasses call this in their destructor as the threads call LoadFrame.
+    */
+    void StopDecoders();
+
+    std::vector<std::string> paths_; /**< The image filenames to load and process, sorted. */
     std::vector<std::string>::const_iterator save_iter_; /**< The images to save. */
+    cv::Size frame_size_; /**< The size of the frames, read once from the first frame. */
+
+    const size_t num_threads_; /**< The number of decoding threads. */
+    const size_t max_prefetched_; /**< The maximum number of frames decoded ahead of next_frame_. */
+    boost::thread_group decoders_; /**< The decoding threads, started on the first call to GetNewFrame. */
+    boost::mutex mutex_; /**< Protects the reorder buffer and the counters. */
+    boost::condition_variable frame_decoded_; /**< Signals that a frame has been added to the reorder buffer. */
+    boost::condition_variable frame_taken_; /**< Signals that a frame has been taken from the reorder buffer. */
+    std::map<size_t, cv::Mat> decoded_; /**< Decoded frames waiting to be used, keyed by index so they come out in order. */
+    size_t next_to_decode_; /**< The index of the next frame for a decoding thread to pick up. */
+    size_t next_frame_; /**< The index of the next frame GetNewFrame returns. */
+    bool stop_; /**< Signal for the decoding threads to exit. */
      
   };
 
+  /**
+  * @class StereoImageHandler
+  * @brief Loads pairs of images from a left and a right directory, matched by their position in filename order.
+  *
+  * The pairs are returned side by side in one frame like the StereoVideoHandler, including the downsizing of 1080p input.
+  */
+  class StereoImageHandler : public ImageHandler {
+
+  public:
+
+    /**
+    * Create a handler for a pair of image directories.
+    * @param[in] left_input_url The directory of left images.
+    * @param[in] right_input_url The directory of right images.
+    * @param[in] output_url The output directory where processed files are saved.
+    */
+    StereoImageHandler(const std::string &left_input_url, const std::string &right_input_url, const std::string &output_url);
 
+    /**
+    * Stop the decoding threads before the right paths are destroyed.
+    */
+    virtual ~StereoImageHandler();
+
+  protected:
+
+    /**
+    * Decode a pair of images and put them side by side.
+    * @param[in] idx The index of the pair.
+    * @return The frame.
+    */
+    virtual cv::Mat LoadFrame(const size_t idx);
+
+    std::string right_input_url_; /**< The directory of right images. */
+    std::vector<std::string> right_paths_; /**< The right image filenames, sorted. */
+
+  };
 
 }
 
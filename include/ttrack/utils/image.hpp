@@ -4,6 +4,9 @@
 #include <cv.h>
 #include <boost/shared_ptr.hpp>
 
+#include "frame_pyramid.hpp"
+#include "deinterlace.hpp"
+
 namespace sv {
 
   template <typename PixelType, int Channels> class Image;
@@ -93,6 +96,34 @@ namespace sv {
 
     }
 
+    /**
+    * Get the grayscale image and Lucas-Kanade pyramid of the image the feature trackers run on. This is created on the first call and shared
+    * by every model tracked in the frame.
+    * @return The cache.
+    */
+    boost::shared_ptr<FramePyramid> GetFeaturePyramid() {
+      if (!feature_pyramid_) feature_pyramid_.reset(new FramePyramid(GetFeatureImage()));
+      return feature_pyramid_;
+    }
+
+    /**
+    * Deinterlace the frame in place, both eyes if it is stereo, and cache the grayscale image made in the same pass for the feature trackers.
+    * Call this before anything reads the frame.
+    * @param[in] mode The deinterlacing to use.
+    */
+    void Deinterlace(const DeinterlaceMode mode) {
+
+      cv::Mat gray;
+      DeinterlaceAndConvertToGray(image_data_.frame_, gray, mode);
+
+      cv::Mat feature_image = GetFeatureImage();
+      cv::Size whole_size;
+      cv::Point offset;
+      feature_image.locateROI(whole_size, offset);
+      feature_pyramid_.reset(new FramePyramid(feature_image, gray(cv::Rect(offset, feature_image.size()))));
+
+    }
+
     static cv::Mat GetChannel(cv::Mat multi_channel, int channel_idx){
 
       std::vector<cv::Mat> channels(multi_channel.channels());
@@ -107,9 +138,16 @@ namespace sv {
     }
 
   protected:    
+
+    /**
+    * Get the image the feature trackers run on.
+    * @return The image, sharing the frame's pixels.
+    */
+    virtual cv::Mat GetFeatureImage() { return image_data_.frame_; }
     
     __InnerImage<PixelType,Channels> image_data_;
     __InnerImage<float,5> classification_map_data_;
+    boost::shared_ptr<FramePyramid> feature_pyramid_; /**< The grayscale/pyramid cache, created by GetFeaturePyramid. */
     
   };
 
@@ -160,6 +198,8 @@ namespace sv {
 
   protected:
 
+    virtual cv::Mat GetFeatureImage() { return GetLeftImage(); }
+
     __InnerImage<float,3> point_cloud_data_;
     __InnerImage<short,1> disparity_map_data_;
     
@@ -0,0 +1,293 @@
+#ifndef __PROFILER_HPP__
+#define __PROFILER_HPP__
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/chrono.hpp>
+
+#include "tracer.hpp"
+
+namespace ttrk {
+
+  /**
+  * @enum ProfileStage
+  * The timed stages of the tracking pipeline. Stage times are inclusive so a stage which runs inside another (e.g. render inside jacobian) is
+  * counted in both.
+  */
+  enum ProfileStage {
+    PROFILE_FRAME_LOAD,
+    PROFILE_ALIGNMENT_STEP,
+    PROFILE_RENDER,
+    PROFILE_READBACK,
+    PROFILE_DISTANCE_TRANSFORM,
+    PROFILE_INTERSECTION_IMAGE,
+    PROFILE_JACOBIAN,
+    PROFILE_CLASSIFICATION,
+    PROFILE_LK,
+    PROFILE_RETRAIN,
+    PROFILE_RESULTS_IO,
+    NUM_PROFILE_STAGES
+  };
+
+  /**
+  * @enum ProfileCounter
+  * Quantities counted per frame alongside the stage timings.
+  */
+  enum ProfileCounter {
+    COUNTER_CONTOUR_PIXELS,
+    COUNTER_TRACKED_POINTS,
+    NUM_PROFILE_COUNTERS
+  };
+
+  /**
+  * @class Profiler
+  * @brief Accumulates the time spent in each stage of the pipeline and builds per-frame histograms from it.
+  *
+  * Timers and counters add to atomic per-frame totals so recording a sample is a couple of atomic adds from any thread. When a frame
+  * finishes, EndFrame moves the totals into the per-frame sample lists which the percentiles are computed from when exporting.
+  * Build with TTRK_NO_PROFILING defined to compile the timers out completely.
+  *
+  * When allocation tracking is on (see AllocationTracker) the bytes and number of allocations made while each stage is the innermost
+  * running stage on the allocating thread are counted too, so unlike the times they are exclusive. Allocations made outside any stage
+  * are counted as "other".
+  */
+  class Profiler {
+
+  public:
+
+    /**
+    * Get the profiler shared by the whole process.
+    * @return The profiler.
+    */
+    static Profiler &Instance();
+
+    /**
+    * Add time spent in a stage to the current frame.
+    * @param[in] stage The stage.
+    * @param[in] nanoseconds The time spent.
+    */
+    void AddTime(const ProfileStage stage, const boost::int64_t nanoseconds){
+      stage_time_[stage] += nanoseconds;
+      stage_calls_[stage]++;
+    }
+
+    /**
+    * Add to a counter for the current frame.
+    * @param[in] counter The counter.
+    * @param[in] n The amount to add.
+    */
+    void Count(const ProfileCounter counter, const boost::int64_t n = 1){
+      counters_[counter] += n;
+    }
+
+    /**
+    * Add an allocation to the stage which is currently running on the calling thread. This must not allocate as it is called from the
+    * allocation hooks.
+    * @param[in] bytes The size of the allocation.
+    */
+    void AddAllocation(const size_t bytes){
+      const int scope = GetAllocationScope();
+      allocation_bytes_[scope] += bytes;
+      allocation_count_[scope]++;
+    }
+
+    /**
+    * Make a stage the one which allocations on the calling thread are added to.
+    * @param[in] stage The stage, or NUM_PROFILE_STAGES for none.
+    * @return The stage allocations were being added to before, to pass to LeaveAllocationScope.
+    */
+    static int EnterAllocationScope(const int stage);
+
+    /**
+    * Restore the stage allocations on the calling thread are added to.
+    * @param[in] previous The value returned by the matching EnterAllocationScope.
+    */
+    static void LeaveAllocationScope(const int previous);
+
+    /**
+    * Get the stage which allocations on the calling thread are being added to.
+    * @return The stage, or NUM_PROFILE_STAGES if no stage is running.
+    */
+    static int GetAllocationScope();
+
+    /**
+    * Finish the current frame, moving the per-frame totals into the histograms. Stages which did not run in the frame do not add a sample.
+    */
+    void EndFrame();
+
+    /**
+    * Clear all of the samples collected so far.
+    */
+    void Reset();
+
+    /**
+    * Get the number of frames which have been ended.
+    * @return The number of frames.
+    */
+    size_t GetNumberOfFrames() const;
+
+    /**
+    * Write a summary (frames, calls, mean, p50/p95/p99 and max per frame) of each stage and counter as CSV.
+    * @param[in] path The file to write.
+    */
+    void WriteCSV(const std::string &path) const;
+
+    /**
+    * Write the same summary as WriteCSV as a JSON object keyed by stage/counter name.
+    * @param[in] path The file to write.
+    */
+    void WriteJSON(const std::string &path) const;
+
+    /**
+    * Write the bytes and number of allocations in each stage for every frame as CSV, one row per frame. Nothing is written unless
+    * allocation tracking was on.
+    * @param[in] path The file to write.
+    */
+    void WriteAllocationsCSV(const std::string &path) const;
+
+    /**
+    * Get the name of a stage as used in the exported files.
+    * @param[in] stage The stage.
+    * @return The name.
+    */
+    static const char *GetStageName(const ProfileStage stage);
+
+    /**
+    * Get the name of a counter as used in the exported files.
+    * @param[in] counter The counter.
+    * @return The name.
+    */
+    static std::string GetCounterName(const ProfileCounter counter);
+
+  protected:
+
+    /**
+    * @struct Summary
+    * @brief The per-frame statistics of a stage or counter.
+    */
+    struct Summary {
+
+      Summary() : frames(0), calls(0), mean(0), p50(0), p95(0), p99(0), max(0) {}
+
+      size_t frames; /**< The number of frames the stage ran in. */
+      boost::uint64_t calls; /**< The total number of calls. */
+      double mean; /**< The mean per-frame value. */
+      double p50; /**< The median per-frame value. */
+      double p95; /**< The 95th percentile per-frame value. */
+      double p99; /**< The 99th percentile per-frame value. */
+      double max; /**< The largest per-frame value. */
+
+    };
+
+    Profiler();
+
+    /**
+    * Compute the statistics of a set of per-frame samples.
+    * @param[in] samples The per-frame values.
+    * @param[in] calls The total number of calls.
+    * @return The statistics.
+    */
+    static Summary Summarize(std::vector<float> samples, const boost::uint64_t calls);
+
+    /**
+    * Take a consistent copy of the samples for exporting.
+    * @param[out] stages The summary of each stage, in milliseconds.
+    * @param[out] counters The summary of each counter.
+    * @param[out] allocation_bytes The summary of the bytes allocated in each stage, the last is outside any stage. Empty if allocations were not tracked.
+    * @param[out] allocation_counts The summary of the number of allocations in each stage.
+    */
+    void GetSummaries(std::vector<Summary> &stages, std::vector<Summary> &counters, std::vector<Summary> &allocation_bytes, std::vector<Summary> &allocation_counts) const;
+
+    std::atomic<boost::int64_t> stage_time_[NUM_PROFILE_STAGES]; /**< Time spent in each stage in the current frame, in nanoseconds. */
+    std::atomic<boost::int64_t> stage_calls_[NUM_PROFILE_STAGES]; /**< Calls to each stage in the current frame. */
+    std::atomic<boost::int64_t> counters_[NUM_PROFILE_COUNTERS]; /**< Counter totals for the current frame. */
+    std::atomic<boost::int64_t> allocation_bytes_[NUM_PROFILE_STAGES + 1]; /**< Bytes allocated in each stage (and outside any) in the current frame. */
+    std::atomic<boost::int64_t> allocation_count_[NUM_PROFILE_STAGES + 1]; /**< Allocations in each stage (and outside any) in the current frame. */
+
+    mutable boost::mutex mutex_; /**< Protects the samples, which are only touched once per frame. */
+    std::vector<float> stage_samples_[NUM_PROFILE_STAGES]; /**< Per-frame time in each stage, in milliseconds. */
+    boost::uint64_t total_calls_[NUM_PROFILE_STAGES]; /**< Total calls to each stage. */
+    std::vector<float> counter_samples_[NUM_PROFILE_COUNTERS]; /**< Per-frame counter values. */
+    std::vector<float> allocation_bytes_samples_[NUM_PROFILE_STAGES + 1]; /**< Per-frame bytes allocated in each stage, only while allocations are tracked. */
+    std::vector<float> allocation_count_samples_[NUM_PROFILE_STAGES + 1]; /**< Per-frame allocations in each stage, only while allocations are tracked. */
+    size_t num_frames_; /**< The number of frames ended. */
+
+  private:
+
+    Profiler(const Profiler &);
+    Profiler &operator=(const Profiler &);
+
+  };
+
+#ifndef TTRK_NO_PROFILING
+
+  /**
+  * @class ScopedTimer
+  * @brief Times a stage from construction until it is stopped or goes out of scope. The stage is also recorded as a span if the tracer is running
+  * and allocations on this thread are added to it while it runs.
+  */
+  class ScopedTimer {
+
+  public:
+
+    /**
+    * Start timing.
+    * @param[in] stage The stage to add the time to.
+    */
+    explicit ScopedTimer(const ProfileStage stage) : stage_(stage), running_(true), previous_scope_(Profiler::EnterAllocationScope(stage)), start_(Tracer::Clock::now()) {}
+
+    /**
+    * Stop timing if Stop has not already been called.
+    */
+    ~ScopedTimer() { Stop(); }
+
+    /**
+    * Stop timing and add the elapsed time to the stage. Further calls do nothing.
+    */
+    void Stop(){
+      if (!running_) return;
+      running_ = false;
+      const Tracer::Clock::time_point end = Tracer::Clock::now();
+      Profiler::LeaveAllocationScope(previous_scope_);
+      Profiler::Instance().AddTime(stage_, boost::chrono::duration_cast<boost::chrono::nanoseconds>(end - start_).count());
+      if (Tracer::IsEnabled()) Tracer::Instance().Record(Profiler::GetStageName(stage_), start_, end);
+    }
+
+  protected:
+
+    const ProfileStage stage_; /**< The stage being timed. */
+    bool running_; /**< Whether the timer still needs to be stopped. */
+    const int previous_scope_; /**< The stage allocations were added to before this one started. */
+    const Tracer::Clock::time_point start_; /**< When timing started. */
+
+  };
+
+  /**
+  * Add to a counter for the current frame.
+  * @param[in] counter The counter.
+  * @param[in] n The amount to add.
+  */
+  inline void ProfileCount(const ProfileCounter counter, const boost::int64_t n = 1) { Profiler::Instance().Count(counter, n); }
+
+#else
+
+  class ScopedTimer {
+
+  public:
+
+    explicit ScopedTimer(const ProfileStage) {}
+    void Stop() {}
+
+  };
+
+  inline void ProfileCount(const ProfileCounter, const boost::int64_t = 1) {}
+
+#endif
+
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef __RESULTS_WRITER_HPP__
+#define __RESULTS_WRITER_HPP__
+
+#include <string>
+#include <deque>
+#include <map>
+#include <fstream>
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "../headers.hpp"
+
+namespace ttrk {
+
+  /**
+  * @class ResultsWriter
+  * @brief Writes the tracking results to disk from a background thread so the tracker never waits on file I/O.
+  *
+  * Results are queued as records and written in batches, text files are flushed once per batch rather than once per line. Text records
+  * are always written, if too many are waiting WriteText blocks until the writer catches up. Frames for videos can be marked as droppable
+  * (for debug output) in which case they are discarded if the writer has fallen too far behind rather than making the queue grow.
+  */
+  class ResultsWriter {
+
+  public:
+
+    /**
+    * Start the writer thread.
+    * @param[in] max_queued_frames The number of frames that can be waiting to be written before droppable frames are discarded.
+    * @param[in] max_queued_texts The number of text records that can be waiting to be written before WriteText blocks.
+    * @param[in] fps The frame rate to write videos with.
+    */
+    explicit ResultsWriter(const size_t max_queued_frames = 16, const size_t max_queued_texts = 1024, const double fps = 25);
+
+    /**
+    * Write everything that is still queued and stop the writer thread.
+    */
+    ~ResultsWriter();
+
+    /**
+    * Append some text to a file. The file is truncated when it is first written to. Blocks if the text queue is full.
+    * @param[in] path The file to write to. Throws if it is empty.
+    * @param[in] text The text to append.
+    */
+    void WriteText(const std::string &path, const std::string &text);
+
+    /**
+    * Append a frame to a (MJPG) video file. The video is opened with the size of the first frame written to it.
+    * @param[in] path The video file to write to.
+    * @param[in] frame The frame. This must not be modified after it is passed in, clone it first if it is going to be reused.
+    * @param[in] droppable Whether this frame may be discarded if the queue is full.
+    */
+    void WriteFrame(const std::string &path, const cv::Mat &frame, const bool droppable);
+
+    /**
+    * Block until everything queued so far has been written.
+    */
+    void Flush();
+
+    /**
+    * Get the number of droppable frames which were discarded because the writer could not keep up.
+    * @return The number of dropped frames.
+    */
+    size_t GetNumberOfDroppedFrames() const { boost::lock_guard<boost::mutex> lock(mutex_); return dropped_frames_; }
+
+  protected:
+
+    /**
+    * @struct Record
+    * @brief A single piece of output waiting to be written.
+    */
+    struct Record {
+
+      std::string path; /**< The file to write to. */
+      std::string text; /**< The text to write, for text records. */
+      cv::Mat frame; /**< The frame to write, for video records. */
+
+    };
+
+    /**
+    * The main loop of the writer thread.
+    */
+    void Run();
+
+    /**
+    * Write a batch of records and flush any text files they touched.
+    * @param[in] batch The records to write.
+    */
+    void WriteBatch(std::deque<Record> &batch);
+
+    boost::thread thread_; /**< The writer thread. */
+    mutable boost::mutex mutex_; /**< Protects the queue and the counters. */
+    boost::condition_variable work_available_; /**< Signals the writer thread that there is work. */
+    boost::condition_variable batch_written_; /**< Signals waiting flushes that a batch has been written. */
+
+    std::deque<Record> queue_; /**< The records waiting to be written. */
+    size_t queued_frames_; /**< The number of frames in the queue. */
+    size_t queued_texts_; /**< The number of text records in the queue. */
+    size_t records_pushed_; /**< The number of records ever queued, used by Flush. */
+    size_t records_written_; /**< The number of records ever written. */
+    size_t dropped_frames_; /**< The number of droppable frames discarded. */
+    bool stop_; /**< Signal for the writer thread to finish. */
+
+    const size_t max_queued_frames_; /**< The number of frames that can wait in the queue before droppable frames are discarded. */
+    const size_t max_queued_texts_; /**< The number of text records that can wait in the queue before WriteText blocks. */
+    const double fps_; /**< Frame rate of the output videos. */
+
+    std::map<std::string, boost::shared_ptr<std::ofstream> > text_files_; /**< The open text files. Only used by the writer thread. */
+    std::map<std::string, boost::shared_ptr<cv::VideoWriter> > video_files_; /**< The open videos. Only used by the writer thread. */
+
+  private:
+
+    ResultsWriter(const ResultsWriter &);
+    ResultsWriter &operator=(const ResultsWriter &);
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef __SCRATCH_ARENA_HPP__
+#define __SCRATCH_ARENA_HPP__
+
+#include <vector>
+
+#include "../headers.hpp"
+
+namespace ttrk {
+
+  /**
+  * @class ScratchArena
+  * @brief A pool of image buffers for the temporaries a localizer needs on every step.
+  *
+  * Acquire hands out a header over a pooled buffer of the requested size and type which nothing else references, allocating a new one only
+  * if there is no such buffer. A buffer goes back to the pool when the last header to it is released, so once the pool has warmed up on the
+  * first step a step allocates no image memory at all. As the buffers are reference counted, a header which is kept after the step (e.g.
+  * stored in a model) keeps its buffer out of the pool rather than having it handed out again. It is not thread safe, each localizer has
+  * its own.
+  */
+  class ScratchArena {
+
+  public:
+
+    /**
+    * Get a buffer. The contents are whatever was last written to it.
+    * @param[in] size The image size.
+    * @param[in] type The OpenCV type.
+    * @return A header over the buffer.
+    */
+    cv::Mat Acquire(const cv::Size &size, const int type);
+
+    /**
+    * Get a buffer filled with zeros, the pooled equivalent of cv::Mat::zeros.
+    * @param[in] size The image size.
+    * @param[in] type The OpenCV type.
+    * @return A header over the buffer.
+    */
+    cv::Mat AcquireZeros(const cv::Size &size, const int type);
+
+    /**
+    * Release all of the pooled buffers. Headers which are still held keep their buffers alive.
+    */
+    void Clear() { buffers_.clear(); }
+
+    /**
+    * Get the number of buffers in the pool.
+    * @return The number of buffers.
+    */
+    size_t GetNumberOfBuffers() const { return buffers_.size(); }
+
+  protected:
+
+    std::vector<cv::Mat> buffers_; /**< The pooled buffers. */
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef __TRACER_HPP__
+#define __TRACER_HPP__
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <fstream>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/chrono.hpp>
+
+namespace ttrk {
+
+  /**
+  * @class Tracer
+  * @brief Records begin/end spans from any thread and writes them as a Chrome trace (load the file in chrome://tracing).
+  *
+  * Each thread records into its own chunk of events so recording a span never takes a lock or touches another thread's memory. Full
+  * chunks are pushed onto a lock-free list and a background thread periodically drains them (and the filled part of each thread's current
+  * chunk) to the trace file, so the trace can be left running for long sequences. When tracing is off recording a span is a single
+  * atomic load.
+  */
+  class Tracer {
+
+  public:
+
+    typedef boost::chrono::high_resolution_clock Clock;
+
+    /**
+    * Get the tracer shared by the whole process.
+    * @return The tracer.
+    */
+    static Tracer &Instance();
+
+    /**
+    * Check if spans are being recorded.
+    * @return True if the tracer is running.
+    */
+    static bool IsEnabled() { return Instance().enabled_.load(std::memory_order_relaxed); }
+
+    /**
+    * Start recording spans to a trace file, truncating it if it exists. Does nothing if the tracer is already running.
+    * @param[in] path The file to write the trace to.
+    */
+    void Start(const std::string &path);
+
+    /**
+    * Stop recording, write everything recorded so far and close the trace file.
+    */
+    void Stop();
+
+    /**
+    * Record a completed span on the calling thread. Does nothing if the tracer is not running.
+    * @param[in] name The name of the span. This must be a string literal (or otherwise outlive the tracer) as only the pointer is stored.
+    * @param[in] begin When the span started.
+    * @param[in] end When the span finished.
+    */
+    void Record(const char *name, const Clock::time_point &begin, const Clock::time_point &end);
+
+    /**
+    * Name the calling thread in the trace.
+    * @param[in] name The name of the thread.
+    */
+    void SetThreadName(const std::string &name);
+
+  protected:
+
+    /**
+    * @struct Event
+    * @brief A single completed span.
+    */
+    struct Event {
+
+      const char *name; /**< The name of the span. */
+      boost::int64_t begin; /**< The start of the span in microseconds since the tracer started. */
+      boost::int64_t duration; /**< The length of the span in microseconds. */
+
+    };
+
+    /**
+    * @struct Chunk
+    * @brief A block of events recorded by one thread. Only the owning thread writes events, only the flushing thread reads them.
+    */
+    struct Chunk {
+
+      enum { CAPACITY = 4096 };
+
+      Chunk(const boost::uint32_t thread_id) : thread_id(thread_id), size(0), exported(0), next(0x0) {}
+
+      const boost::uint32_t thread_id; /**< The id of the thread which recorded the events. */
+      Event events[CAPACITY]; /**< The events. */
+      std::atomic<size_t> size; /**< The number of events recorded, published after each event is written. */
+      size_t exported; /**< The number of events already written to the file. Only used by the flushing thread. */
+      Chunk *next; /**< The next chunk in the list of full chunks. */
+
+    };
+
+    /**
+    * @struct ThreadState
+    * @brief The recording state of a single thread. Owned by the tracer so it outlives the thread.
+    */
+    struct ThreadState {
+
+      boost::uint32_t id; /**< The thread id written to the trace. */
+      std::string name; /**< The name of the thread, if it has been given one. */
+      std::atomic<Chunk *> current; /**< The chunk the thread is recording into. */
+
+    };
+
+    Tracer();
+
+    /**
+    * Cleanup function for thread_state_. The thread states are owned by the tracer so they can still be flushed after their thread exits.
+    */
+    static void KeepThreadState(ThreadState *) {}
+
+    /**
+    * Get (creating and registering on first use) the state for the calling thread.
+    * @return The state.
+    */
+    ThreadState *GetThreadState();
+
+    /**
+    * Write out every event recorded since the last flush. Only called by one thread at a time.
+    */
+    void Flush();
+
+    /**
+    * Write any events in a chunk which have not been written yet.
+    * @param[in] chunk The chunk.
+    * @param[in] end The number of events in the chunk which are safe to read.
+    */
+    void WriteEvents(Chunk *chunk, const size_t end);
+
+    /**
+    * The main loop of the flushing thread.
+    */
+    void Run();
+
+    std::atomic<bool> enabled_; /**< Whether spans are being recorded. */
+    std::atomic<Chunk *> full_chunks_; /**< Lock-free stack of chunks waiting to be written. */
+    Clock::time_point origin_; /**< The time the trace started. */
+
+    boost::mutex threads_mutex_; /**< Protects the list of threads, only taken the first time a thread records. */
+    std::vector<boost::shared_ptr<ThreadState> > threads_; /**< Every thread which has recorded a span. */
+    boost::thread_specific_ptr<ThreadState> thread_state_; /**< The calling thread's entry in threads_. */
+
+    boost::mutex flush_mutex_; /**< Serializes Start, Stop and flushes of the trace file. */
+    boost::thread flush_thread_; /**< Periodically drains the recorded events to the file. */
+    std::ofstream ofs_; /**< The trace file. */
+    bool first_event_; /**< Whether the next event written is the first in the file (so needs no separator). */
+
+  private:
+
+    Tracer(const Tracer &);
+    Tracer &operator=(const Tracer &);
+
+  };
+
+  /**
+  * @class TraceScope
+  * @brief Records a span covering the lifetime of the object.
+  */
+  class TraceScope {
+
+  public:
+
+    /**
+    * Start the span if the tracer is running.
+    * @param[in] name The name of the span. Must be a string literal.
+    */
+    explicit TraceScope(const char *name) : name_(Tracer::IsEnabled() ? name : 0x0) {
+      if (name_) begin_ = Tracer::Clock::now();
+    }
+
+    /**
+    * Finish the span.
+    */
+    ~TraceScope() {
+      if (name_) Tracer::Instance().Record(name_, begin_, Tracer::Clock::now());
+    }
+
+  protected:
+
+    const char *name_; /**< The name of the span, null if the tracer was off when the span started. */
+    Tracer::Clock::time_point begin_; /**< When the span started. */
+
+  private:
+
+    TraceScope(const TraceScope &);
+    TraceScope &operator=(const TraceScope &);
+
+  };
+
+}
+
+#endif
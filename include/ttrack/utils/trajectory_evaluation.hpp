@@ -0,0 +1,75 @@
+#ifndef __TRAJECTORY_EVALUATION_HPP__
+#define __TRAJECTORY_EVALUATION_HPP__
+
+#include <string>
+#include <vector>
+
+#include "trajectory_log.hpp"
+
+namespace ttrk {
+
+  /**
+  * @struct PoseError
+  * @brief The difference between an estimated pose and the true pose, with poses in the order of Model::GetPose.
+  */
+  struct PoseError {
+
+    PoseError() : translation(0.0f), rotation(0.0f), articulation(0.0f) {}
+
+    float translation; /**< Distance between the translations, in the units of the model (mm). */
+    float rotation; /**< Angle of the rotation between the two orientations, in degrees. */
+    float articulation; /**< Mean absolute difference of the articulated DOFs. Zero for rigid models. */
+
+  };
+
+  /**
+  * @struct TrajectoryEvaluation
+  * @brief Speed and accuracy of a tracked trajectory compared to the ground truth.
+  */
+  struct TrajectoryEvaluation {
+
+    TrajectoryEvaluation() : frames(0), fps(0), mean_latency(0), p99_latency(0), mean_iterations(0), mean_translation_error(0), max_translation_error(0), mean_rotation_error(0), max_rotation_error(0), mean_articulation_error(0), final_translation_error(0), final_rotation_error(0) {}
+
+    size_t frames; /**< The number of frames compared. */
+    double fps; /**< Frames per second, from the load and tracking time of each frame. */
+    double mean_latency; /**< Mean load and tracking time of a frame in milliseconds. */
+    double p99_latency; /**< 99th percentile load and tracking time of a frame in milliseconds. */
+    double mean_iterations; /**< The mean number of localizer iterations per frame. */
+    double mean_translation_error; /**< Mean translation error. */
+    double max_translation_error; /**< Largest translation error. */
+    double mean_rotation_error; /**< Mean rotation error in degrees. */
+    double max_rotation_error; /**< Largest rotation error in degrees. */
+    double mean_articulation_error; /**< Mean articulation error. */
+    double final_translation_error; /**< Translation error on the last frame compared, i.e. how far the tracker has drifted. */
+    double final_rotation_error; /**< Rotation error in degrees on the last frame compared. */
+
+  };
+
+  /**
+  * Compare an estimated pose to the true pose.
+  * @param[in] estimate The estimated pose: translation, rotation quaternion (w, x, y, z) then any articulated DOFs.
+  * @param[in] truth The true pose in the same layout.
+  * @return The error.
+  */
+  PoseError ComputePoseError(const std::vector<float> &estimate, const std::vector<float> &truth);
+
+  /**
+  * Read a pose file in the format written by Model::GetPoseAsString, one pose per non-empty line.
+  * @param[in] path The file to read.
+  * @return The poses in the order they appear in the file.
+  */
+  std::vector<std::vector<float> > ReadPoseFile(const std::string &path);
+
+  /**
+  * Compare the poses in a trajectory log to the ground truth. Records are matched to ground truth poses by frame index, records with no ground
+  * truth pose are ignored.
+  * @param[in] log The tracked trajectory.
+  * @param[in] ground_truth The true pose for each frame.
+  * @param[in] first_frame_index The frame index of the first ground truth pose in the log. The tracker numbers frames from 1.
+  * @return The evaluation.
+  */
+  TrajectoryEvaluation EvaluateTrajectory(const TrajectoryLogReader &log, const std::vector<std::vector<float> > &ground_truth, const size_t first_frame_index = 1);
+
+}
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef __TRAJECTORY_LOG_HPP__
+#define __TRAJECTORY_LOG_HPP__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace ttrk {
+
+  /**
+  * @struct TrajectoryRecord
+  * @brief The tracking results for a single model in a single frame.
+  */
+  struct TrajectoryRecord {
+
+    TrajectoryRecord() : frame_index(0), timestamp(0.0), score(0.0f), iterations(0) {}
+
+    boost::uint64_t frame_index; /**< The index of the frame in the input. */
+    double timestamp; /**< Seconds since the log was created. */
+    float score; /**< The localizer's error/convergence score when it stopped. */
+    boost::uint32_t iterations; /**< The number of localizer iterations run on this frame. */
+    std::vector<float> dofs; /**< The value of each degree of freedom of the model, in the order of Model::GetPose. */
+    std::vector<float> timings; /**< The time in seconds spent in each stage, in the order of the stage names in the header. */
+
+  };
+
+  /**
+  * @struct TrajectoryLogHeader
+  * @brief The fixed size header at the start of a trajectory log.
+  *
+  * The header is followed by blocks of records. Each block is a TrajectoryBlockHeader followed by the records stored column by column:
+  * frame indexes (uint64), timestamps (double), scores (float), iterations (uint32), then one float column per DOF and one float column per
+  * stage timing. Blocks are padded to a multiple of 8 bytes. All values are little endian.
+  */
+  struct TrajectoryLogHeader {
+
+    enum { MAX_STAGES = 16, MAX_STAGE_NAME = 32, VERSION = 1 };
+
+    char magic[8]; /**< "TTRKTRJ" null terminated. */
+    boost::uint32_t version; /**< The format version. */
+    boost::uint32_t num_dofs; /**< The number of DOFs in each record. */
+    boost::uint32_t num_stages; /**< The number of stage timings in each record. */
+    boost::uint32_t block_capacity; /**< The maximum number of records in a block. */
+    double start_time; /**< The time the log was created in seconds since the epoch. */
+    char stage_names[MAX_STAGES][MAX_STAGE_NAME]; /**< The names of the timed stages. */
+
+  };
+
+  /**
+  * @struct TrajectoryBlockHeader
+  * @brief The header at the start of each block of records.
+  */
+  struct TrajectoryBlockHeader {
+
+    boost::uint32_t magic; /**< BLOCK_MAGIC. */
+    boost::uint32_t num_records; /**< The number of records in this block. */
+
+  };
+
+  /**
+  * @class TrajectoryLogWriter
+  * @brief Append-only writer for the binary trajectory log.
+  *
+  * Records are buffered and written a block at a time so the file is only touched every block_capacity frames.
+  */
+  class TrajectoryLogWriter {
+
+  public:
+
+    /**
+    * Create the log file, truncating it if it exists.
+    * @param[in] path The file to write.
+    * @param[in] num_dofs The number of DOFs in each record.
+    * @param[in] stage_names The names of the timed stages, at most TrajectoryLogHeader::MAX_STAGES.
+    * @param[in] block_capacity The number of records to buffer before writing a block.
+    */
+    TrajectoryLogWriter(const std::string &path, const size_t num_dofs, const std::vector<std::string> &stage_names, const size_t block_capacity = 64);
+
+    /**
+    * Write any buffered records and close the file.
+    */
+    ~TrajectoryLogWriter();
+
+    /**
+    * Add a record to the log. Missing DOFs or timings are written as zero, extra ones are ignored.
+    * @param[in] record The record to add.
+    */
+    void Append(const TrajectoryRecord &record);
+
+    /**
+    * Write the buffered records as a (possibly partial) block.
+    */
+    void Flush();
+
+    /**
+    * Get the time since the log was created, for the record timestamps.
+    * @return The time in seconds.
+    */
+    double GetElapsedTime() const;
+
+    /**
+    * Get the number of DOFs in each record.
+    * @return The number of DOFs.
+    */
+    size_t GetNumberOfDofs() const { return header_.num_dofs; }
+
+  protected:
+
+    std::ofstream ofs_; /**< The log file. */
+    TrajectoryLogHeader header_; /**< The log header. */
+    std::vector<TrajectoryRecord> buffer_; /**< Records waiting to be written. */
+
+  };
+
+  /**
+  * @class TrajectoryLogReader
+  * @brief Reads a trajectory log by memory mapping it.
+  *
+  * Whole columns can be pulled out without touching the rest of the records.
+  */
+  class TrajectoryLogReader {
+
+  public:
+
+    /**
+    * Map the log file and index its blocks. Throws if the file is not a trajectory log.
+    * @param[in] path The file to read.
+    */
+    explicit TrajectoryLogReader(const std::string &path);
+
+    /**
+    * Get the total number of records in the log.
+    * @return The number of records.
+    */
+    size_t GetNumberOfRecords() const { return num_records_; }
+
+    /**
+    * Get the number of DOFs in each record.
+    * @return The number of DOFs.
+    */
+    size_t GetNumberOfDofs() const { return header_.num_dofs; }
+
+    /**
+    * Get the names of the timed stages.
+    * @return The stage names.
+    */
+    std::vector<std::string> GetStageNames() const;
+
+    /**
+    * Get the time the log was created.
+    * @return The time in seconds since the epoch.
+    */
+    double GetStartTime() const { return header_.start_time; }
+
+    /**
+    * Read a single record.
+    * @param[in] idx The index of the record.
+    * @return The record.
+    */
+    TrajectoryRecord GetRecord(const size_t idx) const;
+
+    /**
+    * Read the frame index of every record.
+    * @param[out] frame_indexes The frame indexes.
+    */
+    void GetFrameIndexes(std::vector<boost::uint64_t> &frame_indexes) const;
+
+    /**
+    * Read the values of a single DOF for every record.
+    * @param[in] dof The index of the DOF.
+    * @param[out] values The values.
+    */
+    void GetDof(const size_t dof, std::vector<float> &values) const;
+
+    /**
+    * Read the timings of a single stage for every record.
+    * @param[in] stage The index of the stage.
+    * @param[out] values The timings.
+    */
+    void GetStageTiming(const size_t stage, std::vector<float> &values) const;
+
+    /**
+    * Write the log as a CSV file with one row per record.
+    * @param[in] path The CSV file to write.
+    */
+    void WriteCSV(const std::string &path) const;
+
+    /**
+    * Write the DOFs in the text format written by Model::GetPoseAsString.
+    * @param[in] path The file to write.
+    */
+    void WritePoseText(const std::string &path) const;
+
+  protected:
+
+    /**
+    * @struct Block
+    * @brief The location of a block of records in the mapped file.
+    */
+    struct Block {
+
+      const char *data; /**< The first column of the block. */
+      size_t num_records; /**< The number of records in the block. */
+      size_t first_record; /**< The index of the first record in the block. */
+
+    };
+
+    /**
+    * Get a pointer to the start of a column in a block.
+    * @param[in] block The block.
+    * @param[in] column The index of the column, 0-3 for the fixed columns then the DOFs then the timings.
+    * @return The start of the column.
+    */
+    const char *GetColumn(const Block &block, const size_t column) const;
+
+    boost::scoped_ptr<boost::interprocess::file_mapping> file_; /**< The log file. */
+    boost::scoped_ptr<boost::interprocess::mapped_region> region_; /**< The mapping of the whole file. */
+
+    TrajectoryLogHeader header_; /**< A copy of the log header. */
+    std::vector<Block> blocks_; /**< The blocks in the log. */
+    size_t num_records_; /**< The total number of records. */
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef __TRIPLE_BUFFER_HPP__
+#define __TRIPLE_BUFFER_HPP__
+
+#include <atomic>
+
+namespace ttrk {
+
+  /**
+  * @class TripleBuffer
+  * @brief A lock-free single producer/single consumer exchange of the most recent value.
+  *
+  * The writer fills the write slot and publishes it, the reader picks up whatever was published most recently. Neither side ever
+  * waits for the other: if the writer publishes several times between reads the older values are simply overwritten and if the reader
+  * polls faster than the writer it just keeps the slot it already has. Exactly one thread may write and exactly one thread may read.
+  */
+  template<typename T>
+  class TripleBuffer {
+
+  public:
+
+    /**
+    * Construct the buffer. Slot 0 is the write slot, slot 1 is the (clean) middle slot and slot 2 is the read slot.
+    */
+    TripleBuffer() : write_idx_(0), middle_(1), read_idx_(2) {}
+
+    /**
+    * Get the slot that the writer may fill. Only valid on the writer thread and only until the next call to Publish.
+    * @return The write slot.
+    */
+    T &GetWriteBuffer() { return buffers_[write_idx_]; }
+
+    /**
+    * Publish the write slot to the reader and take ownership of a new write slot.
+    */
+    void Publish() {
+      write_idx_ = middle_.exchange(write_idx_ | DIRTY_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /**
+    * Swap in the most recently published slot, if there is one.
+    * @return True if a new value was published since the last call, false if the read slot is unchanged.
+    */
+    bool Update() {
+      if ((middle_.load(std::memory_order_acquire) & DIRTY_BIT) == 0) return false;
+      read_idx_ = middle_.exchange(read_idx_, std::memory_order_acq_rel) & INDEX_MASK;
+      return true;
+    }
+
+    /**
+    * Get the slot that the reader currently owns. Only valid on the reader thread and only until the next call to Update.
+    * @return The read slot.
+    */
+    const T &GetReadBuffer() const { return buffers_[read_idx_]; }
+
+  protected:
+
+    enum { INDEX_MASK = 0x3, DIRTY_BIT = 0x4 };
+
+    T buffers_[3]; /**< The three slots. At any time one is owned by the writer, one by the reader and one is in the middle. */
+
+    int write_idx_; /**< The slot owned by the writer. */
+    std::atomic<int> middle_; /**< The slot in the middle along with a flag indicating whether it holds a value the reader has not seen yet. */
+    int read_idx_; /**< The slot owned by the reader. */
+
+  private:
+
+    TripleBuffer(const TripleBuffer &);
+    TripleBuffer &operator=(const TripleBuffer &);
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,529 @@
+#include <cinder/app/AppNative.h>
+#include <CinderOpenCV.h>
+#include <boost/filesystem.hpp>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../include/ttrack/headers.hpp"
+#include "../include/ttrack/constants.hpp"
+#include "../include/ttrack/ttrack.hpp"
+#include "../include/ttrack/utils/camera.hpp"
+#include "../include/ttrack/utils/config_reader.hpp"
+#include "../include/ttrack/utils/benchmark.hpp"
+#include "../include/ttrack/track/model/articulated_model.hpp"
+#include "../include/ttrack/track/localizer/levelsets/stereo_pwp3d.hpp"
+#include "../include/ttrack/track/localizer/levelsets/comp_ls.hpp"
+#include "../include/ttrack/track/localizer/levelsets/articulated_level_set.hpp"
+#include "../include/ttrack/track/localizer/levelsets/level_set_forest.hpp"
+#include "../include/ttrack/track/localizer/features/lk_tracker.hpp"
+#include "../include/ttrack/detect/multiclass_randomforest.hpp"
+#include "../include/ttrack/detect/histogram.hpp"
+
+using namespace ci;
+using namespace ci::app;
+using namespace ttrk;
+
+namespace {
+
+  /**
+  * @class KernelAccess
+  * @brief Exposes the protected kernels of a localizer so they can be timed in isolation and lets the band width be changed.
+  */
+  template<typename LocalizerBase>
+  class KernelAccess : public LocalizerBase {
+
+  public:
+
+    template<typename... Args>
+    explicit KernelAccess(Args&&... args) : LocalizerBase(std::forward<Args>(args)...) {}
+
+    void SetBandWidth(const int width) { this->HEAVYSIDE_WIDTH = width; this->heaviside_table_.SetWidth(width); }
+
+    using LocalizerBase::ComputeJacobiansForEye;
+    using LocalizerBase::ComputeSDFImageAndSetProgressFrame;
+    using LocalizerBase::ComputeIntersectionImages;
+
+  };
+
+  /**
+  * @class ForestAccess
+  * @brief Exposes the training and the Gabor filter of the random forest.
+  */
+  class ForestAccess : public MultiClassRandomForest {
+
+  public:
+
+    explicit ForestAccess(const size_t num_classes) : MultiClassRandomForest(num_classes) {}
+
+    using MultiClassRandomForest::ClassifyFrame;
+    using RandomForest::TrainClassifier;
+    using BaseClassifier::GetGabor;
+
+  };
+
+  /**
+  * @struct ResolutionFixture
+  * @brief Everything the kernels need at one resolution: the camera, the localizers built for it and a synthetic frame of the model.
+  */
+  struct ResolutionFixture {
+
+    std::string name; /**< The resolution as WxH. */
+    boost::shared_ptr<StereoCamera> camera; /**< The camera, scaled from the calibration file. */
+
+    boost::shared_ptr<KernelAccess<StereoPWP3D> > pwp3d; /**< Single region level set localizer. */
+    boost::shared_ptr<KernelAccess<ComponentLevelSet> > comp_ls; /**< Multiple component level set localizer. */
+    boost::shared_ptr<KernelAccess<ArticulatedComponentLevelSet> > articulated; /**< Articulated localizer, only created for articulated models. */
+    boost::shared_ptr<LKTracker> lk; /**< Point tracker on the left eye. */
+
+    boost::shared_ptr<sv::StereoFrame> frame; /**< Synthetic stereo frame with a classification map from the rendered model. */
+    cv::Mat shifted_left_image; /**< The left image moved by a few pixels, for tracking points. */
+    cv::Mat stereo_sdf; /**< Side by side signed distance function of both eyes. */
+
+    cv::Mat front_depth, back_depth, contour; /**< Render of the model from the left eye. */
+    cv::Mat sdf, front_intersection, back_intersection; /**< The left eye level set and intersection images. */
+    cv::Mat silhouette; /**< Mask of the largest blob of the model in the left eye. */
+    std::vector<cv::Point> silhouette_contour; /**< The outline of the silhouette. */
+
+  };
+
+  std::vector<float> ParseList(const std::string &str){
+
+    std::vector<float> values;
+    std::stringstream ss(str);
+    float x;
+    while (ss >> x) values.push_back(x);
+    return values;
+
+  }
+
+  //the occlusion image is shared by all localizers and sized by whichever was constructed last so reset it for the resolution being timed
+  void ResetOcclusionImage(const cv::Size &size){
+
+    Localizer::occlusion_image = cv::Mat(size, CV_32FC1, cv::Scalar(GL_FAR));
+
+  }
+
+  std::string WriteScaledCalibration(const std::string &calibration_file, const float scale, const std::string &output_dir){
+
+    cv::FileStorage in(calibration_file, cv::FileStorage::READ);
+    if (!in.isOpened()) throw std::runtime_error("Error, could not open camera calibration file: " + calibration_file);
+
+    cv::Mat image_dims, l_intrinsic, l_distortion, r_intrinsic, r_distortion, rotation, translation;
+    in["Image_Dimensions"] >> image_dims;
+    in["Left_Camera_Matrix"] >> l_intrinsic;
+    in["Left_Distortion_Coefficients"] >> l_distortion;
+    in["Right_Camera_Matrix"] >> r_intrinsic;
+    in["Right_Distortion_Coefficients"] >> r_distortion;
+    in["Extrinsic_Camera_Rotation"] >> rotation;
+    in["Extrinsic_Camera_Translation"] >> translation;
+
+    //scaling the image scales the focal lengths and principal point, the distortion and extrinsics are unchanged
+    image_dims.at<int>(0) = (int)(image_dims.at<int>(0) * scale + 0.5f);
+    image_dims.at<int>(1) = (int)(image_dims.at<int>(1) * scale + 0.5f);
+    l_intrinsic.rowRange(0, 2) *= scale;
+    r_intrinsic.rowRange(0, 2) *= scale;
+
+    std::stringstream ss;
+    ss << output_dir << "/camera_" << image_dims.at<int>(0) << "x" << image_dims.at<int>(1) << ".xml";
+
+    cv::FileStorage out(ss.str(), cv::FileStorage::WRITE);
+    out << "Left_Camera_Matrix" << l_intrinsic << "Left_Distortion_Coefficients" << l_distortion;
+    out << "Right_Camera_Matrix" << r_intrinsic << "Right_Distortion_Coefficients" << r_distortion;
+    out << "Extrinsic_Camera_Rotation" << rotation << "Extrinsic_Camera_Translation" << translation;
+    out << "Image_Dimensions" << image_dims;
+
+    return ss.str();
+
+  }
+
+  //textured background with the model drawn as a noisy grey silhouette
+  cv::Mat MakeSyntheticEye(const cv::Mat &sdf, cv::RNG &rng){
+
+    cv::Mat eye(sdf.size(), CV_8UC3);
+    rng.fill(eye, cv::RNG::UNIFORM, cv::Scalar(0, 0, 60), cv::Scalar(120, 140, 255));
+    cv::GaussianBlur(eye, eye, cv::Size(0, 0), 3);
+
+    cv::Mat noise(sdf.size(), CV_8UC3);
+    rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(160), cv::Scalar::all(25));
+    noise.copyTo(eye, sdf >= 0);
+
+    return eye;
+
+  }
+
+  //a soft classification from the level set, splitting the model into left and right halves when there is more than one foreground label
+  void FillClassificationMap(const cv::Mat &sdf, const size_t number_of_labels, cv::Mat classification_map){
+
+    cv::Moments m = cv::moments(sdf >= 0, true);
+    const float centre_col = m.m00 > 0 ? (float)(m.m10 / m.m00) : sdf.cols / 2.0f;
+
+    for (int r = 0; r < sdf.rows; ++r){
+      for (int c = 0; c < sdf.cols; ++c){
+
+        float *probabilities = classification_map.ptr<float>(r) + c * classification_map.channels();
+        std::fill(probabilities, probabilities + classification_map.channels(), 0.0f);
+
+        const float foreground = 1.0f / (1.0f + std::exp(-sdf.at<float>(r, c) / 2.0f));
+        const size_t label = (number_of_labels > 2 && c > centre_col) ? 2 : 1;
+
+        probabilities[0] = 1.0f - foreground;
+        probabilities[std::min<size_t>(label, classification_map.channels() - 1)] = foreground;
+
+      }
+    }
+
+  }
+
+  //per pixel features as used by MultiClassRandomForest::ClassifyFrame
+  void BuildForestTrainingData(ForestAccess &forest, const cv::Mat &image, const cv::Mat &classification_map, cv::Mat &training_data, cv::Mat &training_labels){
+
+    cv::Mat whole_frame;
+    image.convertTo(whole_frame, CV_32F, 1.0 / 255);
+
+    cv::Mat gabor, lab;
+    forest.GetGabor(whole_frame, gabor);
+    cv::cvtColor(whole_frame, lab, CV_BGR2Lab);
+
+    training_data = cv::Mat(0, 4, CV_32FC1);
+    training_labels = cv::Mat(0, 1, CV_32SC1);
+
+    for (int r = 0; r < image.rows; r += 4){
+      for (int c = 0; c < image.cols; c += 4){
+
+        const cv::Vec3f &bgr = whole_frame.at<cv::Vec3f>(r, c);
+        cv::Mat sample = (cv::Mat_<float>(1, 4) << bgr[2], lab.at<cv::Vec3f>(r, c)[1], 0.5f * (bgr[2] - bgr[1]), gabor.at<float>(r, c));
+        training_data.push_back(sample);
+
+        const float *probabilities = classification_map.ptr<float>(r) + c * classification_map.channels();
+        training_labels.push_back((int)(std::max_element(probabilities, probabilities + classification_map.channels()) - probabilities));
+
+      }
+    }
+
+  }
+
+}
+
+/**
+* @class BenchmarkApp
+* @brief Times the hot kernels of the tracker on synthetic frames over a range of resolutions and level set band widths.
+*
+* Run with a config file in the same format as the tracking app (see examples/benchmark.cfg). The model is rendered into a synthetic
+* stereo frame at each resolution, the kernels are timed and the results written as CSV. If a baseline CSV is given the run fails
+* when a kernel has slowed down by more than the tolerance.
+*/
+class BenchmarkApp : public AppNative {
+
+public:
+
+  void setup();
+  void draw() {}
+
+protected:
+
+  void SetupFixtures(const ConfigReader &reader);
+  void AddCases(Benchmark &benchmark, const std::vector<int> &band_widths);
+
+  boost::shared_ptr<Model> model_;
+  size_t number_of_labels_;
+  std::string output_dir_;
+
+  std::vector<ResolutionFixture> fixtures_;
+  boost::shared_ptr<ForestAccess> forest_;
+  boost::shared_ptr<Histogram> histogram_;
+  EllipticalFourierDescriptorBuilder efd_builder_;
+
+};
+
+void BenchmarkApp::SetupFixtures(const ConfigReader &reader){
+
+  const std::string root_dir = reader.get_element("root-dir");
+  output_dir_ = reader.get_element("output-dir");
+  if (!boost::filesystem::is_directory(output_dir_)) boost::filesystem::create_directories(output_dir_);
+
+  number_of_labels_ = 3;
+  try{
+    number_of_labels_ = reader.get_element_as_type<size_t>("num-labels");
+  }
+  catch (std::runtime_error &){}
+
+  bool articulated = false;
+  try{
+    articulated = reader.get_element_as_type<int>("benchmark-articulated") != 0;
+  }
+  catch (std::runtime_error &){}
+
+  std::vector<float> scales(1, 1.0f);
+  try{
+    scales = ParseList(reader.get_element("benchmark-scales"));
+  }
+  catch (std::runtime_error &){}
+
+  model_.reset(new DenavitHartenbergArticulatedModel(reader.get_element("trackable"), output_dir_ + "/benchmark_model.txt"));
+
+  //same layout as starting-pose-N for the tracker
+  const std::vector<float> p = TTrack::PoseFromString(reader.get_element("starting-pose-0"));
+  ci::Matrix33f r(p[0], p[4], p[8], p[1], p[5], p[9], p[2], p[6], p[10]);
+  model_->SetBasePose(Pose(ci::Quatf(r), ci::Vec3f(p[3], p[7], p[11])));
+  model_->UpdatePose(std::vector<float>({ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, p[12], p[13], p[14] / 2, p[14] / 2 }));
+
+  cv::RNG rng(1234);
+
+  for (auto scale : scales){
+
+    ResolutionFixture f;
+    f.camera.reset(new StereoCamera(WriteScaledCalibration(root_dir + "/" + reader.get_element("camera-config"), scale, output_dir_)));
+
+    const cv::Size size(f.camera->left_eye()->Width(), f.camera->left_eye()->Height());
+    std::stringstream ss;
+    ss << size.width << "x" << size.height;
+    f.name = ss.str();
+
+    f.pwp3d.reset(new KernelAccess<StereoPWP3D>(f.camera));
+    f.comp_ls.reset(new KernelAccess<ComponentLevelSet>(number_of_labels_, f.camera));
+    if (articulated) f.articulated.reset(new KernelAccess<ArticulatedComponentLevelSet>(11, number_of_labels_, f.camera));
+    f.lk.reset(new LKTracker(f.camera->left_eye()));
+    model_->cam = f.camera->left_eye();
+
+    ResetOcclusionImage(size);
+
+    //render both eyes once to build the synthetic frame
+    cv::Mat right_front_depth, right_back_depth, right_contour, right_front_intersection, right_back_intersection;
+    f.pwp3d->RenderModelForDepthAndContour(model_, f.camera->right_eye(), right_front_depth, right_back_depth, right_contour);
+    f.pwp3d->ComputeIntersectionImages(f.camera->right_eye(), right_front_depth, right_back_depth, right_front_intersection, right_back_intersection);
+    cv::Mat right_sdf = f.pwp3d->ComputeSDFImageAndSetProgressFrame(right_contour, right_front_intersection);
+
+    f.pwp3d->RenderModelForDepthAndContour(model_, f.camera->left_eye(), f.front_depth, f.back_depth, f.contour);
+    f.pwp3d->ComputeIntersectionImages(f.camera->left_eye(), f.front_depth, f.back_depth, f.front_intersection, f.back_intersection);
+    f.sdf = f.pwp3d->ComputeSDFImageAndSetProgressFrame(f.contour, f.front_intersection);
+
+    cv::Mat left_image = MakeSyntheticEye(f.sdf, rng), right_image = MakeSyntheticEye(right_sdf, rng), stereo_image;
+    cv::hconcat(left_image, right_image, stereo_image);
+    cv::hconcat(f.sdf, right_sdf, f.stereo_sdf);
+
+    f.frame.reset(new sv::StereoFrame(stereo_image));
+    FillClassificationMap(f.sdf, number_of_labels_, f.frame->GetLeftClassificationMap());
+    FillClassificationMap(right_sdf, number_of_labels_, f.frame->GetRightClassificationMap());
+
+    f.pwp3d->SetFrame(f.frame);
+    f.comp_ls->SetFrame(f.frame);
+    if (f.articulated) f.articulated->SetFrame(f.frame);
+
+    const cv::Mat translation = (cv::Mat_<double>(2, 3) << 1, 0, 2, 0, 1, 1);
+    cv::warpAffine(left_image, f.shifted_left_image, translation, left_image.size(), cv::INTER_LINEAR, cv::BORDER_REFLECT);
+
+    std::vector<std::vector<cv::Point> > contours;
+    cv::Mat mask = f.sdf >= 0;
+    cv::findContours(mask, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
+    if (contours.empty()) throw std::runtime_error("Error, the model is not visible at " + f.name + ", check the starting pose.");
+
+    auto largest = std::max_element(contours.begin(), contours.end(), [](const std::vector<cv::Point> &a, const std::vector<cv::Point> &b) { return a.size() < b.size(); });
+    f.silhouette_contour = *largest;
+    f.silhouette = cv::Mat::zeros(size, CV_8UC1);
+    cv::drawContours(f.silhouette, std::vector<std::vector<cv::Point> >(1, f.silhouette_contour), 0, cv::Scalar(255), CV_FILLED);
+
+    fixtures_.push_back(f);
+
+  }
+
+  if (fixtures_.empty()) throw std::runtime_error("Error, no benchmark resolutions given.");
+
+  //classifiers are trained once, on the first resolution
+  const ResolutionFixture &f = fixtures_.front();
+
+  forest_.reset(new ForestAccess(number_of_labels_));
+  cv::Mat training_data, training_labels;
+  BuildForestTrainingData(*forest_, f.frame->GetLeftImage(), f.frame->GetLeftClassificationMap(), training_data, training_labels);
+  forest_->TrainClassifier(training_data, training_labels);
+
+  const std::string histogram_image = output_dir_ + "/histogram_image.png", histogram_mask = output_dir_ + "/histogram_mask.png", histogram_config = output_dir_ + "/histogram.txt";
+  cv::imwrite(histogram_image, f.frame->GetLeftImage());
+  cv::imwrite(histogram_mask, f.silhouette);
+  std::ofstream histogram_ofs(histogram_config.c_str());
+  histogram_ofs << histogram_image << "\n" << histogram_mask << "\n";
+  histogram_ofs.close();
+  histogram_.reset(new Histogram);
+  histogram_->Load(histogram_config);
+
+}
+
+void BenchmarkApp::AddCases(Benchmark &benchmark, const std::vector<int> &band_widths){
+
+  for (auto &f : fixtures_){
+
+    ResolutionFixture *fixture = &f;
+    Model *model = model_.get();
+    boost::shared_ptr<Model> model_ptr = model_;
+    const cv::Size size = f.sdf.size();
+    auto reset = [fixture, model, size]() { ResetOcclusionImage(size); model->cam = fixture->camera->left_eye(); };
+
+    benchmark.Add("render", f.name, [fixture, model_ptr]() {
+      cv::Mat front_depth, back_depth, contour;
+      fixture->pwp3d->RenderModelForDepthAndContour(model_ptr, fixture->camera->left_eye(), front_depth, back_depth, contour);
+    }, reset);
+
+    benchmark.Add("intersection_image", f.name, [fixture]() {
+      cv::Mat front_intersection, back_intersection;
+      fixture->pwp3d->ComputeIntersectionImages(fixture->camera->left_eye(), fixture->front_depth, fixture->back_depth, front_intersection, back_intersection);
+    });
+
+    benchmark.Add("sdf", f.name, [fixture]() {
+      fixture->pwp3d->ComputeSDFImageAndSetProgressFrame(fixture->contour, fixture->front_intersection);
+    });
+
+    benchmark.Add("sdf_and_intersection_image", f.name, [fixture, model_ptr]() {
+      cv::Mat sdf, front_intersection, back_intersection;
+      fixture->pwp3d->ProcessSDFAndIntersectionImage(model_ptr, fixture->camera->left_eye(), sdf, front_intersection, back_intersection);
+    }, reset);
+
+    boost::shared_ptr<ForestAccess> forest = forest_;
+    benchmark.Add("gabor", f.name, [fixture, forest]() {
+      cv::Mat gabor;
+      forest->GetGabor(fixture->frame->GetImage(), gabor);
+    });
+
+    benchmark.Add("mcrf_classify_frame", f.name, [fixture, forest]() {
+      forest->ClassifyFrame(fixture->frame, fixture->stereo_sdf);
+    });
+
+    boost::shared_ptr<Histogram> histogram = histogram_;
+    benchmark.Add("histogram_classify_frame", f.name, [fixture, histogram]() {
+      histogram->ClassifyFrame(fixture->frame);
+    });
+
+    benchmark.Add("histogram_classify_frame_band", f.name, [fixture, histogram]() {
+      histogram->ClassifyFrame(fixture->frame, fixture->stereo_sdf);
+    });
+
+    //tracking modifies the point state so the tracker is reinitialized on the unshifted frame before every run
+    benchmark.Add("lk_track_local_points", f.name, [fixture, model_ptr]() {
+      cv::Mat current_frame = fixture->shifted_left_image.clone();
+      fixture->lk->TrackLocalPoints(current_frame, model_ptr);
+    }, [fixture, model_ptr, reset]() {
+      reset();
+      cv::Mat front_intersection = fixture->front_intersection.clone();
+      cv::Mat previous_frame = fixture->frame->GetLeftImage().clone();
+      fixture->lk->SetFrontIntersectionImage(front_intersection, model_ptr);
+      fixture->lk->InitializeTracker(previous_frame, model_ptr);
+    });
+
+    EllipticalFourierDescriptorBuilder *efd_builder = &efd_builder_;
+    benchmark.Add("efd_build_from_contour", f.name, [fixture, efd_builder]() {
+      efd_builder->BuildFromContour(fixture->silhouette_contour);
+    });
+
+    benchmark.Add("efd_build_from_image", f.name, [fixture, efd_builder]() {
+      efd_builder->BuildFromImage(fixture->silhouette.clone());
+    });
+
+    for (auto band_width : band_widths){
+
+      std::stringstream ss;
+      ss << f.name << " band=" << band_width;
+      const std::string params = ss.str();
+
+      benchmark.Add("jacobian_stereo_pwp3d", params, [fixture, model_ptr]() {
+        cv::Matx<float, 7, 1> jacobian = cv::Matx<float, 7, 1>::zeros();
+        cv::Matx<float, 7, 7> hessian_approx = cv::Matx<float, 7, 7>::zeros();
+        float error = 0.0f;
+        fixture->pwp3d->ComputeJacobiansForEye(fixture->frame->GetLeftClassificationMap(), model_ptr, fixture->camera->left_eye(), jacobian, hessian_approx, error);
+      }, [fixture, reset, band_width]() { reset(); fixture->pwp3d->SetBandWidth(band_width); });
+
+      const size_t number_of_components = number_of_labels_;
+      benchmark.Add("jacobian_comp_ls", params, [fixture, model_ptr, number_of_components]() {
+        std::vector<cv::Matx<float, 7, 1> > jacobians(number_of_components - 1, cv::Matx<float, 7, 1>::zeros());
+        std::vector<cv::Matx<float, 7, 7> > hessian_approxs(number_of_components - 1, cv::Matx<float, 7, 7>::zeros());
+        std::vector<float> errors(number_of_components - 1, 0.0f);
+        fixture->comp_ls->ComputeJacobiansForEye(fixture->frame->GetLeftClassificationMap(), model_ptr, fixture->camera->left_eye(), jacobians, hessian_approxs, errors);
+      }, [fixture, reset, band_width]() { reset(); fixture->comp_ls->SetBandWidth(band_width); });
+
+      if (!f.articulated) continue;
+
+      benchmark.Add("jacobian_articulated_comp_ls", params, [fixture, model_ptr]() {
+        cv::Matx<float, 7, 1> rigid_jacobian = cv::Matx<float, 7, 1>::zeros();
+        cv::Matx<float, 4, 1> articulated_jacobian = cv::Matx<float, 4, 1>::zeros();
+        float error = 0.0f;
+        fixture->articulated->ComputeJacobiansForEye(fixture->frame->GetLeftClassificationMap(), model_ptr, fixture->camera->left_eye(), rigid_jacobian, articulated_jacobian, error);
+      }, [fixture, reset, band_width]() { reset(); fixture->articulated->SetBandWidth(band_width); });
+
+    }
+
+  }
+
+}
+
+void BenchmarkApp::setup(){
+
+  const std::vector<std::string> &args = getArgs();
+  const std::string config_file = args.size() > 1 ? args[1] : "benchmark.cfg";
+
+  size_t regressions = 0;
+
+  try{
+
+    ConfigReader reader(config_file);
+
+    SetupFixtures(reader);
+
+    double min_time = 1.0;
+    try{
+      min_time = reader.get_element_as_type<double>("benchmark-min-time");
+    }
+    catch (std::runtime_error &){}
+
+    std::vector<int> band_widths(1, 3);
+    try{
+      const std::vector<float> widths = ParseList(reader.get_element("benchmark-band-widths"));
+      band_widths.assign(widths.begin(), widths.end());
+    }
+    catch (std::runtime_error &){}
+
+    std::string filter;
+    try{
+      filter = reader.get_element("benchmark-filter");
+    }
+    catch (std::runtime_error &){}
+
+    Benchmark benchmark(min_time);
+    AddCases(benchmark, band_widths);
+    benchmark.Run(console(), filter);
+    benchmark.WriteCSV(output_dir_ + "/benchmark.csv");
+
+    //compare against a saved run so a slower build fails before it is deployed
+    std::string baseline;
+    try{
+      baseline = reader.get_element("benchmark-baseline");
+    }
+    catch (std::runtime_error &){}
+
+    if (!baseline.empty()){
+
+      double tolerance = 0.1;
+      try{
+        tolerance = reader.get_element_as_type<double>("benchmark-tolerance");
+      }
+      catch (std::runtime_error &){}
+
+      regressions = benchmark.CompareToBaseline(Benchmark::ReadCSV(baseline), tolerance, console());
+      console() << regressions << " regression(s) against " << baseline << std::endl;
+
+    }
+
+  }
+  catch (std::exception &e){
+
+    console() << "Error, benchmark failed: " << e.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+
+  }
+
+  if (regressions > 0) std::exit(EXIT_FAILURE);
+
+  quit();
+
+}
+
+CINDER_APP_NATIVE(BenchmarkApp, RendererGl)
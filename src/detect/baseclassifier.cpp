@@ -514,6 +514,15 @@ void BaseClassifier::TrainClassifier(const cv::Mat &frame, const cv::Mat &sdf_im
 
 }
 
+bool BaseClassifier::ClassifyFrame(boost::shared_ptr<sv::Frame> frame){
+
+  if (frame == nullptr) return false;
+
+  //an sdf of zero puts every pixel in the band
+  return ClassifyFrame(frame, cv::Mat::zeros(frame->GetImage().size(), CV_32FC1));
+
+}
+
 bool BaseClassifier::ClassifyFrame(boost::shared_ptr<sv::Frame> frame, const cv::Mat &sdf){
 
   if (frame == nullptr) return false;
@@ -9,6 +9,7 @@
 #include "../../include/ttrack/detect/supportvectormachine.hpp"
 #include "../../include/ttrack/detect/histogram.hpp"
 #include "../../include/ttrack/detect/multiclass_randomforest.hpp"
+#include "../../include/ttrack/utils/profiler.hpp"
 
 #include <cinder/app/App.h>
 
@@ -45,6 +46,8 @@ void Detect::operator()(boost::shared_ptr<sv::Frame> image, const cv::Mat &sdf){
 
 void Detect::Run(boost::shared_ptr<sv::Frame> image, const cv::Mat &sdf){
 
+    TraceScope trace("Detect::Run");
+
     SetHandleToFrame(image);
     ClassifyFrame(sdf);
 
@@ -53,12 +56,9 @@ void Detect::Run(boost::shared_ptr<sv::Frame> image, const cv::Mat &sdf){
 
 void Detect::ClassifyFrame(const cv::Mat &sdf){
 
-  //double t = (double)cv::getTickCount();
-
+  ScopedTimer classification_timer(PROFILE_CLASSIFICATION);
   found_ = classifier_->ClassifyFrame(frame_, sdf);
-
-  //t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
-  //ci::app::console() << "Processing detect time = " << t << std::endl;
+  classification_timer.Stop();
   
   cv::Mat m_channel = frame_->GetClassificationMap().clone();
   std::vector<cv::Mat> channels;
@@ -3,54 +3,60 @@
 using namespace ttrk;
 
 
+//pixels further outside the models' contours than this are left unclassified, as in BaseClassifier::ClassifyFrame
+const float CLASSIFICATION_BAND = -40.0f;
+
 bool Histogram::ClassifyFrame(boost::shared_ptr<sv::Frame> frame){
 
+  return ClassifyFrame(frame, cv::Mat());
+
+}
+
+bool Histogram::ClassifyFrame(boost::shared_ptr<sv::Frame> frame, const cv::Mat &sdf){
+
+  if (frame == nullptr) return false;
+
+  if (lookup_table_.empty()) throw std::runtime_error("Error, the histograms have not been loaded.");
+
   cv::Mat whole_frame = frame->GetImage();
-  NDImage nd_image(whole_frame);
+  cv::Mat classification_map = frame->GetClassificationMap();
+
+  if (whole_frame.type() != CV_8UC3 || classification_map.depth() != CV_32F || classification_map.size() != whole_frame.size())
+    throw std::runtime_error("Error, the histogram classifier needs an 8 bit BGR frame and a float classification map of the same size.");
+  if (!sdf.empty() && (sdf.type() != CV_32FC1 || sdf.size() != whole_frame.size()))
+    throw std::runtime_error("Error, the sdf must be a float image the same size as the frame.");
+
   const int rows = whole_frame.rows;
   const int cols = whole_frame.cols;
+  const int map_channels = classification_map.channels();
+  const int num_classes = std::min(num_classes_, map_channels);
 
-  static size_t frame_count = 0;
+  //the classes the table doesn't have and the pixels outside the band are zero
+  classification_map.setTo(cv::Scalar::all(0));
 
-  //size_t pixel_count = 0;
+  row_indices_.resize(cols);
+  size_t *indices = row_indices_.data();
+  const float *table = lookup_table_.data();
 
-  float *frame_data = (float *)frame->GetClassificationMap().data;
+  for (int r = 0; r < rows; r++){
 
-  cv::Mat test_frame_fg(rows, cols, CV_32FC1);
-  cv::Mat test_frame_bg(rows, cols, CV_32FC1);
-  cv::Mat test_frame_winner(rows, cols, CV_32FC1);
+    //the indices are computed for the whole row first so the quantization runs without the gather's dependent loads in the way
+    const unsigned char *bgr = whole_frame.ptr<unsigned char>(r);
+    for (int c = 0; c < cols; c++, bgr += 3)
+      indices[c] = GetLookupTableIndex(bgr[0], bgr[1], bgr[2]) * num_classes_;
 
-  for(int r=0;r<rows;r++){
-    for(int c=0;c<cols;c++){
+    const float *band = sdf.empty() ? 0x0 : sdf.ptr<float>(r);
+    float *map = classification_map.ptr<float>(r);
+    for (int c = 0; c < cols; c++, map += map_channels){
 
-      const int index = r*cols + c;
+      if (band && band[c] < CLASSIFICATION_BAND) continue;
 
-      cv::Mat rgb(3, 1, CV_8UC1);
-      rgb.at<unsigned char>(0) = whole_frame.at<cv::Vec3b>(r, c)[0];
-      rgb.at<unsigned char>(1) = whole_frame.at<cv::Vec3b>(r, c)[1];
-      rgb.at<unsigned char>(2) = whole_frame.at<cv::Vec3b>(r, c)[2];
-
-      cv::Mat pix = nd_image.GetPixelData(r, c);
-
-      float hue = pix.at<float>(0);
-      float sat = pix.at<float>(1);
-      float o1 = pix.at<float>(2);
-      float o2 = pix.at<float>(3);
-
-      test_frame_fg.at<float>(r, c) = PredictProb(pix, 1);
-      test_frame_bg.at<float>(r, c) = PredictProb(pix, 0);
-      if (test_frame_fg.at<float>(r, c) > test_frame_bg.at<float>(r, c))
-        test_frame_winner.at<float>(r, c) = 1.0;// test_frame_fg.at<float>(r, c);
-      //test_frame_winner.at<float>(r, c) = test_frame_bg.at<float>(r, c);
-      for (int cls = 0; cls < num_classes_; ++cls){
-        const float prediction = PredictProb(rgb, cls);
-        frame_data[index*frame->NumClassificationChannels() + cls] = prediction;
-      }
-      for (int cls = num_classes_; cls < frame->NumClassificationChannels(); ++cls){
-        frame_data[index*frame->NumClassificationChannels() + cls] = 0;
-      }
+      const float *probabilities = table + indices[c];
+      for (int cls = 0; cls < num_classes; ++cls)
+        map[cls] = probabilities[cls];
 
     }
+
   }
 
   return true;
@@ -188,6 +194,34 @@ void Histogram::Load(const std::string &url){
     }
   }
 
+
+  BuildLookupTable();
+
+}
+
+void Histogram::BuildLookupTable(){
+
+  const InternalHistogram<histogram_channel_num, histogram_bin_num> *histograms[3] = { &background_, &foreground_shaft_, &foreground_tip_ };
+  const float areas[3] = { (float)bg_area_, (float)fg_area_, (float)fg_area_ };
+
+  if (num_classes_ > 3) throw std::runtime_error("Error, the histogram classifier only has 3 classes.");
+
+  //the same product as PredictProb, once per quantized colour instead of once per pixel
+  lookup_table_.resize((size_t)histogram_bin_num * histogram_bin_num * histogram_bin_num * num_classes_);
+  for (int b = 0; b < histogram_bin_num; ++b){
+    for (int g = 0; g < histogram_bin_num; ++g){
+      for (int r = 0; r < histogram_bin_num; ++r){
+
+        float *probabilities = &lookup_table_[(((size_t)b * histogram_bin_num + g) * histogram_bin_num + r) * num_classes_];
+        for (int cls = 0; cls < num_classes_; ++cls){
+          const InternalHistogram<histogram_channel_num, histogram_bin_num> &histogram = *histograms[cls];
+          probabilities[cls] = ((float)histogram[0][b] / areas[cls]) * ((float)histogram[1][g] / areas[cls]) * ((float)histogram[2][r] / areas[cls]);
+        }
+
+      }
+    }
+  }
+
 }
 
 
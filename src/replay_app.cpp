@@ -0,0 +1,170 @@
+#include <cinder/app/AppNative.h>
+#include <CinderOpenCV.h>
+#include <boost/filesystem.hpp>
+#include <vector>
+#include <cstdlib>
+
+#include "../include/ttrack/headers.hpp"
+#include "../include/ttrack/ttrack.hpp"
+#include "../include/ttrack/utils/config_reader.hpp"
+#include "../include/ttrack/utils/profiler.hpp"
+#include "../include/ttrack/utils/trajectory_log.hpp"
+#include "../include/ttrack/track/tracker/stereo_tool_tracker.hpp"
+#include "../include/ttrack/track/localizer/localizer_recording.hpp"
+
+using namespace ci;
+using namespace ci::app;
+using namespace ttrk;
+
+/**
+* @class ReplayApp
+* @brief Runs the localizer on recorded inputs (see LocalizerInput) so it can be profiled without the rest of the tracking pipeline.
+*
+* Usage: ttrack_replay <tracking config> <localizer_inputs.bin>. The tracking config gives the model, camera and localizer settings,
+* which should match the ones the inputs were recorded with for the results to be comparable. Every frame is replayed with the same
+* starting pose, feature tracker state and classification map, so two builds of the localizer can be A/B tested on identical input. The
+* tracked poses are written to replay/trajectory_model_0.bin and the per stage timings to replay/profile.csv in the output directory.
+*/
+class ReplayApp : public AppNative {
+
+public:
+
+  void setup();
+  void draw() {}
+
+protected:
+
+  void SetupTracker(const ConfigReader &reader, const size_t number_of_models);
+
+  boost::scoped_ptr<StereoToolTracker> tracker_;
+
+};
+
+void ReplayApp::SetupTracker(const ConfigReader &reader, const size_t number_of_models){
+
+  const std::string root_dir = reader.get_element("root-dir");
+
+  size_t number_of_labels = 2;
+  try{
+    number_of_labels = reader.get_element_as_type<size_t>("num-labels");
+  }
+  catch (std::runtime_error &){}
+
+  tracker_.reset(new StereoToolTracker(reader.get_element("trackable"), root_dir + "/" + reader.get_element("camera-config"), reader.get_element("output-dir") + "/replay", TTrack::LocalizerTypeFromString(reader.get_element("localizer-type")), number_of_labels));
+
+  //the classifier is never run but the models still build one
+  tracker_->SetDetectorType(TTrack::ClassifierFromString(reader.get_element("classifier-type")), number_of_labels);
+
+  //the starting poses are overwritten with the recorded ones before the first step
+  const float identity_pose[15] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0 };
+  for (size_t i = 0; i < number_of_models; ++i)
+    tracker_->AddStartPose(std::vector<float>(identity_pose, identity_pose + 15));
+
+  try{
+    tracker_->SetLocalizerIterations(reader.get_element_as_type<int>("localizer-iterations"));
+  }
+  catch (std::runtime_error &){}
+
+  try{
+    tracker_->SetPointRegistrationWeight(reader.get_element_as_type<float>("point-weight"));
+  }
+  catch (std::runtime_error &){}
+
+  try{
+    tracker_->SetArticulatedPointRegistrationWeight(reader.get_element_as_type<float>("articulated-point-weight"));
+  }
+  catch (std::runtime_error &){
+    tracker_->SetArticulatedPointRegistrationWeight(0.5);
+  }
+
+  //same defaults as the tracking app
+  auto get_flag = [&reader](const std::string &key, const bool default_value) -> bool {
+    try{
+      return reader.get_element_as_type<bool>(key);
+    }
+    catch (std::runtime_error &){
+      return default_value;
+    }
+  };
+
+  const bool use_global_roll_search_first = get_flag("use-global-roll-rotation-first", false);
+  tracker_->SetupPointTracker(get_flag("use-point-rotation-derivs", true), get_flag("use-point-translation-derivs", true), get_flag("use-point-articulated-derivs", true), use_global_roll_search_first, get_flag("use-global-roll-rotation-last", !use_global_roll_search_first));
+
+}
+
+void ReplayApp::setup(){
+
+  const std::vector<std::string> &args = getArgs();
+
+  try{
+
+    if (args.size() < 3) throw std::runtime_error("Usage: ttrack_replay <tracking config> <localizer_inputs.bin>");
+
+    ConfigReader reader(args[1]);
+    LocalizerInputReader recording(args[2]);
+
+    const std::string output_dir = reader.get_element("output-dir") + "/replay";
+    if (!boost::filesystem::is_directory(output_dir)) boost::filesystem::create_directories(output_dir);
+
+    LocalizerInput input;
+    if (!recording.Read(input)) throw std::runtime_error("Error, the recording is empty.");
+
+    SetupTracker(reader, input.poses.size());
+
+    std::vector<std::string> stages(1, "localize");
+    boost::scoped_ptr<TrajectoryLogWriter> trajectory;
+
+    Profiler::Instance().Reset();
+
+    size_t frames = 0;
+    double total_time = 0;
+
+    do {
+
+      boost::shared_ptr<sv::Frame> frame(new sv::StereoFrame(input.image));
+
+      const int64 start = cv::getTickCount();
+      if (!tracker_->ReplayLocalizerInput(input, frame)) throw std::runtime_error("Error, could not initialise the models.");
+      const double seconds = (cv::getTickCount() - start) / cv::getTickFrequency();
+
+      Profiler::Instance().EndFrame();
+
+      std::vector<boost::shared_ptr<Model> > models;
+      tracker_->GetTrackedModels(models);
+
+      TrajectoryRecord record;
+      record.frame_index = input.frame_index;
+      record.score = tracker_->GetLocalizerError();
+      record.iterations = tracker_->GetLocalizerStepCount();
+      record.timings.push_back((float)seconds);
+      models.front()->GetPose(record.dofs);
+
+      if (!trajectory) trajectory.reset(new TrajectoryLogWriter(output_dir + "/trajectory_model_0.bin", record.dofs.size(), stages));
+      record.timestamp = trajectory->GetElapsedTime();
+      trajectory->Append(record);
+
+      frames++;
+      total_time += seconds;
+
+    } while (recording.Read(input));
+
+    trajectory.reset();
+
+    Profiler::Instance().WriteCSV(output_dir + "/profile.csv");
+    Profiler::Instance().WriteJSON(output_dir + "/profile.json");
+
+    console() << "Replayed " << frames << " frames, " << 1000 * total_time / frames << " ms per frame (" << frames / total_time << " fps)" << std::endl;
+
+  }
+  catch (std::exception &e){
+
+    console() << e.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+
+  }
+
+  quit();
+
+}
+
+CINDER_APP_NATIVE(ReplayApp, RendererGl)
@@ -0,0 +1,428 @@
+#include <cinder/app/AppNative.h>
+#include <cinder/gl/Fbo.h>
+#include <cinder/gl/GlslProg.h>
+#include <CinderOpenCV.h>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <cstdlib>
+
+#include "../include/ttrack/headers.hpp"
+#include "../include/ttrack/constants.hpp"
+#include "../include/ttrack/ttrack.hpp"
+#include "../include/ttrack/resources.hpp"
+#include "../include/ttrack/utils/camera.hpp"
+#include "../include/ttrack/utils/config_reader.hpp"
+#include "../include/ttrack/utils/trajectory_log.hpp"
+#include "../include/ttrack/utils/trajectory_evaluation.hpp"
+#include "../include/ttrack/track/model/articulated_model.hpp"
+#include "../include/ttrack/track/localizer/levelsets/stereo_pwp3d.hpp"
+
+using namespace ci;
+using namespace ci::app;
+using namespace ttrk;
+
+namespace {
+
+  /**
+  * @struct Keyframe
+  * @brief A pose the scripted trajectory passes through.
+  */
+  struct Keyframe {
+
+    size_t frame; /**< The frame the model is at this pose. */
+    std::vector<float> dofs; /**< The pose in the order of Model::GetPose. */
+
+  };
+
+  //one keyframe per line: the frame index then the dofs, lines starting with # are comments
+  std::vector<Keyframe> ReadKeyframes(const std::string &path){
+
+    std::ifstream ifs(path.c_str());
+    if (!ifs.is_open()) throw std::runtime_error("Error, could not open trajectory file " + path);
+
+    std::vector<Keyframe> keyframes;
+    std::string line;
+
+    while (std::getline(ifs, line)){
+
+      if (line.empty() || line[0] == '#') continue;
+
+      std::stringstream ss(line);
+      Keyframe k;
+      if (!(ss >> k.frame)) continue;
+
+      float x;
+      while (ss >> x) k.dofs.push_back(x);
+
+      if (k.dofs.size() < 7) throw std::runtime_error("Error, trajectory keyframe needs at least 7 dofs: " + line);
+      if (!keyframes.empty() && (k.frame <= keyframes.back().frame || k.dofs.size() != keyframes.back().dofs.size())) throw std::runtime_error("Error, trajectory keyframes must be in frame order with the same number of dofs: " + line);
+
+      keyframes.push_back(k);
+
+    }
+
+    if (keyframes.empty()) throw std::runtime_error("Error, no keyframes in " + path);
+
+    return keyframes;
+
+  }
+
+  //linear interpolation of the translation and articulation, slerp of the rotation
+  std::vector<float> InterpolatePose(const std::vector<Keyframe> &keyframes, const size_t frame){
+
+    size_t next = 0;
+    while (next < keyframes.size() && keyframes[next].frame < frame) ++next;
+
+    if (next == keyframes.size()) return keyframes.back().dofs;
+    if (next == 0 || keyframes[next].frame == frame) return keyframes[next].dofs;
+
+    const Keyframe &a = keyframes[next - 1], &b = keyframes[next];
+    const float t = float(frame - a.frame) / float(b.frame - a.frame);
+
+    std::vector<float> dofs(a.dofs.size());
+    for (size_t i = 0; i < dofs.size(); ++i) dofs[i] = (1 - t) * a.dofs[i] + t * b.dofs[i];
+
+    ci::Quatf qa(a.dofs[3], a.dofs[4], a.dofs[5], a.dofs[6]), qb(b.dofs[3], b.dofs[4], b.dofs[5], b.dofs[6]);
+    qa.normalize();
+    qb.normalize();
+    const ci::Quatf q = qa.slerp(t, qb);
+
+    dofs[3] = q.w;
+    dofs[4] = q.v[0];
+    dofs[5] = q.v[1];
+    dofs[6] = q.v[2];
+
+    return dofs;
+
+  }
+
+  //convert a pose in the order of Model::GetPose to the starting-pose-N layout read by SurgicalToolTracker::InitFromFile
+  std::vector<float> StartingPoseFromDofs(const std::vector<float> &dofs){
+
+    ci::Quatf q(dofs[3], dofs[4], dofs[5], dofs[6]);
+    q.normalize();
+    const ci::Matrix33f r = q.toMatrix33();
+
+    std::vector<float> p;
+    for (int row = 0; row < 3; ++row){
+      for (int col = 0; col < 3; ++col) p.push_back(r.at(row, col));
+      p.push_back(dofs[row]);
+    }
+
+    //the tracker splits the last value evenly between the two jaws
+    p.push_back(dofs.size() > 7 ? dofs[7] : 0.0f);
+    p.push_back(dofs.size() > 8 ? dofs[8] : 0.0f);
+    p.push_back((dofs.size() > 9 ? dofs[9] : 0.0f) + (dofs.size() > 10 ? dofs[10] : 0.0f));
+
+    return p;
+
+  }
+
+  cv::Mat LoadBackground(const std::string &path, const cv::Size &size, cv::RNG &rng){
+
+    cv::Mat background;
+
+    if (!path.empty()){
+      background = cv::imread(path);
+      if (background.data == 0x0) throw std::runtime_error("Error, could not load background image " + path);
+      cv::resize(background, background, size);
+      return background;
+    }
+
+    //reddish blurred noise, roughly the colour and texture of tissue
+    background = cv::Mat(size, CV_8UC3);
+    rng.fill(background, cv::RNG::UNIFORM, cv::Scalar(0, 0, 60), cv::Scalar(120, 140, 255));
+    cv::GaussianBlur(background, background, cv::Size(0, 0), 4);
+    return background;
+
+  }
+
+  std::string GetOptionalElement(const ConfigReader &reader, const std::string &key, const std::string &default_value){
+
+    try{
+      return reader.get_element(key);
+    }
+    catch (std::runtime_error &){
+      return default_value;
+    }
+
+  }
+
+}
+
+/**
+* @class SyntheticApp
+* @brief Generates a synthetic stereo sequence of a model moving along a scripted trajectory and measures each localizer on it.
+*
+* Run with a config file in the same format as the tracking app (see examples/synthetic.cfg). The model is rendered through the stereo
+* calibration at every pose of the trajectory, composited onto a textured background with noise and written as a pair of videos along
+* with the ground truth poses. Each localizer then tracks the sequence and its speed and pose error are written to report.csv.
+*/
+class SyntheticApp : public AppNative {
+
+public:
+
+  void setup();
+  void draw() {}
+
+protected:
+
+  /**
+  * Render the sequence and write the videos and ground truth.
+  * @param[in] reader The config.
+  * @return The ground truth pose of each frame.
+  */
+  std::vector<std::vector<float> > GenerateSequence(const ConfigReader &reader);
+
+  /**
+  * Render the model into one eye of the sequence.
+  * @param[in] camera The eye.
+  * @param[in] background The background to composite onto.
+  * @return The image.
+  */
+  cv::Mat RenderEye(const boost::shared_ptr<MonocularCamera> camera, const cv::Mat &background);
+
+  /**
+  * Track the sequence with one localizer and compare the results to the ground truth.
+  * @param[in] reader The config.
+  * @param[in] localizer_name The localizer, as named in the config files.
+  * @param[in] ground_truth The ground truth pose of each frame.
+  * @return The evaluation.
+  */
+  TrajectoryEvaluation RunLocalizer(const ConfigReader &reader, const std::string &localizer_name, const std::vector<std::vector<float> > &ground_truth);
+
+  boost::shared_ptr<Model> model_;
+  boost::shared_ptr<StereoCamera> camera_;
+  boost::shared_ptr<StereoPWP3D> renderer_; /**< Used for the model silhouette, the textured render is done with shader_. */
+  ci::gl::GlslProg shader_;
+  ci::gl::Fbo framebuffer_;
+
+  std::string root_dir_;
+  std::string output_dir_;
+  std::string left_video_;
+  std::string right_video_;
+
+};
+
+cv::Mat SyntheticApp::RenderEye(const boost::shared_ptr<MonocularCamera> camera, const cv::Mat &background){
+
+  cv::Mat front_depth, back_depth, contour;
+  renderer_->RenderModelForDepthAndContour(model_, camera, front_depth, back_depth, contour);
+
+  framebuffer_.bindFramebuffer();
+  ci::gl::clear(ci::ColorA(0, 0, 0, 0), true);
+
+  ci::gl::enableDepthRead();
+  ci::gl::enableDepthWrite();
+  ci::gl::pushMatrices();
+
+  camera->SetupCameraForDrawing();
+
+  shader_.bind();
+  shader_.uniform("tex0", 0);
+  model_->RenderTexture(0);
+  shader_.unbind();
+
+  camera->ShutDownCameraAfterDrawing();
+
+  ci::gl::popMatrices();
+  framebuffer_.unbindFramebuffer();
+
+  cv::Mat render = ci::toOcv(framebuffer_.getTexture()), flipped_render;
+  if (render.channels() == 4) cv::cvtColor(render, render, CV_BGRA2BGR);
+  cv::flip(render, flipped_render, 0);
+
+  //the model covers every pixel where the front depth was written
+  std::vector<cv::Mat> depth_channels;
+  cv::split(front_depth, depth_channels);
+  cv::Mat mask = depth_channels[0] < (GL_FAR - 1);
+
+  cv::Mat eye = background.clone();
+  flipped_render.copyTo(eye, mask);
+
+  return eye;
+
+}
+
+std::vector<std::vector<float> > SyntheticApp::GenerateSequence(const ConfigReader &reader){
+
+  const std::vector<Keyframe> keyframes = ReadKeyframes(root_dir_ + "/" + reader.get_element("synthetic-trajectory"));
+
+  float noise_sigma = 5.0f;
+  try{
+    noise_sigma = reader.get_element_as_type<float>("synthetic-noise");
+  }
+  catch (std::runtime_error &){}
+
+  double fps = 25;
+  try{
+    fps = reader.get_element_as_type<double>("synthetic-fps");
+  }
+  catch (std::runtime_error &){}
+
+  const cv::Size size(camera_->left_eye()->Width(), camera_->left_eye()->Height());
+
+  cv::RNG rng(1234);
+  std::string left_background = GetOptionalElement(reader, "synthetic-left-background", ""), right_background = GetOptionalElement(reader, "synthetic-right-background", "");
+  if (!left_background.empty()) left_background = root_dir_ + "/" + left_background;
+  if (!right_background.empty()) right_background = root_dir_ + "/" + right_background;
+  const cv::Mat left_background_image = LoadBackground(left_background, size, rng), right_background_image = LoadBackground(right_background, size, rng);
+
+  renderer_.reset(new StereoPWP3D(camera_));
+  shader_ = gl::GlslProg(loadResource(RES_SHADER_VERT), loadResource(RES_SHADER_FRAG));
+  framebuffer_ = ci::gl::Fbo(size.width, size.height);
+
+  cv::VideoWriter left_writer(left_video_, CV_FOURCC('M', 'J', 'P', 'G'), fps, size), right_writer(right_video_, CV_FOURCC('M', 'J', 'P', 'G'), fps, size);
+  if (!left_writer.isOpened() || !right_writer.isOpened()) throw std::runtime_error("Error, could not open the synthetic videos for writing in " + output_dir_);
+
+  std::ofstream ground_truth_ofs((output_dir_ + "/ground_truth.txt").c_str());
+  if (!ground_truth_ofs.is_open()) throw std::runtime_error("Error, could not open the ground truth file for writing in " + output_dir_);
+
+  std::vector<std::vector<float> > ground_truth;
+  cv::Mat noise(size, CV_32FC3), noisy;
+
+  for (size_t frame = 0; frame <= keyframes.back().frame; ++frame){
+
+    std::vector<float> pose = InterpolatePose(keyframes, frame);
+    model_->SetPose(pose);
+
+    //record the pose as the model holds it, e.g. with the rotation normalized
+    ground_truth.push_back(std::vector<float>());
+    model_->GetPose(ground_truth.back());
+    ground_truth_ofs << model_->GetPoseAsString();
+
+    cv::Mat eyes[2] = { RenderEye(camera_->left_eye(), left_background_image), RenderEye(camera_->right_eye(), right_background_image) };
+
+    for (auto &eye : eyes){
+      eye.convertTo(noisy, CV_32FC3);
+      rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(noise_sigma));
+      noisy += noise;
+      noisy.convertTo(eye, CV_8UC3);
+    }
+
+    left_writer << eyes[0];
+    right_writer << eyes[1];
+
+  }
+
+  console() << "Generated " << ground_truth.size() << " frames in " << output_dir_ << std::endl;
+
+  return ground_truth;
+
+}
+
+TrajectoryEvaluation SyntheticApp::RunLocalizer(const ConfigReader &reader, const std::string &localizer_name, const std::vector<std::vector<float> > &ground_truth){
+
+  size_t number_of_labels = 2;
+  try{
+    number_of_labels = reader.get_element_as_type<size_t>("num-labels");
+  }
+  catch (std::runtime_error &){}
+
+  const std::string results_dir = output_dir_ + "/" + localizer_name;
+  if (boost::filesystem::exists(results_dir)) boost::filesystem::remove_all(results_dir);
+
+  {
+
+    auto &ttrack = TTrack::Instance();
+
+    ttrack.SetUp(reader.get_element("trackable"),
+                 root_dir_ + "/" + reader.get_element("camera-config"),
+                 root_dir_ + "/" + reader.get_element("classifier-config"),
+                 results_dir,
+                 TTrack::LocalizerTypeFromString(localizer_name),
+                 TTrack::ClassifierFromString(reader.get_element("classifier-type")),
+                 left_video_, right_video_,
+                 std::vector<std::vector<float> >(1, StartingPoseFromDofs(ground_truth.front())),
+                 number_of_labels, 0, "");
+
+    try{
+      ttrack.GetTracker()->SetLocalizerIterations(reader.get_element_as_type<int>("localizer-iterations"));
+    }
+    catch (std::runtime_error &){}
+
+    //run exactly as the tracking app does so the timings match
+    ttrack.StartTrackingThread();
+    while (!ttrack.UpdateSnapshot() || !ttrack.GetSnapshot().done){
+      boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+
+  }
+
+  //flushes the trajectory log
+  TTrack::Destroy();
+
+  return EvaluateTrajectory(TrajectoryLogReader(results_dir + "/trajectory_model_0.bin"), ground_truth);
+
+}
+
+void SyntheticApp::setup(){
+
+  const std::vector<std::string> &args = getArgs();
+  const std::string config_file = args.size() > 1 ? args[1] : "synthetic.cfg";
+
+  try{
+
+    ConfigReader reader(config_file);
+
+    root_dir_ = reader.get_element("root-dir");
+    output_dir_ = reader.get_element("output-dir");
+    if (!boost::filesystem::is_directory(output_dir_)) boost::filesystem::create_directories(output_dir_);
+
+    left_video_ = output_dir_ + "/left.avi";
+    right_video_ = output_dir_ + "/right.avi";
+
+    camera_.reset(new StereoCamera(root_dir_ + "/" + reader.get_element("camera-config")));
+    model_.reset(new DenavitHartenbergArticulatedModel(reader.get_element("trackable"), output_dir_ + "/synthetic_model.txt"));
+    model_->cam = camera_->left_eye();
+
+    const std::vector<std::vector<float> > ground_truth = GenerateSequence(reader);
+
+    //the generator's framebuffers belong to this context, free them before the tracker creates its own
+    renderer_.reset();
+
+    std::vector<std::string> localizers;
+    std::stringstream ss(GetOptionalElement(reader, "synthetic-localizers", "PWP3D_SIFT PWP3D_LK PWP3D_ORB CompLS_SIFT CompLS_LK LSForest ArticulatedCompLS_GradientDescent ArticulatedCompLS_GradientDescent_FrameToFrameLK ArticulatedCompLS_Sampler PWP3D LK CompLS"));
+    std::string name;
+    while (ss >> name) localizers.push_back(name);
+
+    std::ofstream report((output_dir_ + "/report.csv").c_str());
+    report << "localizer,frames,fps,iterations_per_frame,mean_translation_error,max_translation_error,mean_rotation_error_deg,max_rotation_error_deg,mean_articulation_error\n";
+
+    for (auto &localizer : localizers){
+
+      console() << "Tracking with " << localizer << std::endl;
+
+      TrajectoryEvaluation e;
+      try{
+        e = RunLocalizer(reader, localizer, ground_truth);
+      }
+      catch (std::exception &ex){
+        console() << "Error, " << localizer << " failed: " << ex.what() << std::endl;
+        TTrack::Destroy();
+        continue;
+      }
+
+      report << localizer << "," << e.frames << "," << e.fps << "," << e.mean_iterations << "," << e.mean_translation_error << "," << e.max_translation_error << "," << e.mean_rotation_error << "," << e.max_rotation_error << "," << e.mean_articulation_error << "\n";
+      report.flush();
+
+      console() << localizer << ": " << e.frames << " frames, " << e.fps << " fps, " << e.mean_iterations << " iterations/frame, translation error " << e.mean_translation_error << " (max " << e.max_translation_error << "), rotation error " << e.mean_rotation_error << " deg (max " << e.max_rotation_error << "), articulation error " << e.mean_articulation_error << std::endl;
+
+    }
+
+  }
+  catch (std::exception &e){
+
+    console() << "Error, synthetic run failed: " << e.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+
+  }
+
+  quit();
+
+}
+
+CINDER_APP_NATIVE(SyntheticApp, RendererGl)
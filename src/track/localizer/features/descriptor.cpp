@@ -2,13 +2,13 @@
 
 using namespace ttrk;
 
-Descriptor::Descriptor(const cv::Vec3f pt, const cv::Vec3f normal, const cv::Mat &descriptor){
+Descriptor::Descriptor(const cv::Vec3f pt, const cv::Vec3f normal, const cv::Mat &descriptor, const size_t times_matched, const size_t total_num_attempts){
 
   coordinate_ = ci::Vec3f(pt[0], pt[1], pt[2]);
   normal_ = ci::Vec3f(normal[0], normal[1], normal[2]);
   descriptor_ = descriptor.clone();
-  times_matched_ = 0;
-  total_num_attempts_ = 0;
+  times_matched_ = times_matched;
+  total_num_attempts_ = total_num_attempts;
 
 }
 ci::Vec3f Descriptor::ciGetPointInEyeSpace(Pose &pose) const {
@@ -31,10 +31,13 @@ ci::Vec3f Descriptor::ciGetPointInEyeSpace(Pose &pose) const {
 //
 //}
 
-bool Descriptor::ShouldUseThisDescriptor(Pose &pose) const {
+bool Descriptor::ShouldUseThisDescriptor(const Pose &pose) const {
 
-  //check visibility and also check normals
+  const cv::Vec3f point_in_eye = pose.TransformPoint(GetModelPoint());
+  if (point_in_eye[2] <= 0) return false;
 
-  return true;
+  //the camera is at the origin so a visible surface's normal points back along the ray to it
+  const cv::Vec3f normal_in_eye = pose.TransformPoint(GetModelPoint() + GetModelNormal()) - point_in_eye;
+  return normal_in_eye.dot(point_in_eye) < 0;
 
 }
\ No newline at end of file
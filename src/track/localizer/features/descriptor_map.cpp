@@ -0,0 +1,82 @@
+#include <stdexcept>
+
+#include "../../../../include/ttrack/track/localizer/features/descriptor_map.hpp"
+#include "../../../../include/ttrack/track/localizer/features/keypoint_grid.hpp"
+
+using namespace ttrk;
+
+namespace {
+
+  //hit rate with one prior hit and miss so a new descriptor isn't the first to be evicted
+  double Usefulness(const Descriptor &descriptor){
+    return (descriptor.GetTimesMatched() + 1.0) / (descriptor.GetTotalNumberOfAttempts() + 2.0);
+  }
+
+}
+
+DescriptorMap::DescriptorMap(const size_t max_size) : max_size_(max_size) {
+
+  if (max_size == 0) throw std::runtime_error("Error, descriptor map size must be positive.");
+  descriptors_.reserve(max_size);
+
+}
+
+void DescriptorMap::Add(const Descriptor &descriptor){
+
+  if (descriptors_.size() < max_size_){
+    descriptors_.push_back(descriptor);
+    return;
+  }
+
+  //the oldest of the least useful descriptors makes way
+  size_t worst = 0;
+  for (size_t i = 1; i < descriptors_.size(); ++i){
+    if (Usefulness(descriptors_[i]) < Usefulness(descriptors_[worst])) worst = i;
+  }
+
+  descriptors_.erase(descriptors_.begin() + worst);
+  descriptors_.push_back(descriptor);
+
+}
+
+void DescriptorMap::Match(const Pose &pose, const boost::shared_ptr<MonocularCamera> camera, const std::vector<cv::KeyPoint> &keypoints, const cv::Mat &descriptors, const float radius, const int norm_type, std::vector<cv::DMatch> &matches, std::vector<cv::Point2f> &projections){
+
+  matches.clear();
+  projections.clear();
+
+  if (descriptors_.empty() || keypoints.empty()) return;
+
+  //project the descriptors that could be visible, they are the queries and the keypoints are searched around each one
+  std::vector<size_t> visible;
+  std::vector<cv::KeyPoint> projected;
+  for (size_t i = 0; i < descriptors_.size(); ++i){
+
+    if (!descriptors_[i].ShouldUseThisDescriptor(pose)) continue;
+
+    const cv::Vec3f point_in_eye = pose.TransformPoint(descriptors_[i].GetModelPoint());
+    const cv::Point2d projection = camera->ProjectPoint(cv::Point3d(point_in_eye[0], point_in_eye[1], point_in_eye[2]));
+
+    visible.push_back(i);
+    projected.push_back(cv::KeyPoint(cv::Point2f(projection), 1.0f));
+    descriptors_[i].IncrementTotalNumberOfAttempts();
+
+  }
+
+  if (visible.empty()) return;
+
+  cv::Mat visible_descriptors(visible.size(), descriptors.cols, descriptors.type());
+  for (size_t i = 0; i < visible.size(); ++i){
+    const cv::Mat d = descriptors_[visible[i]].GetDescriptor();
+    if (d.cols != descriptors.cols || d.type() != descriptors.type()) throw std::runtime_error("Error, the descriptor map holds a different type of descriptor.");
+    d.copyTo(visible_descriptors.row(i));
+  }
+
+  KeypointGrid grid(keypoints, radius);
+  grid.Match(projected, visible_descriptors, descriptors, radius, norm_type, matches);
+
+  for (auto &match : matches){
+    projections.push_back(projected[match.queryIdx].pt);
+    match.queryIdx = (int)visible[match.queryIdx];
+  }
+
+}
@@ -14,6 +14,71 @@ FeatureLocalizer::FeatureLocalizer(boost::shared_ptr<MonocularCamera> camera) :
  
 }
 
+void FeatureLocalizer::SetFrontIntersectionImage(cv::Mat &im, boost::shared_ptr<Model> current_model){
+
+  ModelPointSet &mps = current_model->mps;
+  mps.front_intersection_image_ = im.clone();
+
+  const cv::Mat &occlusion_image = Localizer::occlusion_image;
+  if (occlusion_image.size() != im.size()){
+    mps.occlusion_integral_ = cv::Mat();
+    return;
+  }
+
+  //same test as the per pixel checks this replaces: something is closer than the model's front surface
+  mps.occluded_pixels_.create(im.size(), CV_8UC1);
+  for (int r = 0; r < im.rows; ++r){
+    const cv::Vec3f *front = mps.front_intersection_image_.ptr<cv::Vec3f>(r);
+    const float *occlusion = occlusion_image.ptr<float>(r);
+    unsigned char *occluded = mps.occluded_pixels_.ptr<unsigned char>(r);
+    for (int c = 0; c < im.cols; ++c){
+      occluded[c] = occlusion[c] < (front[c][2] - 0.1);
+    }
+  }
+
+  cv::integral(mps.occluded_pixels_, mps.occlusion_integral_, CV_32S);
+
+}
+
+bool FeatureLocalizer::IsOccluded(const boost::shared_ptr<Model> current_model, const cv::Rect &window){
+
+  const cv::Mat &integral = current_model->mps.occlusion_integral_;
+  if (integral.empty()) return false;
+
+  const cv::Rect clipped = window & cv::Rect(0, 0, integral.cols - 1, integral.rows - 1);
+  if (clipped.area() == 0) return false;
+
+  const int top = clipped.y, left = clipped.x, bottom = clipped.y + clipped.height, right = clipped.x + clipped.width;
+  const int count = integral.at<int>(bottom, right) - integral.at<int>(top, right) - integral.at<int>(bottom, left) + integral.at<int>(top, left);
+  return count > 0;
+
+}
+
+boost::shared_ptr<sv::FramePyramid> FeatureLocalizer::GetFramePyramid(const cv::Mat &current_frame) const {
+
+  if (frame_pyramid_ && frame_pyramid_->IsBuiltFrom(current_frame))
+    return frame_pyramid_;
+  
+  return boost::shared_ptr<sv::FramePyramid>();
+
+}
+
+cv::Mat FeatureLocalizer::GetGrayFrame(const cv::Mat &current_frame) const {
+
+  boost::shared_ptr<sv::FramePyramid> pyramid = GetFramePyramid(current_frame);
+  if (pyramid) return pyramid->GetGray();
+
+  //always a new buffer as the previous frame may still be sharing the last one
+  cv::Mat gray;
+  if (current_frame.type() == CV_8UC3)
+    cv::cvtColor(current_frame, gray, CV_BGR2GRAY);
+  else if (current_frame.type() == CV_8UC1)
+    gray = current_frame.clone();
+
+  return gray;
+
+}
+
 std::vector<float> FeatureLocalizer::GetArticulatedDerivativesForPoints(boost::shared_ptr<Model> current_model, const cv::Mat &articulated_index_image){
 
   current_error_ = 0;
@@ -111,6 +176,43 @@ std::vector<float> FeatureLocalizer::GetDerivativesForPoints(boost::shared_ptr<M
 
 }
 
+size_t FeatureLocalizer::GetPointRegistrationSystem(boost::shared_ptr<Model> current_model, const Pose &pose, cv::Matx<float, 7, 7> &jtj, cv::Matx<float, 7, 1> &jtr) {
+
+  point_solver_.Reset(camera_->Fx(), camera_->Fy(), pose.GetNumDofs());
+
+  const cv::Mat &frame = current_model->mps.current_frame;
+  const int border_y = 0.1 * frame.rows;
+  const int border_x = 0.1 * frame.cols;
+  const cv::Rect frame_rect(0, 0, frame.cols, frame.rows);
+  const cv::Rect inner_rect(border_x, border_y, frame.cols - (2 * border_x), frame.rows - (2 * border_y));
+
+  for (const auto &tp : current_model->mps.tracked_points_){
+
+    if (tp.point_in_view == false) continue;
+    if (tp.point_tracked_on_model == false) continue;
+
+    if (l2_distance(tp.frame_point, tp.found_image_point) > point_threshold)
+      continue;
+
+    //the same border rejection as GetDerivativesForPoints
+    if (frame_rect.contains(cv::Point(tp.found_image_point)) && !inner_rect.contains(cv::Point(tp.found_image_point)))
+      continue;
+
+    const cv::Vec3f camera_coordinates = pose.TransformPoint(tp.model_point);
+    const cv::Point2d projection = camera_->ProjectPoint(cv::Point3d(camera_coordinates[0], camera_coordinates[1], camera_coordinates[2]));
+
+    pose.ComputeJacobian(ci::Vec3f(camera_coordinates[0], camera_coordinates[1], camera_coordinates[2]), point_jacobian_);
+    point_solver_.AddPoint(camera_coordinates, cv::Vec2f((float)projection.x, (float)projection.y), tp.found_image_point, point_jacobian_);
+
+  }
+
+  point_solver_.GetSystem(jtj, jtr);
+  current_error_ = point_solver_.GetError();
+
+  return point_solver_.GetNumberOfPoints();
+
+}
+
 std::vector<float> FeatureLocalizer::GetDerivativesForPointsOnRigidBody(boost::shared_ptr<Model> current_model, const Pose &pose, const cv::Mat &index_image) {
 
   // THIS IS USED IN THE ARTICULATED TRACKER ONLY!
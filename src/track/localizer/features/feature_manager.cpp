@@ -0,0 +1,62 @@
+#include <stdexcept>
+
+#include "../../../../include/ttrack/track/localizer/features/feature_manager.hpp"
+
+using namespace ttrk;
+
+FeatureManager::FeatureManager(const int cell_size, const float min_coverage, const size_t max_new_points_per_frame) : cell_size_(cell_size), min_coverage_(min_coverage), max_new_points_per_frame_(max_new_points_per_frame) {
+
+  if (cell_size <= 0) throw std::runtime_error("Error, feature manager cell size must be positive.");
+
+}
+
+bool FeatureManager::GetTopUpMask(const ModelPointSet &mps, const cv::Mat &component_mask, const int component_idx, cv::Mat &top_up_mask, cv::Rect &roi) const {
+
+  const int grid_cols = (component_mask.cols + cell_size_ - 1) / cell_size_;
+  const int grid_rows = (component_mask.rows + cell_size_ - 1) / cell_size_;
+
+  std::vector<unsigned char> occupied(grid_cols * grid_rows, 0);
+  const std::vector<cv::Point2f> &points = mps.points_test[0];
+  for (size_t i = 0; i < points.size() && i < mps.tracked_points_.size(); ++i){
+
+    const TrackedPoint &tp = mps.tracked_points_[i];
+    if (!tp.point_tracked_on_model) continue;
+    if (component_idx >= 0 && tp.component_idx != component_idx) continue;
+
+    const int cell_x = (int)points[i].x / cell_size_, cell_y = (int)points[i].y / cell_size_;
+    if (points[i].x < 0 || points[i].y < 0 || cell_x >= grid_cols || cell_y >= grid_rows) continue;
+    occupied[cell_y * grid_cols + cell_x] = 1;
+
+  }
+
+  size_t component_cells = 0, empty_cells = 0;
+  std::vector<cv::Rect> empty;
+  for (int cy = 0; cy < grid_rows; ++cy){
+    for (int cx = 0; cx < grid_cols; ++cx){
+
+      const cv::Rect cell = cv::Rect(cx * cell_size_, cy * cell_size_, cell_size_, cell_size_) & cv::Rect(0, 0, component_mask.cols, component_mask.rows);
+      if (cv::countNonZero(component_mask(cell)) == 0) continue;
+
+      component_cells++;
+      if (occupied[cy * grid_cols + cx]) continue;
+
+      empty_cells++;
+      empty.push_back(cell);
+
+    }
+  }
+
+  if (empty.empty() || (component_cells - empty_cells) >= min_coverage_ * component_cells) return false;
+
+  roi = empty.front();
+  for (auto &cell : empty) roi |= cell;
+
+  top_up_mask = cv::Mat::zeros(roi.size(), CV_8UC1);
+  for (auto &cell : empty){
+    const cv::Rect in_roi(cell.x - roi.x, cell.y - roi.y, cell.width, cell.height);
+    component_mask(cell).copyTo(top_up_mask(in_roi));
+  }
+
+  return true;
+
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "../../../../include/ttrack/track/localizer/features/keypoint_grid.hpp"
+
+using namespace ttrk;
+
+KeypointGrid::KeypointGrid(const std::vector<cv::KeyPoint> &keypoints, const float cell_size) : cell_size_(cell_size), grid_cols_(0), grid_rows_(0) {
+
+  if (cell_size <= 0) throw std::runtime_error("Error, keypoint grid cell size must be positive.");
+
+  if (keypoints.empty()) return;
+
+  cv::Point2f max_point = keypoints.front().pt;
+  origin_ = keypoints.front().pt;
+  points_.reserve(keypoints.size());
+  for (auto &kp : keypoints){
+    points_.push_back(kp.pt);
+    origin_.x = std::min(origin_.x, kp.pt.x);
+    origin_.y = std::min(origin_.y, kp.pt.y);
+    max_point.x = std::max(max_point.x, kp.pt.x);
+    max_point.y = std::max(max_point.y, kp.pt.y);
+  }
+
+  grid_cols_ = (int)((max_point.x - origin_.x) / cell_size_) + 1;
+  grid_rows_ = (int)((max_point.y - origin_.y) / cell_size_) + 1;
+  cells_.resize(grid_cols_ * grid_rows_);
+
+  for (size_t i = 0; i < points_.size(); ++i){
+    int cell_x, cell_y;
+    GetCell(points_[i], cell_x, cell_y);
+    cells_[cell_y * grid_cols_ + cell_x].push_back((int)i);
+  }
+
+}
+
+void KeypointGrid::GetCell(const cv::Point2f &point, int &cell_x, int &cell_y) const {
+
+  cell_x = std::min(std::max((int)std::floor((point.x - origin_.x) / cell_size_), 0), grid_cols_ - 1);
+  cell_y = std::min(std::max((int)std::floor((point.y - origin_.y) / cell_size_), 0), grid_rows_ - 1);
+
+}
+
+void KeypointGrid::GetKeypointsNear(const cv::Point2f &point, const float radius, std::vector<int> &indexes) const {
+
+  indexes.clear();
+  if (points_.empty()) return;
+
+  int min_x, min_y, max_x, max_y;
+  GetCell(point - cv::Point2f(radius, radius), min_x, min_y);
+  GetCell(point + cv::Point2f(radius, radius), max_x, max_y);
+
+  const float radius_squared = radius * radius;
+  for (int y = min_y; y <= max_y; ++y){
+    for (int x = min_x; x <= max_x; ++x){
+      for (int idx : cells_[y * grid_cols_ + x]){
+        const cv::Point2f d = points_[idx] - point;
+        if (d.dot(d) < radius_squared) indexes.push_back(idx);
+      }
+    }
+  }
+
+}
+
+void KeypointGrid::Match(const std::vector<cv::KeyPoint> &query_keypoints, const cv::Mat &query_descriptors, const cv::Mat &train_descriptors, const float radius, const int norm_type, std::vector<cv::DMatch> &matches) const {
+
+  if (query_descriptors.rows != (int)query_keypoints.size() || train_descriptors.rows != (int)points_.size())
+    throw std::runtime_error("Error, need one descriptor per keypoint for matching.");
+
+  matches.clear();
+
+  const bool binary = norm_type == cv::NORM_HAMMING;
+  if (binary && (query_descriptors.type() != CV_8UC1 || train_descriptors.type() != CV_8UC1 || query_descriptors.cols != train_descriptors.cols))
+    throw std::runtime_error("Error, Hamming matching needs packed 8 bit descriptors of the same length.");
+
+  std::vector<int> candidates;
+  for (size_t q = 0; q < query_keypoints.size(); ++q){
+
+    GetKeypointsNear(query_keypoints[q].pt, radius, candidates);
+    if (candidates.empty()) continue;
+
+    const cv::Mat query = query_descriptors.row((int)q);
+    cv::DMatch best((int)q, -1, std::numeric_limits<float>::max());
+    for (int t : candidates){
+      const float distance = binary ? (float)HammingDistance(query.ptr<unsigned char>(), train_descriptors.ptr<unsigned char>(t), query.cols) : (float)cv::norm(query, train_descriptors.row(t), norm_type);
+      if (distance < best.distance){
+        best.trainIdx = t;
+        best.distance = distance;
+      }
+    }
+
+    matches.push_back(best);
+
+  }
+
+}
@@ -2,33 +2,67 @@
 
 #include "../../../../include/ttrack/track/localizer/features/lk_tracker.hpp"
 #include "../../../../include/ttrack/utils/helpers.hpp"
+#include "../../../../include/ttrack/utils/profiler.hpp"
 #include <ttrack/track/localizer/localizer.hpp>
 
 using namespace ttrk;
 
-LKTracker::LKTracker(boost::shared_ptr<MonocularCamera> camera) : FeatureLocalizer(camera) {
+LKTracker::LKTracker(boost::shared_ptr<MonocularCamera> camera) : FeatureLocalizer(camera), max_forward_backward_error_(1.0f) {
   win_size_ = cv::Size(31, 31);
   term_crit_ = cv::TermCriteria(CV_TERMCRIT_ITER | CV_TERMCRIT_EPS, 20, 0.03);
+  lk_ = PyramidalLK(win_size_, 3, term_crit_, 0.001f);
 }
 
 void LKTracker::TrackLocalPoints(cv::Mat &current_frame, boost::shared_ptr<Model> current_model){
 
-  cv::cvtColor(current_frame, current_model->mps.current_frame, CV_BGR2GRAY);
+  if (TrackPoints(current_frame, current_model))
+    TopUpPoints(current_model, cv::Mat());
+
+}
+
+void LKTracker::TrackLocalPoints(cv::Mat &current_frame, boost::shared_ptr<Model> current_model, const cv::Mat &component_image){
+
+  if (TrackPoints(current_frame, current_model))
+    TopUpPoints(current_model, component_image);
+
+}
+
+bool LKTracker::TrackPoints(cv::Mat &current_frame, boost::shared_ptr<Model> current_model){
+
+  boost::shared_ptr<sv::FramePyramid> pyramid = GetFramePyramid(current_frame);
+  current_model->mps.current_frame = GetGrayFrame(current_frame);
 
   std::vector<unsigned char> status;
   std::vector<float> err;
 
-  if (current_model->mps.points_test[0].empty()) return;
+  //nothing to track but points can still be added on this frame
+  if (current_model->mps.points_test[0].empty()){
+    current_model->mps.previous_frame = current_model->mps.current_frame;
+    current_model->mps.previous_pyramid = pyramid;
+    return true;
+  }
 
   if (current_model->mps.points_test[0].size() != current_model->mps.tracked_points_.size()){
     current_model->mps.is_initialised = false;
     current_model->mps.points_test[0].clear();
     current_model->mps.points_test[1].clear();
     current_model->mps.tracked_points_.clear();
-    return;
+    return false;
   }
 
-  cv::calcOpticalFlowPyrLK(current_model->mps.previous_frame, current_model->mps.current_frame, current_model->mps.points_test[0], current_model->mps.points_test[1], status, err, win_size_, 3, term_crit_, 0, 0.001);
+  //a frame without a cached pyramid gets its own so the engine always has one, the next frame reuses it as the previous pyramid
+  if (!pyramid) pyramid.reset(new sv::FramePyramid(current_model->mps.current_frame));
+  if (!current_model->mps.previous_pyramid) current_model->mps.previous_pyramid.reset(new sv::FramePyramid(current_model->mps.previous_frame));
+
+  std::vector<float> forward_backward_error;
+  lk_.Track(current_model->mps.previous_pyramid->GetPyramid(win_size_, lk_.GetMaxLevel()), pyramid->GetPyramid(win_size_, lk_.GetMaxLevel()), current_model->mps.points_test[0], current_model->mps.points_test[1], status, forward_backward_error, err);
+  ProfileCount(COUNTER_TRACKED_POINTS, current_model->mps.points_test[1].size());
+
+  //a point that doesn't track back to where it started has drifted onto something else
+  for (size_t i = 0; i < status.size(); ++i){
+    if (forward_backward_error[i] > max_forward_backward_error_)
+      status[i] = 0;
+  }
  
   cv::Mat &x1 = current_model->mps.previous_frame;
   cv::Mat &x2 = current_model->mps.current_frame;
@@ -84,19 +118,10 @@ void LKTracker::TrackLocalPoints(cv::Mat &current_frame, boost::shared_ptr<Model
     if (end_r >= current_frame.rows) end_r = current_frame.rows - 1;
     if (end_c >= current_frame.cols) end_c = current_frame.cols - 1;
 
-    bool should_continue = false;
-    for (int r = start_r; r < end_r; ++r){
-      for (int c = start_c; c < end_c; ++c){
-        //if (Localizer::occlusion_image.at<float>(current_model->mps.points_test[1][i]) < (current_model->mps.front_intersection_image_.at<cv::Vec3f>(current_model->mps.points_test[1][i])[2] - 0.1)) {
-        if (Localizer::occlusion_image.at<float>(r,c) < (current_model->mps.front_intersection_image_.at<cv::Vec3f>(r, c)[2] - 0.1)) {
-          current_model->mps.tracked_points_[i].point_tracked_on_model = false;
-          should_continue = true;
-          break;
-        }
-      }
-      if (should_continue) break;
+    if (IsOccluded(current_model, cv::Rect(start_c, start_r, end_c - start_c, end_r - start_r))){
+      current_model->mps.tracked_points_[i].point_tracked_on_model = false;
+      continue;
     }
-    if (should_continue) continue;        
 
     cv::circle(current_model->debug_info.tracked_feature_points, current_model->mps.points_test[0][i], 2, cv::Scalar(255, 0, 0));
     cv::circle(current_model->debug_info.tracked_feature_points, current_model->mps.points_test[1][i], 2, cv::Scalar(0, 0, 255));
@@ -114,9 +139,97 @@ void LKTracker::TrackLocalPoints(cv::Mat &current_frame, boost::shared_ptr<Model
     current_model->mps.is_initialised = false;
   }
 
-  std::swap(current_model->mps.points_test[0], current_model->mps.points_test[1]);
+  //lost points and points which left the model (off the border, onto the background or behind an occluder) are dropped rather than 
+  //tracked on from wherever LK left them, the feature manager replaces them where they're needed
+  std::vector<TrackedPoint> kept_points;
+  std::vector<cv::Point2f> kept_positions;
+  kept_points.reserve(status.size());
+  kept_positions.reserve(status.size());
+  for (size_t i = 0; i < status.size(); ++i){
+    if (!current_model->mps.tracked_points_[i].point_tracked_on_model) continue;
+    kept_points.push_back(current_model->mps.tracked_points_[i]);
+    kept_positions.push_back(current_model->mps.points_test[1][i]);
+  }
+  current_model->mps.tracked_points_.swap(kept_points);
+  current_model->mps.points_test[0].swap(kept_positions);
+  current_model->mps.points_test[1].clear();
+
+  //the gray frame is never written to so the next frame can share it
+  current_model->mps.previous_frame = current_model->mps.current_frame;
+  current_model->mps.previous_pyramid = pyramid;
 
-  current_model->mps.previous_frame = current_model->mps.current_frame.clone();
+  return current_model->mps.is_initialised;
+
+}
+
+void LKTracker::TopUpPoints(boost::shared_ptr<Model> current_model, const cv::Mat &component_image){
+
+  const cv::Size subPixWinSize(10, 10);
+  ModelPointSet &mps = current_model->mps;
+  const cv::Mat &gray = mps.current_frame;
+  const cv::Mat visible = CreateMask(current_model);
+
+  //the same components and per component budget as InitializeTracker
+  std::vector<int> components;
+  size_t max_points_per_component = 50;
+  if (component_image.empty()){
+    components.push_back(-1);
+  }
+  else{
+    for (int i = 0; i < 6; ++i) if (i != 2 && i != 3) components.push_back(i);
+    max_points_per_component = 15;
+  }
+
+  size_t budget = feature_manager_.GetMaxNewPointsPerFrame();
+
+  for (auto component : components){
+
+    if (budget == 0) break;
+
+    size_t existing = 0;
+    for (auto &tp : mps.tracked_points_){
+      if (component < 0 || tp.component_idx == component) existing++;
+    }
+    if (existing >= max_points_per_component) continue;
+
+    cv::Mat component_mask = visible;
+    if (component >= 0) component_mask = visible & (component_image == component);
+
+    cv::Mat top_up_mask;
+    cv::Rect roi;
+    if (!feature_manager_.GetTopUpMask(mps, component_mask, component, top_up_mask, roi)) continue;
+
+    std::vector<cv::Point2f> new_points;
+    cv::goodFeaturesToTrack(gray(roi), new_points, (int)std::min(budget, max_points_per_component - existing), 0.01, 10, top_up_mask, 3, 0, 0.04);
+    if (new_points.empty()) continue;
+    cv::cornerSubPix(gray(roi), new_points, subPixWinSize, cv::Size(-1, -1), term_crit_);
+
+    for (auto &pt : new_points){
+
+      pt += cv::Point2f((float)roi.x, (float)roi.y);
+
+      const cv::Point rounded(std::round(pt.x), std::round(pt.y));
+      if (!cv::Rect(0, 0, gray.cols, gray.rows).contains(rounded)) continue;
+
+      const cv::Vec3f &point_on_model = mps.front_intersection_image_.at<cv::Vec3f>(rounded);
+      if (point_on_model[0] == GL_FAR || point_on_model[1] == GL_FAR || point_on_model[2] == GL_FAR) continue;
+
+      const unsigned char idx = component_image.empty() ? 0 : component_image.at<unsigned char>(rounded);
+      const Pose pose = component_image.empty() ? current_model->GetBasePose() : current_model->GetComponentPose(idx);
+
+      //found where it was detected, so it would register the previous pose with zero residual. it joins registration once it has been
+      //tracked into the next frame
+      mps.tracked_points_.push_back(TrackedPoint(pose.InverseTransformPoint(point_on_model), pt));
+      mps.tracked_points_.back().component_idx = idx;
+      mps.tracked_points_.back().point_tracked_on_model = false;
+      mps.tracked_points_.back().point_in_view = true;
+      mps.points_test[0].push_back(pt);
+
+      budget--;
+
+    }
+
+  }
 
 }
 
@@ -124,11 +237,7 @@ void LKTracker::InitializeTracker(cv::Mat &current_frame, const boost::shared_pt
 
   const cv::Size subPixWinSize(10, 10);
    
-  cv::Mat gray;
-  if (current_frame.type() == CV_8UC3)
-    cv::cvtColor(current_frame, gray, CV_BGR2GRAY);
-  else if (current_frame.type() == CV_8UC1)
-    gray = current_frame.clone();
+  cv::Mat gray = GetGrayFrame(current_frame);
 
 
   current_model->mps.points_test[0].clear();
@@ -167,7 +276,8 @@ void LKTracker::InitializeTracker(cv::Mat &current_frame, const boost::shared_pt
   }
  
 
-  current_model->mps.previous_frame = gray.clone();
+  current_model->mps.previous_frame = gray;
+  current_model->mps.previous_pyramid = GetFramePyramid(current_frame);
   current_model->mps.is_initialised = true;
 
 }
@@ -176,11 +286,7 @@ void LKTracker::InitializeTracker(cv::Mat &current_frame, const boost::shared_pt
 
   const cv::Size subPixWinSize(10, 10);
 
-  cv::Mat gray;
-  if (current_frame.type() == CV_8UC3)
-    cv::cvtColor(current_frame, gray, CV_BGR2GRAY);
-  else if (current_frame.type() == CV_8UC1)
-    gray = current_frame.clone();
+  cv::Mat gray = GetGrayFrame(current_frame);
   
   current_model->mps.points_test[0].clear();
   current_model->mps.points_test[1].clear();
@@ -231,7 +337,8 @@ void LKTracker::InitializeTracker(cv::Mat &current_frame, const boost::shared_pt
     int x = 0;
   }
 
-  current_model->mps.previous_frame = gray.clone();
+  current_model->mps.previous_frame = gray;
+  current_model->mps.previous_pyramid = GetFramePyramid(current_frame);
   current_model->mps.is_initialised = true;
 
 }
@@ -326,7 +433,7 @@ std::vector<float> LKTracker3D::GetUpdateStep(boost::shared_ptr<Model> current_m
 
 void LKTracker3D::TrackLocalPoints(cv::Mat &current_frame, const Pose &pose, boost::shared_ptr<Model> current_model){
 
-  cv::cvtColor(current_frame, current_model->mps.current_frame, CV_BGR2GRAY);
+  current_model->mps.current_frame = GetGrayFrame(current_frame);
 
   const int half_win_size = 15;
 
@@ -364,7 +471,11 @@ void LKTracker3D::TrackLocalPoints(cv::Mat &current_frame, const Pose &pose, boo
 
   if (current_model->mps.points_test[0].empty()) return;
 
-  cv::calcOpticalFlowPyrLK(current_model->mps.previous_frame, current_model->mps.current_frame, current_model->mps.points_test[0], current_model->mps.points_test[1], status, err, win_size_, 3, term_crit_, 0, 0.001);
+  //term_crit_ grows by one iteration a step, so each step tracks from the previous frame again on the same engine as LKTracker
+  sv::FramePyramid previous_pyramid(current_model->mps.previous_frame), current_pyramid(current_model->mps.current_frame);
+  const PyramidalLK step_lk(LKTracker::win_size_, 3, term_crit_, 0.001f);
+  step_lk.TrackForward(previous_pyramid.GetPyramid(LKTracker::win_size_, 3), current_pyramid.GetPyramid(LKTracker::win_size_, 3), current_model->mps.points_test[0], current_model->mps.points_test[1], status, err);
+  ProfileCount(COUNTER_TRACKED_POINTS, current_model->mps.points_test[1].size());
 
   std::stringstream ss;
   ss << "c:/tmp/lk_tracker_frame_" << frame_count_ << "_step_" << current_step_index << ".png";
@@ -402,7 +513,8 @@ void LKTracker3D::TrackLocalPoints(cv::Mat &current_frame, const Pose &pose, boo
 void ArticulalatedLKTrackerFrameToFrame::TrackLocalPoints(cv::Mat &current_frame, boost::shared_ptr<Model> current_model, const cv::Mat &component_image){
   
   if (current_model->mps.previous_frame.empty()){
-    current_model->mps.previous_frame = current_frame.clone();
+    current_model->mps.previous_frame = GetGrayFrame(current_frame);
+    current_model->mps.previous_pyramid = GetFramePyramid(current_frame);
     return;
   }
 
@@ -412,7 +524,7 @@ void ArticulalatedLKTrackerFrameToFrame::TrackLocalPoints(cv::Mat &current_frame
   if (current_model->mps.previous_frame.type() == CV_8UC3)
     cv::cvtColor(current_model->mps.previous_frame, gray, CV_BGR2GRAY);
   else if (current_model->mps.previous_frame.type() == CV_8UC1)
-    gray = current_model->mps.previous_frame.clone();
+    gray = current_model->mps.previous_frame;
 
   current_model->mps.points_test[0].clear();
   current_model->mps.points_test[1].clear();
@@ -452,9 +564,9 @@ void ArticulalatedLKTrackerFrameToFrame::TrackLocalPoints(cv::Mat &current_frame
     }
   }
 
-  current_model->mps.previous_frame = gray.clone();
+  current_model->mps.previous_frame = gray;
   current_model->mps.is_initialised = true;
-  LKTracker::TrackLocalPoints(current_frame, current_model);
+  TrackPoints(current_frame, current_model);
 
 }
 
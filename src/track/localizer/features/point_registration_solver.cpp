@@ -0,0 +1,121 @@
+#include <cmath>
+
+#include "../../../../include/ttrack/track/localizer/features/point_registration_solver.hpp"
+
+using namespace ttrk;
+
+PointRegistrationSolver::PointRegistrationSolver(const RobustLoss loss, const float loss_scale) : loss_(loss), loss_scale_(loss_scale), fx_(0), fy_(0), number_of_dofs_(0), number_of_points_(0), error_(0) {
+
+  if (loss_scale <= 0) throw std::runtime_error("Error, the point registration loss scale must be positive.");
+
+}
+
+void PointRegistrationSolver::Reset(const float fx, const float fy, const size_t number_of_dofs){
+
+  fx_ = fx;
+  fy_ = fy;
+  number_of_dofs_ = number_of_dofs;
+  number_of_points_ = 0;
+  error_ = 0;
+
+}
+
+void PointRegistrationSolver::AddPoint(const cv::Vec3f &point_in_camera_coords, const cv::Vec2f &projection, const cv::Vec2f &found_image_point, const std::vector<ci::Vec3f> &point_jacobian){
+
+  if (point_jacobian.size() < number_of_dofs_) throw std::runtime_error("Error, the point jacobian has too few degrees of freedom.");
+
+  //the storage only grows, after the first few frames adding a point never allocates
+  const size_t row = 2 * number_of_points_;
+  if (residuals_.size() < row + 2){
+    residuals_.resize(row + 2);
+    weights_.resize(number_of_points_ + 1);
+  }
+  if (jacobian_.size() < (row + 2) * number_of_dofs_)
+    jacobian_.resize((row + 2) * number_of_dofs_);
+
+  const float x = point_in_camera_coords[0], y = point_in_camera_coords[1];
+  float z = point_in_camera_coords[2];
+  if (z == 0.0f) z = 0.001f;
+  const float z_inv_sq = 1.0f / (z * z);
+
+  float *dx_dl = &jacobian_[row * number_of_dofs_];
+  float *dy_dl = dx_dl + number_of_dofs_;
+  for (size_t dof = 0; dof < number_of_dofs_; ++dof){
+    const ci::Vec3f &d = point_jacobian[dof];
+    dx_dl[dof] = fx_ * z_inv_sq * ((z * d[0]) - (x * d[2]));
+    dy_dl[dof] = fy_ * z_inv_sq * ((z * d[1]) - (y * d[2]));
+  }
+
+  residuals_[row] = projection[0] - found_image_point[0];
+  residuals_[row + 1] = projection[1] - found_image_point[1];
+
+  float weight;
+  error_ += GetLoss(std::sqrt(residuals_[row] * residuals_[row] + residuals_[row + 1] * residuals_[row + 1]), weight);
+  weights_[number_of_points_] = weight;
+
+  number_of_points_++;
+
+}
+
+void PointRegistrationSolver::GetSystem(float *jtj, float *jtr) const {
+
+  const size_t n = number_of_dofs_;
+  for (size_t i = 0; i < n * n; ++i) jtj[i] = 0.0f;
+  for (size_t i = 0; i < n; ++i) jtr[i] = 0.0f;
+
+  //upper triangle only, the jacobian rows are contiguous so each rank 1 update streams through one row
+  for (size_t row = 0; row < 2 * number_of_points_; ++row){
+
+    const float weight = weights_[row / 2];
+    if (weight == 0.0f) continue;
+
+    const float *j = &jacobian_[row * n];
+    const float weighted_residual = weight * residuals_[row];
+    for (size_t a = 0; a < n; ++a){
+      const float weighted_j = weight * j[a];
+      jtr[a] += j[a] * weighted_residual;
+      for (size_t b = a; b < n; ++b){
+        jtj[a * n + b] += weighted_j * j[b];
+      }
+    }
+
+  }
+
+  for (size_t a = 0; a < n; ++a){
+    for (size_t b = 0; b < a; ++b){
+      jtj[a * n + b] = jtj[b * n + a];
+    }
+  }
+
+}
+
+float PointRegistrationSolver::GetLoss(const float distance, float &weight) const {
+
+  const float k = loss_scale_;
+
+  switch (loss_){
+
+  case HUBER:
+    if (distance <= k){
+      weight = 1.0f;
+      return 0.5f * distance * distance;
+    }
+    weight = k / distance;
+    return k * (distance - 0.5f * k);
+
+  case TUKEY:
+    if (distance < k){
+      const float u = 1.0f - (distance / k) * (distance / k);
+      weight = u * u;
+      return (k * k / 6.0f) * (1.0f - u * u * u);
+    }
+    weight = 0.0f;
+    return k * k / 6.0f;
+
+  default:
+    weight = 1.0f;
+    return 0.5f * distance * distance;
+
+  }
+
+}
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "../../../../include/ttrack/track/localizer/features/pyramidal_lk.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TTRK_LK_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace ttrk;
+
+namespace {
+
+  //cv::buildOpticalFlowPyramid's gradients are Scharr derivatives, 32 times the intensity gradient
+  const float GRADIENT_SCALE = 1.0f / 32;
+
+  struct BilinearWeights {
+    float w00, w01, w10, w11;
+  };
+
+  //find the pixel at the top left of a window and its bilinear weights, false if the window and the column/row after it aren't all
+  //inside the image's allocation. the pyramid levels are padded by the window size so a window can hang over the edge of the image
+  bool LocateWindow(const cv::Mat &image, const cv::Point2f &top_left, const cv::Size win_size, int &x, int &y, BilinearWeights &weights){
+
+    x = (int)std::floor(top_left.x);
+    y = (int)std::floor(top_left.y);
+
+    cv::Size whole;
+    cv::Point offset;
+    image.locateROI(whole, offset);
+    if (x + offset.x < 0 || y + offset.y < 0 || x + offset.x + win_size.width + 1 > whole.width || y + offset.y + win_size.height + 1 > whole.height) return false;
+
+    const float a = top_left.x - x, b = top_left.y - y;
+    weights.w00 = (1 - a) * (1 - b);
+    weights.w01 = a * (1 - b);
+    weights.w10 = (1 - a) * b;
+    weights.w11 = a * b;
+    return true;
+
+  }
+
+  template<typename T>
+  inline const T *GetPixel(const cv::Mat &image, const int x, const int y, const int channels){
+    return reinterpret_cast<const T *>(image.data + (ptrdiff_t)y * (ptrdiff_t)image.step) + (ptrdiff_t)x * channels;
+  }
+
+#ifdef TTRK_LK_SSE2
+
+  inline __m128 LoadFour(const unsigned char *pixels){
+
+    int packed;
+    std::memcpy(&packed, pixels, sizeof(packed));
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero));
+
+  }
+
+  //4 interleaved dx/dy pairs split into a register of each
+  inline void LoadFourGradients(const short *gradients, __m128 &dx, __m128 &dy){
+
+    const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(gradients));
+    const __m128 d01 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+    const __m128 d23 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16));
+    dx = _mm_shuffle_ps(d01, d23, _MM_SHUFFLE(2, 0, 2, 0));
+    dy = _mm_shuffle_ps(d01, d23, _MM_SHUFFLE(3, 1, 3, 1));
+
+  }
+
+  inline __m128 Interpolate(const __m128 p00, const __m128 p01, const __m128 p10, const __m128 p11, const BilinearWeights &w){
+
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(p00, _mm_set1_ps(w.w00)), _mm_mul_ps(p01, _mm_set1_ps(w.w01))),
+      _mm_add_ps(_mm_mul_ps(p10, _mm_set1_ps(w.w10)), _mm_mul_ps(p11, _mm_set1_ps(w.w11))));
+
+  }
+
+  inline float HorizontalSum(const __m128 v){
+
+    const __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+
+  }
+
+#endif
+
+  //bilinearly sample n pixels from a pair of rows, reading n + 1 pixels of each
+  void SampleRow(const unsigned char *row0, const unsigned char *row1, const int n, const BilinearWeights &w, float *out){
+
+    int x = 0;
+
+#ifdef TTRK_LK_SSE2
+    for (; x + 4 <= n; x += 4){
+      _mm_storeu_ps(out + x, Interpolate(LoadFour(row0 + x), LoadFour(row0 + x + 1), LoadFour(row1 + x), LoadFour(row1 + x + 1), w));
+    }
+#endif
+
+    for (; x < n; ++x){
+      out[x] = w.w00 * row0[x] + w.w01 * row0[x + 1] + w.w10 * row1[x] + w.w11 * row1[x + 1];
+    }
+
+  }
+
+  //bilinearly sample n interleaved gradients from a pair of rows, scaled to intensity units
+  void SampleGradientRow(const short *row0, const short *row1, const int n, const BilinearWeights &weights, float *dx, float *dy){
+
+    const BilinearWeights w = { weights.w00 * GRADIENT_SCALE, weights.w01 * GRADIENT_SCALE, weights.w10 * GRADIENT_SCALE, weights.w11 * GRADIENT_SCALE };
+
+    int x = 0;
+
+#ifdef TTRK_LK_SSE2
+    for (; x + 4 <= n; x += 4){
+      __m128 dx00, dy00, dx01, dy01, dx10, dy10, dx11, dy11;
+      LoadFourGradients(row0 + 2 * x, dx00, dy00);
+      LoadFourGradients(row0 + 2 * x + 2, dx01, dy01);
+      LoadFourGradients(row1 + 2 * x, dx10, dy10);
+      LoadFourGradients(row1 + 2 * x + 2, dx11, dy11);
+      _mm_storeu_ps(dx + x, Interpolate(dx00, dx01, dx10, dx11, w));
+      _mm_storeu_ps(dy + x, Interpolate(dy00, dy01, dy10, dy11, w));
+    }
+#endif
+
+    for (; x < n; ++x){
+      dx[x] = w.w00 * row0[2 * x] + w.w01 * row0[2 * x + 2] + w.w10 * row1[2 * x] + w.w11 * row1[2 * x + 2];
+      dy[x] = w.w00 * row0[2 * x + 1] + w.w01 * row0[2 * x + 3] + w.w10 * row1[2 * x + 1] + w.w11 * row1[2 * x + 3];
+    }
+
+  }
+
+  //add a row's intensity differences weighted by the template gradients to the right hand side of the LK system
+  void AccumulateMismatch(const float *current, const float *templ, const float *dx, const float *dy, const int n, float &b1, float &b2){
+
+    int x = 0;
+
+#ifdef TTRK_LK_SSE2
+    __m128 sum1 = _mm_setzero_ps(), sum2 = _mm_setzero_ps();
+    for (; x + 4 <= n; x += 4){
+      const __m128 diff = _mm_sub_ps(_mm_loadu_ps(current + x), _mm_loadu_ps(templ + x));
+      sum1 = _mm_add_ps(sum1, _mm_mul_ps(diff, _mm_loadu_ps(dx + x)));
+      sum2 = _mm_add_ps(sum2, _mm_mul_ps(diff, _mm_loadu_ps(dy + x)));
+    }
+    b1 += HorizontalSum(sum1);
+    b2 += HorizontalSum(sum2);
+#endif
+
+    for (; x < n; ++x){
+      const float diff = current[x] - templ[x];
+      b1 += diff * dx[x];
+      b2 += diff * dy[x];
+    }
+
+  }
+
+  float SumAbsoluteDifference(const float *current, const float *templ, const int n){
+
+    float sum = 0;
+    int x = 0;
+
+#ifdef TTRK_LK_SSE2
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 sums = _mm_setzero_ps();
+    for (; x + 4 <= n; x += 4){
+      sums = _mm_add_ps(sums, _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(current + x), _mm_loadu_ps(templ + x)), abs_mask));
+    }
+    sum = HorizontalSum(sums);
+#endif
+
+    for (; x < n; ++x){
+      sum += std::abs(current[x] - templ[x]);
+    }
+
+    return sum;
+
+  }
+
+}
+
+PyramidalLK::PyramidalLK(const cv::Size win_size, const int max_level, const cv::TermCriteria criteria, const float min_eigen_threshold) : win_size_(win_size), max_level_(max_level), max_iterations_(30), epsilon_squared_(0.01f * 0.01f), min_eigen_threshold_(min_eigen_threshold / (GRADIENT_SCALE * GRADIENT_SCALE)) {
+
+  if (win_size.width < 3 || win_size.height < 3) throw std::runtime_error("Error, the LK window must be at least 3x3.");
+  if (max_level < 0) throw std::runtime_error("Error, the LK pyramid level can't be negative.");
+
+  //the same defaults and limits as cv::calcOpticalFlowPyrLK
+  if (criteria.type & cv::TermCriteria::COUNT)
+    max_iterations_ = std::min(std::max(criteria.maxCount, 0), 100);
+  if (criteria.type & cv::TermCriteria::EPS){
+    const float epsilon = std::min(std::max((float)criteria.epsilon, 0.0f), 10.0f);
+    epsilon_squared_ = epsilon * epsilon;
+  }
+
+}
+
+int PyramidalLK::GetLevels(const std::vector<cv::Mat> &previous_pyramid, const std::vector<cv::Mat> &current_pyramid) const {
+
+  if (previous_pyramid.size() < 2 || current_pyramid.size() < 2 || previous_pyramid[0].type() != CV_8UC1 || current_pyramid[0].type() != CV_8UC1 || previous_pyramid[1].type() != CV_16SC2 || current_pyramid[1].type() != CV_16SC2)
+    throw std::runtime_error("Error, the LK pyramids need 8 bit images with the gradients from cv::buildOpticalFlowPyramid.");
+
+  if (previous_pyramid[0].size() != current_pyramid[0].size())
+    throw std::runtime_error("Error, the LK pyramids are for different sized frames.");
+
+  return std::min(max_level_, (int)std::min(previous_pyramid.size(), current_pyramid.size()) / 2 - 1);
+
+}
+
+void PyramidalLK::Track(const std::vector<cv::Mat> &previous_pyramid, const std::vector<cv::Mat> &current_pyramid, const std::vector<cv::Point2f> &previous_points, std::vector<cv::Point2f> &current_points, std::vector<unsigned char> &status, std::vector<float> &forward_backward_error, std::vector<float> &residuals) const {
+
+  TrackForward(previous_pyramid, current_pyramid, previous_points, current_points, status, residuals);
+
+  const int levels = GetLevels(previous_pyramid, current_pyramid);
+  std::vector<float> patch(3 * win_size_.area() + win_size_.width);
+
+  forward_backward_error.assign(previous_points.size(), FLT_MAX);
+  for (size_t i = 0; i < previous_points.size(); ++i){
+
+    if (!status[i]) continue;
+
+    cv::Point2f back;
+    float back_residual;
+    if (!TrackPoint(current_pyramid, previous_pyramid, levels, current_points[i], back, back_residual, patch)){
+      status[i] = 0;
+      continue;
+    }
+
+    const cv::Point2f error = back - previous_points[i];
+    forward_backward_error[i] = std::sqrt(error.dot(error));
+
+  }
+
+}
+
+void PyramidalLK::TrackForward(const std::vector<cv::Mat> &previous_pyramid, const std::vector<cv::Mat> &current_pyramid, const std::vector<cv::Point2f> &previous_points, std::vector<cv::Point2f> &current_points, std::vector<unsigned char> &status, std::vector<float> &residuals) const {
+
+  const int levels = GetLevels(previous_pyramid, current_pyramid);
+  std::vector<float> patch(3 * win_size_.area() + win_size_.width);
+
+  //TrackPoint only writes a point and residual when it succeeds so lost points stay where they started
+  current_points = previous_points;
+  status.assign(previous_points.size(), 0);
+  residuals.assign(previous_points.size(), FLT_MAX);
+
+  for (size_t i = 0; i < previous_points.size(); ++i){
+    status[i] = TrackPoint(previous_pyramid, current_pyramid, levels, previous_points[i], current_points[i], residuals[i], patch) ? 1 : 0;
+  }
+
+}
+
+bool PyramidalLK::TrackPoint(const std::vector<cv::Mat> &from_pyramid, const std::vector<cv::Mat> &to_pyramid, const int levels, const cv::Point2f &from, cv::Point2f &to, float &residual, std::vector<float> &patch) const {
+
+  const int width = win_size_.width, height = win_size_.height, area = win_size_.area();
+  float *templ = &patch[0], *templ_dx = templ + area, *templ_dy = templ_dx + area, *row = templ_dy + area;
+  const cv::Point2f half_win((width - 1) * 0.5f, (height - 1) * 0.5f);
+
+  cv::Point2f next;
+  for (int level = levels; level >= 0; --level){
+
+    const cv::Mat &from_image = from_pyramid[2 * level], &from_gradients = from_pyramid[2 * level + 1];
+    const cv::Mat &to_image = to_pyramid[2 * level];
+
+    const float scale = 1.0f / (1 << level);
+    next = level == levels ? from * scale : next * 2.0f;
+
+    //as in cv::calcOpticalFlowPyrLK a coarse level that can't be tracked is skipped, only the finest level has to succeed
+    int x, y;
+    BilinearWeights w;
+    if (!LocateWindow(from_image, from * scale - half_win, win_size_, x, y, w) || !LocateWindow(from_gradients, from * scale - half_win, win_size_, x, y, w)){
+      if (level == 0) return false;
+      continue;
+    }
+
+    //the template window and its gradients are sampled once per level and reused by every iteration
+    float A11 = 0, A12 = 0, A22 = 0;
+    for (int r = 0; r < height; ++r){
+
+      float *I = templ + r * width, *Ix = templ_dx + r * width, *Iy = templ_dy + r * width;
+      SampleRow(GetPixel<unsigned char>(from_image, x, y + r, 1), GetPixel<unsigned char>(from_image, x, y + r + 1, 1), width, w, I);
+      SampleGradientRow(GetPixel<short>(from_gradients, x, y + r, 2), GetPixel<short>(from_gradients, x, y + r + 1, 2), width, w, Ix, Iy);
+
+      for (int c = 0; c < width; ++c){
+        A11 += Ix[c] * Ix[c];
+        A12 += Ix[c] * Iy[c];
+        A22 += Iy[c] * Iy[c];
+      }
+
+    }
+
+    const float D = A11 * A22 - A12 * A12;
+    const float min_eigenvalue = (A22 + A11 - std::sqrt((A11 - A22) * (A11 - A22) + 4.0f * A12 * A12)) / (2 * area);
+    if (min_eigenvalue < min_eigen_threshold_ || D < FLT_EPSILON){
+      if (level == 0) return false;
+      continue;
+    }
+
+    cv::Point2f previous_delta;
+    for (int iteration = 0; iteration < max_iterations_; ++iteration){
+
+      if (!LocateWindow(to_image, next - half_win, win_size_, x, y, w)){
+        if (level == 0) return false;
+        break;
+      }
+
+      float b1 = 0, b2 = 0;
+      for (int r = 0; r < height; ++r){
+        SampleRow(GetPixel<unsigned char>(to_image, x, y + r, 1), GetPixel<unsigned char>(to_image, x, y + r + 1, 1), width, w, row);
+        AccumulateMismatch(row, templ + r * width, templ_dx + r * width, templ_dy + r * width, width, b1, b2);
+      }
+
+      const cv::Point2f delta((A12 * b2 - A22 * b1) / D, (A12 * b1 - A11 * b2) / D);
+      next += delta;
+
+      if (delta.dot(delta) <= epsilon_squared_) break;
+
+      //oscillating between two positions, settle in the middle
+      if (iteration > 0 && std::abs(delta.x + previous_delta.x) < 0.01f && std::abs(delta.y + previous_delta.y) < 0.01f){
+        next -= delta * 0.5f;
+        break;
+      }
+
+      previous_delta = delta;
+
+    }
+
+  }
+
+  //the residual is measured where the point ended up against the finest level template
+  int x, y;
+  BilinearWeights w;
+  if (!LocateWindow(to_pyramid[0], next - half_win, win_size_, x, y, w)) return false;
+
+  float sum = 0;
+  for (int r = 0; r < height; ++r){
+    SampleRow(GetPixel<unsigned char>(to_pyramid[0], x, y + r, 1), GetPixel<unsigned char>(to_pyramid[0], x, y + r + 1, 1), width, w, row);
+    sum += SumAbsoluteDifference(row, templ + r * width, width);
+  }
+
+  residual = sum / area;
+  to = next;
+  return true;
+
+}
@@ -4,8 +4,11 @@
 #include <opencv2/nonfree/features2d.hpp>
 #include <opencv2/legacy/legacy.hpp>
 #include <numeric>
+#include <limits>
 
 #include "../../../include/ttrack/track/localizer/features/register_points.hpp"
+#include "../../../include/ttrack/track/localizer/features/keypoint_grid.hpp"
+#include "../../../include/ttrack/track/localizer/features/descriptor_map.hpp"
 #include "../../../include/ttrack/utils/helpers.hpp"
 #include "../../../include/ttrack/track/localizer/levelsets/pwp3d.hpp"
 #include "../../../include/ttrack/constants.hpp"
@@ -15,6 +18,38 @@
 
 using namespace ttrk;
 
+namespace {
+
+  //out of the 256 bits of an ORB descriptor, above this the match is unlikely to be correct whatever the best match in the frame is
+  const double MAX_ORB_HAMMING_DISTANCE = 64;
+
+  //how far from its projection at the current pose estimate a map descriptor is searched for, inside the 25 px the derivatives accept
+  const float MAP_SEARCH_RADIUS = 20.0f;
+
+  //the surface normal at a pixel of a front intersection image from the neighbouring points, facing the camera
+  bool GetSurfaceNormal(const cv::Mat &front_intersection_image, const cv::Point &pixel, cv::Vec3f &normal){
+
+    if (!cv::Rect(1, 1, front_intersection_image.cols - 2, front_intersection_image.rows - 2).contains(pixel)) return false;
+
+    const cv::Vec3f &centre = front_intersection_image.at<cv::Vec3f>(pixel);
+    const cv::Vec3f &left = front_intersection_image.at<cv::Vec3f>(pixel.y, pixel.x - 1);
+    const cv::Vec3f &right = front_intersection_image.at<cv::Vec3f>(pixel.y, pixel.x + 1);
+    const cv::Vec3f &up = front_intersection_image.at<cv::Vec3f>(pixel.y - 1, pixel.x);
+    const cv::Vec3f &down = front_intersection_image.at<cv::Vec3f>(pixel.y + 1, pixel.x);
+    if (left[2] == GL_FAR || right[2] == GL_FAR || up[2] == GL_FAR || down[2] == GL_FAR) return false;
+
+    normal = (right - left).cross(down - up);
+    const float length = (float)cv::norm(normal);
+    if (length == 0) return false;
+
+    normal *= 1.0f / length;
+    if (normal.dot(centre) > 0) normal = -normal;
+    return true;
+
+  }
+
+}
+
 PointRegistration::PointRegistration(boost::shared_ptr<MonocularCamera> camera) : FeatureLocalizer(camera) {  }
 
 void PointRegistration::ComputeRootSiftFeatureFromSiftFeatures(cv::Mat &sift_descriptors) const{
@@ -40,54 +75,78 @@ void PointRegistration::ComputeRootSiftFeatureFromSiftFeatures(cv::Mat &sift_des
 
 }
 
-void deinterlace(cv::Mat& m)
-{
-  for (int i = 0; i<m.rows; ++i)
-    if (i % 2)
-      m.row(i - 1).copyTo(m.row(i));
+void PointRegistration::DescribeFrame(const cv::Mat &gray, const cv::Mat &mask, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors) const {
+
+  //one pass so detection and description share the scale space
+  cv::SIFT sift;
+  sift(gray, mask, keypoints, descriptors);
+
+  /**
+  * Implementing RootSift from Three things everyone should know to improve object retrieval, Arandjelovic & Zisserman, CVPR 2012
+  */
+  if (!descriptors.empty()) ComputeRootSiftFeatureFromSiftFeatures(descriptors);
+
 }
 
 void PointRegistration::TrackLocalPoints(cv::Mat &current_frame, const boost::shared_ptr<Model> current_model){
 
-  cv::cvtColor(current_frame, current_model->mps.current_frame, CV_BGR2GRAY);
-
-  cv::Mat current_frame_deinterlaced = current_frame.clone();
+  //interlaced input is deinterlaced once when the frame is loaded (see TTrack::SetDeinterlaceMode)
+  current_model->mps.current_frame = GetGrayFrame(current_frame);
 
-  deinterlace(current_frame_deinterlaced);
-  deinterlace(current_model->mps.current_frame);
+  //-- Step 1: Detect the keypoints and compute the RootSIFT descriptors, the previous frame's were kept from the last call
+  ModelPointSet &mps = current_model->mps;
+  const cv::Mat mask = CreateMask(current_model);
 
-  //-- Step 1: Detect the keypoints using SIFT Detector
-  
+  if (!mps.descriptor_map) mps.descriptor_map.reset(new DescriptorMap());
+  DescriptorMap &descriptor_map = *mps.descriptor_map;
 
-  cv::SiftDescriptorExtractor detector;
+  //they are missing if the previous frame had no keypoints or the tracker was reinitialised against the map, only the first needs them
+  if (mps.previous_descriptors.empty() && !mps.previous_frame.empty() && descriptor_map.Empty())
+    DescribeFrame(mps.previous_frame, mask, mps.previous_keypoints, mps.previous_descriptors);
 
   std::vector<cv::KeyPoint> keypoints_in_current_frame;
-  std::vector<cv::KeyPoint> keypoints_in_previous_frame;
+  cv::Mat descriptors_in_current_frame;
+  DescribeFrame(mps.current_frame, mask, keypoints_in_current_frame, descriptors_in_current_frame);
 
-  detector.detect(current_model->mps.current_frame, keypoints_in_current_frame, CreateMask(current_model));
-  detector.detect(current_model->mps.previous_frame, keypoints_in_previous_frame, CreateMask(current_model));
+  const std::vector<cv::KeyPoint> &keypoints_in_previous_frame = mps.previous_keypoints;
+  const cv::Mat &descriptors_in_previous_frame = mps.previous_descriptors;
 
-  //-- Step 2: Calculate descriptors (feature vectors)
-  cv::SiftDescriptorExtractor extractor;
+  current_model->mps.tracked_points_.clear();
+  current_model->debug_info.tracked_feature_points = current_frame.clone();
 
-  cv::Mat descriptors_in_current_frame;
-  cv::Mat descriptors_in_previous_frame;
+  //-- Step 2: Register the keypoints against the descriptors already on the model's surface, searching around their projection
+  const Pose pose = current_model->GetBasePose();
+  std::vector<bool> keypoint_registered(keypoints_in_current_frame.size(), false);
+  std::vector< cv::DMatch > map_matches;
+  std::vector<cv::Point2f> map_projections;
 
-  extractor.compute(current_model->mps.current_frame, keypoints_in_current_frame, descriptors_in_current_frame);
-  extractor.compute(current_model->mps.previous_frame, keypoints_in_previous_frame, descriptors_in_previous_frame);
+  if (!descriptors_in_current_frame.empty())
+    descriptor_map.Match(pose, camera_, keypoints_in_current_frame, descriptors_in_current_frame, MAP_SEARCH_RADIUS, GetDescriptorNorm(), map_matches, map_projections);
 
-  current_model->mps.tracked_points_.clear();
-  current_model->debug_info.tracked_feature_points = current_frame_deinterlaced.clone();
+  double min_map_dist = std::numeric_limits<double>::max();
+  for (auto &match : map_matches) min_map_dist = std::min(min_map_dist, (double)match.distance);
 
-  /**
-  * Implementing RootSift from Three things everyone should know to improve object retrieval, Arandjelovic & Zisserman, CVPR 2012
-  */
-  
-  ComputeRootSiftFeatureFromSiftFeatures(descriptors_in_current_frame);
-  ComputeRootSiftFeatureFromSiftFeatures(descriptors_in_previous_frame);
+  for (size_t i = 0; i < map_matches.size(); ++i){
+
+    if (map_matches[i].distance > GetMatchThreshold(min_map_dist)) continue;
+
+    const cv::Point2f &found = keypoints_in_current_frame[map_matches[i].trainIdx].pt;
+    const cv::Vec3f &point_on_model = current_model->mps.front_intersection_image_.at<cv::Vec3f>(found);
+    if (point_on_model[2] == GL_FAR || IsOccluded(current_model, cv::Rect(cv::Point(found), cv::Size(1, 1)))) continue;
+
+    current_model->mps.tracked_points_.push_back(TrackedPoint(descriptor_map.GetDescriptor(map_matches[i].queryIdx).GetModelPoint(), map_projections[i]));
+    current_model->mps.tracked_points_.back().found_image_point = found;
+    current_model->mps.tracked_points_.back().point_tracked_on_model = true;
+
+    descriptor_map.RecordMatch(map_matches[i].queryIdx);
+    keypoint_registered[map_matches[i].trainIdx] = true;
+
+    cv::circle(current_model->debug_info.tracked_feature_points, map_projections[i], 3, cv::Scalar(0, 255, 0));
+    cv::circle(current_model->debug_info.tracked_feature_points, found, 3, cv::Scalar(0, 0, 255));
 
-  //-- Step 3: Matching descriptor vectors using FLANN matcher
-  cv::BruteForceMatcher<cv::L2<float> > matcher;
+  }
+
+  //-- Step 3: Match each current descriptor to the nearest previous one within the motion gate
   std::vector< cv::DMatch > matches;
   
   if (descriptors_in_current_frame.empty() || descriptors_in_previous_frame.empty()){
@@ -95,12 +154,13 @@ void PointRegistration::TrackLocalPoints(cv::Mat &current_frame, const boost::sh
   }
   else{
 
-    matcher.match(descriptors_in_current_frame, descriptors_in_previous_frame, matches);
+    KeypointGrid previous_frame_grid(keypoints_in_previous_frame, GetMaxKeypointMotion());
+    previous_frame_grid.Match(keypoints_in_current_frame, descriptors_in_current_frame, descriptors_in_previous_frame, GetMaxKeypointMotion(), GetDescriptorNorm(), matches);
 
     double max_dist = 0; double min_dist = 100;
 
     //-- Quick calculation of max and min distances between keypoints
-    for (int i = 0; i < descriptors_in_current_frame.rows; i++)
+    for (size_t i = 0; i < matches.size(); i++)
     {
       double dist = matches[i].distance;
       if (dist < min_dist) min_dist = dist;
@@ -109,17 +169,19 @@ void PointRegistration::TrackLocalPoints(cv::Mat &current_frame, const boost::sh
 
 
 
-    for (int i = 0; i < descriptors_in_current_frame.rows; i++)
+    for (size_t i = 0; i < matches.size(); i++)
     {
       int c_idx = matches[i].queryIdx;
       int p_idx = matches[i].trainIdx;
 
-      if (matches[i].distance <= std::max(2 * min_dist, 0.1) && l2_distance(cv::Vec2f(keypoints_in_current_frame[c_idx].pt), cv::Vec2f(keypoints_in_previous_frame[p_idx].pt)) < 40)
+      if (keypoint_registered[c_idx]) continue;
+
+      if (matches[i].distance <= GetMatchThreshold(min_dist))
       {
 
         cv::Vec3f &point_on_model = current_model->mps.front_intersection_image_.at<cv::Vec3f>(keypoints_in_previous_frame[p_idx].pt);
 
-        if (Localizer::occlusion_image.at<float>(keypoints_in_previous_frame[p_idx].pt) < (current_model->mps.front_intersection_image_.at<cv::Vec3f>(keypoints_in_previous_frame[p_idx].pt)[2] - 0.1)) {
+        if (IsOccluded(current_model, cv::Rect(cv::Point(keypoints_in_previous_frame[p_idx].pt), cv::Size(1, 1)))) {
           continue;
         }
 
@@ -136,6 +198,13 @@ void PointRegistration::TrackLocalPoints(cv::Mat &current_frame, const boost::sh
           current_model->mps.tracked_points_.back().found_image_point = keypoints_in_current_frame[c_idx].pt;
           current_model->mps.tracked_points_.back().point_tracked_on_model = true;
 
+          //a new surface point for the map, with the descriptor it was matched from
+          cv::Vec3f normal_in_eye;
+          if (GetSurfaceNormal(current_model->mps.front_intersection_image_, cv::Point(keypoints_in_previous_frame[p_idx].pt), normal_in_eye)){
+            const cv::Vec3f normal_in_model = pose.InverseTransformPoint(point_on_model + normal_in_eye) - pt_in_world_coords;
+            descriptor_map.Add(Descriptor(pt_in_world_coords, normal_in_model, descriptors_in_previous_frame.row(p_idx)));
+          }
+
           cv::circle(current_model->debug_info.tracked_feature_points, keypoints_in_previous_frame[p_idx].pt, 3, cv::Scalar(255, 0, 0));
           cv::circle(current_model->debug_info.tracked_feature_points, keypoints_in_current_frame[c_idx].pt, 3, cv::Scalar(0, 0, 255));
         }
@@ -146,8 +215,9 @@ void PointRegistration::TrackLocalPoints(cv::Mat &current_frame, const boost::sh
   //std::stringstream ss; ss << "z:/dump/frames" << FRAMENUM << ".jpg";
   //cv::imwrite(ss.str(), test);
   //FRAMENUM++;
-  current_model->mps.previous_frame = current_model->mps.current_frame.clone();
-
+  mps.previous_frame = mps.current_frame;
+  mps.previous_keypoints.swap(keypoints_in_current_frame);
+  mps.previous_descriptors = descriptors_in_current_frame;
 
 }
 
@@ -159,11 +229,7 @@ void PointRegistration::InitializeTracker(cv::Mat &current_frame, const boost::s
 
 void PointRegistration::InitializeTracker(cv::Mat &current_frame, const boost::shared_ptr<Model> current_model){
 
-  cv::Mat gray;
-  if (current_frame.type() == CV_8UC3)
-    cv::cvtColor(current_frame, gray, CV_BGR2GRAY);
-  else if (current_frame.type() == CV_8UC1)
-    gray = current_frame.clone();
+  cv::Mat gray = GetGrayFrame(current_frame);
 
   current_model->mps.tracked_points_.clear();
 
@@ -201,8 +267,32 @@ void PointRegistration::InitializeTracker(cv::Mat &current_frame, const boost::s
 
   //we recompute the points each time
 
-  current_model->mps.previous_frame = gray.clone();
+  current_model->mps.previous_frame = gray;
+
+  //with descriptors on the model already the next frame registers against them, so this frame needn't be described
+  if (!current_model->mps.descriptor_map || current_model->mps.descriptor_map->Empty()){
+    DescribeFrame(gray, CreateMask(current_model), current_model->mps.previous_keypoints, current_model->mps.previous_descriptors);
+  }
+  else{
+    current_model->mps.previous_keypoints.clear();
+    current_model->mps.previous_descriptors = cv::Mat();
+  }
 
   current_model->mps.is_initialised = true;
 
 }
+
+ORBRegistration::ORBRegistration(boost::shared_ptr<MonocularCamera> camera, const int max_features) : PointRegistration(camera), max_features_(max_features) {  }
+
+void ORBRegistration::DescribeFrame(const cv::Mat &gray, const cv::Mat &mask, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors) const {
+
+  cv::ORB orb(max_features_);
+  orb(gray, mask, keypoints, descriptors);
+
+}
+
+double ORBRegistration::GetMatchThreshold(const double min_distance) const {
+
+  return std::min(std::max(2 * min_distance, MAX_ORB_HAMMING_DISTANCE / 2), MAX_ORB_HAMMING_DISTANCE);
+
+}
@@ -3,6 +3,7 @@
 
 #include "../../../include/ttrack/track/localizer/levelsets/articulated_level_set.hpp"
 #include "../../../include/ttrack/constants.hpp"
+#include "../../../include/ttrack/utils/profiler.hpp"
 
 #ifdef USE_CUDA
 #include "../../../../include/ttrack/track/localizer/levelsets/pwp3d_cuda.hpp"
@@ -21,7 +22,7 @@ void ArticulatedComponentLevelSet::TrackTargetInFrame(boost::shared_ptr<Model> c
 
   if (curr_step == 0) {
 
-    cv::Mat left_sdf_image, right_sdf_image, sdf_image(frame_->GetImage().rows, frame_->GetImage().cols, CV_32FC1), left_frame_idx_image, right_frame_idx_image;
+    cv::Mat left_sdf_image, right_sdf_image, sdf_image = scratch_.Acquire(frame_->GetImage().size(), CV_32FC1), left_frame_idx_image, right_frame_idx_image;
     cv::Mat front_intersection_image, back_intersection_image;
     ProcessArticulatedSDFAndIntersectionImage(current_model, stereo_camera_->right_eye(), right_sdf_image, front_intersection_image, back_intersection_image, right_frame_idx_image);
     cv::Mat right_component_image = component_map_.clone();
@@ -33,8 +34,8 @@ void ArticulatedComponentLevelSet::TrackTargetInFrame(boost::shared_ptr<Model> c
     if (current_model->NeedsModelRetrain()){
 
       cv::Mat whole_image = stereo_frame->GetImage();
-      cv::Mat whole_sdf_image(left_sdf_image.rows, left_sdf_image.cols * 2, CV_32FC1);
-      cv::Mat whole_component_image(left_frame_idx_image.rows, left_frame_idx_image.cols * 2, CV_8UC1);
+      cv::Mat whole_sdf_image = scratch_.Acquire(cv::Size(left_sdf_image.cols * 2, left_sdf_image.rows), CV_32FC1);
+      cv::Mat whole_component_image = scratch_.Acquire(cv::Size(left_frame_idx_image.cols * 2, left_frame_idx_image.rows), CV_8UC1);
       left_sdf_image.copyTo(whole_sdf_image(cv::Rect(0, 0, left_sdf_image.cols, left_sdf_image.rows)));
       right_sdf_image.copyTo(whole_sdf_image(cv::Rect(left_sdf_image.cols, 0, left_sdf_image.cols, left_sdf_image.rows)));
       component_map_.copyTo(whole_component_image(cv::Rect(0, 0, left_sdf_image.cols, left_sdf_image.rows)));
@@ -69,12 +70,16 @@ void ArticulatedComponentLevelSet::TrackTargetInFrame(boost::shared_ptr<Model> c
     current_model->ClassifyFrame(frame_, sdf_image);
 
 
-    if (frame_count_ % 8 == 0) current_model->mps.is_initialised = false;
-
+    //the LK trackers top up the points where the components lose coverage so there's no need to redetect everything periodically
     point_registration_->SetFrontIntersectionImage(front_intersection_image, current_model);
 
     //if (frame_count_ != 0){
 
+    ScopedTimer lk_timer(PROFILE_LK);
+
+    //every model in the frame shares the gray image and pyramid
+    if (point_registration_) point_registration_->SetFramePyramid(stereo_frame->GetFeaturePyramid());
+
     if (point_registration_ && !current_model->mps.is_initialised){
 
       point_registration_->InitializeTracker(stereo_frame->GetLeftImage(), current_model, left_frame_idx_image);
@@ -82,8 +87,8 @@ void ArticulatedComponentLevelSet::TrackTargetInFrame(boost::shared_ptr<Model> c
     }
     else if (point_registration_ && current_model->mps.is_initialised){
 
-      if (boost::dynamic_pointer_cast<ArticulalatedLKTrackerFrameToFrame>(point_registration_)){
-        boost::dynamic_pointer_cast<ArticulalatedLKTrackerFrameToFrame>(point_registration_)->TrackLocalPoints(stereo_frame->GetLeftImage(), current_model, left_frame_idx_image);
+      if (boost::dynamic_pointer_cast<LKTracker>(point_registration_)){
+        boost::dynamic_pointer_cast<LKTracker>(point_registration_)->TrackLocalPoints(stereo_frame->GetLeftImage(), current_model, left_frame_idx_image);
       }
       else{
         point_registration_->TrackLocalPoints(stereo_frame->GetLeftImage(), current_model);
@@ -92,16 +97,13 @@ void ArticulatedComponentLevelSet::TrackTargetInFrame(boost::shared_ptr<Model> c
     }
     //}
 
-
-
+    lk_timer.Stop();
 
   }
 
-  double t = cv::getTickCount();
-
+  ScopedTimer step_timer(PROFILE_ALIGNMENT_STEP);
   float error = DoAlignmentStep(current_model, true && current_model->mps.is_initialised);
-
-  ci::app::console() << "Time taken = " << (cv::getTickCount() - t) / cv::getTickFrequency() << std::endl;
+  step_timer.Stop();
 
   UpdateWithErrorValue(error);
   errors_.push_back(error);
@@ -273,15 +275,15 @@ float ArticulatedComponentLevelSet::GetErrorForPose(const cv::Mat &classificatio
 
     cv::Mat &sdf_image = components_[comp].sdf_image;
 
-    cv::Mat target_label_image = cv::Mat::zeros(sdf_image.size(), CV_8UC1);
-    cv::Mat nearest_neighbour_label_image = cv::Mat::zeros(sdf_image.size(), CV_8UC1);
-    cv::Mat region_agreement_im = cv::Mat::zeros(sdf_image.size(), CV_32FC1);
+    cv::Mat target_label_image = scratch_.AcquireZeros(sdf_image.size(), CV_8UC1);
+    cv::Mat nearest_neighbour_label_image = scratch_.AcquireZeros(sdf_image.size(), CV_8UC1);
+    cv::Mat region_agreement_im = scratch_.AcquireZeros(sdf_image.size(), CV_32FC1);
 
     float *sdf_im_data = (float *)sdf_image.data;
     float *front_intersection_data = (float *)front_intersection_image.data;
     float *back_intersection_data = (float *)back_intersection_image.data;
 
-    cv::Mat error_image = cv::Mat::zeros(front_intersection_image.size(), CV_8UC1);
+    cv::Mat error_image = scratch_.AcquireZeros(front_intersection_image.size(), CV_8UC1);
 
     for (int r = 5; r < classification_image.rows - 5; ++r){
       for (int c = 5; c < classification_image.cols - 5; ++c){
@@ -799,6 +801,8 @@ void ArticulatedComponentLevelSet::ComputeJacobiansForEye(const cv::Mat &classif
   //Use the articulated components to compute the index_image which is an image where each pixel indexes the articulated component used in the optimization
   ProcessArticulatedSDFAndIntersectionImage(current_model, camera, composite_sdf_image, front_intersection_image, back_intersection_image, index_image);
 
+  ScopedTimer jacobian_timer(PROFILE_JACOBIAN);
+
   cv::Mat sdf_image_1 = components_[0].sdf_image;
   cv::Mat sdf_image_2 = components_[1].sdf_image;
   cv::Mat sdf_image_3 = components_[2].sdf_image;
@@ -817,9 +821,9 @@ void ArticulatedComponentLevelSet::ComputeJacobiansForEye(const cv::Mat &classif
 
     cv::Mat &sdf_image = components_[comp].sdf_image;
 
-    cv::Mat target_label_image = cv::Mat::zeros(sdf_image.size(), CV_8UC1);
-    cv::Mat nearest_neighbour_label_image = cv::Mat::zeros(sdf_image.size(), CV_8UC1);
-    cv::Mat region_agreement_im = cv::Mat::zeros(sdf_image.size(), CV_32FC1);
+    cv::Mat target_label_image = scratch_.AcquireZeros(sdf_image.size(), CV_8UC1);
+    cv::Mat nearest_neighbour_label_image = scratch_.AcquireZeros(sdf_image.size(), CV_8UC1);
+    cv::Mat region_agreement_im = scratch_.AcquireZeros(sdf_image.size(), CV_32FC1);
 
     float *sdf_im_data = (float *)sdf_image.data;
     float *front_intersection_data = (float *)front_intersection_image.data;
@@ -1127,7 +1131,7 @@ void ArticulatedComponentLevelSet::ProcessArticulatedSDFAndIntersectionImage(con
   //shouldn
 
   StereoPWP3D::ProcessSDFAndIntersectionImage(mesh, camera, composite_sdf_image, composite_front_intersection_image, composite_back_intersection_image);
-  frame_idx_image = cv::Mat(composite_sdf_image.size(), CV_8UC1);
+  frame_idx_image = scratch_.Acquire(composite_sdf_image.size(), CV_8UC1);
 
   std::vector<Node *> nodes;
 
@@ -1188,7 +1192,9 @@ void ArticulatedComponentLevelSet::ProcessArticulatedSDFAndIntersectionImage(con
     nodeA->SetDraw(true);
   }
 
-  cv::Mat save_image = cv::Mat::zeros(composite_sdf_image.size(), CV_8UC1);
+  ScopedTimer intersection_timer(PROFILE_INTERSECTION_IMAGE);
+
+  cv::Mat save_image = scratch_.AcquireZeros(composite_sdf_image.size(), CV_8UC1);
 
   for (int r = 0; r < composite_sdf_image.rows; ++r){
 
@@ -1264,6 +1270,8 @@ void ArticulatedComponentLevelSet::ProcessArticulatedSDFAndIntersectionImage(con
 
   }
 
+  intersection_timer.Stop();
+
   double min, max;
   cv::Mat sdf_scaled(composite_sdf_image.size(), CV_8UC1);
   cv::minMaxLoc(composite_sdf_image, &min, &max);
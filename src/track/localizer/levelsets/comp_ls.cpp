@@ -7,6 +7,7 @@
 #include "../../../include/ttrack/resources.hpp"
 #include "../../../include/ttrack/constants.hpp"
 #include "../../../include/ttrack/utils/helpers.hpp"
+#include "../../../include/ttrack/utils/profiler.hpp"
 
 using namespace ttrk;
 
@@ -65,7 +66,7 @@ void ComponentLevelSet::TrackTargetInFrame(boost::shared_ptr<Model> current_mode
     auto stereo_frame = boost::dynamic_pointer_cast<sv::StereoFrame>(frame_);
     
     //if (first_run_){// || point_registration_->NeedsReset()){
-    cv::Mat left_sdf_image, right_sdf_image, sdf_image(frame_->GetImage().rows, frame_->GetImage().cols, CV_32FC1);
+    cv::Mat left_sdf_image, right_sdf_image, sdf_image = scratch_.Acquire(frame_->GetImage().size(), CV_32FC1);
     StereoPWP3D::ProcessSDFAndIntersectionImage(current_model, stereo_camera_->right_eye(), right_sdf_image, front_intersection_image, back_intersection_image);
     Localizer::ResetOcclusionImage();
     StereoPWP3D::ProcessSDFAndIntersectionImage(current_model, stereo_camera_->left_eye(), left_sdf_image, cv::Mat(), cv::Mat());
@@ -79,6 +80,11 @@ void ComponentLevelSet::TrackTargetInFrame(boost::shared_ptr<Model> current_mode
     right_sdf_image.copyTo(sdf_image(cv::Rect(left_sdf_image.cols, 0, left_sdf_image.cols, left_sdf_image.rows)));
     current_model->ClassifyFrame(frame_, sdf_image);
 
+    ScopedTimer lk_timer(PROFILE_LK);
+
+    //every model in the frame shares the gray image and pyramid
+    if (point_registration_) point_registration_->SetFramePyramid(stereo_frame->GetFeaturePyramid());
+
     if (point_registration_ && !current_model->mps.is_initialised){
       point_registration_->SetFrontIntersectionImage(front_intersection_image, current_model);
       point_registration_->InitializeTracker(stereo_frame->GetLeftImage(), current_model);
@@ -88,6 +94,8 @@ void ComponentLevelSet::TrackTargetInFrame(boost::shared_ptr<Model> current_mode
       //point_registration_->InitializeTracker(current_model->mps.previous_frame, current_model);
       point_registration_->TrackLocalPoints(stereo_frame->GetLeftImage(), current_model);
     }
+
+    lk_timer.Stop();
       //boost::dynamic_pointer_cast<LKTracker3D>(point_registration_)->SetSpatialDerivatives(current_model->GetBasePose());
     //} 
     //else{
@@ -102,7 +110,10 @@ void ComponentLevelSet::TrackTargetInFrame(boost::shared_ptr<Model> current_mode
   }
 
 
+  ScopedTimer step_timer(PROFILE_ALIGNMENT_STEP);
   float error = DoAlignmentStep(current_model, true);
+  step_timer.Stop();
+
   UpdateWithErrorValue(error);
   errors_.push_back(error);
 
@@ -288,13 +299,15 @@ void ComponentLevelSet::ComputeJacobiansForEye(const cv::Mat &classification_ima
 
   ProcessSDFAndIntersectionImage(current_model, camera, front_intersection_image, back_intersection_image);
 
+  ScopedTimer jacobian_timer(PROFILE_JACOBIAN);
+
   for (size_t comp = 1; comp < components_.size(); ++comp){
 
     cv::Mat &sdf_image = components_[comp].sdf_image;
 
-    cv::Mat target_label_image = cv::Mat::zeros(sdf_image.size(), CV_8UC1);
-    cv::Mat nearest_neighbour_label_image = cv::Mat::zeros(sdf_image.size(), CV_8UC1);
-    cv::Mat region_agreement_im = cv::Mat::zeros(sdf_image.size(), CV_32FC1);
+    cv::Mat target_label_image = scratch_.AcquireZeros(sdf_image.size(), CV_8UC1);
+    cv::Mat nearest_neighbour_label_image = scratch_.AcquireZeros(sdf_image.size(), CV_8UC1);
+    cv::Mat region_agreement_im = scratch_.AcquireZeros(sdf_image.size(), CV_32FC1);
 
     float *sdf_im_data = (float *)sdf_image.data;
     float *front_intersection_data = (float *)front_intersection_image.data;
@@ -507,7 +520,7 @@ float ComponentLevelSet::GetErrorValue(const cv::Mat &classification_image, cons
     int axa = 0;
   }
 
-  float nv = log(v);
+  float nv = FastLog(v);
   float nnv = -nv;
   return nnv;
 
@@ -515,44 +528,25 @@ float ComponentLevelSet::GetErrorValue(const cv::Mat &classification_image, cons
 
 void ComponentLevelSet::ProcessSDFAndIntersectionImage(const boost::shared_ptr<Model> mesh, const boost::shared_ptr<MonocularCamera> camera, cv::Mat &front_intersection_image, cv::Mat &back_intersection_image) {
 
-  //find all the pixels which project to intersection points on the model
-  front_intersection_image = cv::Mat::zeros(frame_->GetImageROI().size(), CV_32FC3);
-  back_intersection_image = cv::Mat::zeros(frame_->GetImageROI().size(), CV_32FC3);
-
-  cv::Mat front_depth, back_depth;
+  const cv::Size size(camera->Width(), camera->Height());
+  cv::Mat front_depth = scratch_.Acquire(size, CV_32FC4), back_depth = scratch_.Acquire(size, CV_32FC4);
   RenderModelForDepthAndContour(mesh, camera, front_depth, back_depth);
 
   Localizer::UpdateOcclusionImage(front_depth);
 
-  cv::Mat unprojected_image_plane = camera->GetUnprojectedImagePlane(front_intersection_image.cols, front_intersection_image.rows);
-
-  for (int r = 0; r < front_intersection_image.rows; r++){
-    for (int c = 0; c < front_intersection_image.cols; c++){
-
-      if (std::abs(front_depth.at<cv::Vec4f>(r, c)[0] - GL_FAR) > EPS){
-        const cv::Vec2f &unprojected_pixel = unprojected_image_plane.at<cv::Vec2f>(r, c);
-        front_intersection_image.at<cv::Vec3f>(r, c) = front_depth.at<cv::Vec4f>(r, c)[0] * cv::Vec3f(unprojected_pixel[0], unprojected_pixel[1], 1);
-      }
-      else{
-        front_intersection_image.at<cv::Vec3f>(r, c) = cv::Vec3f((int)GL_FAR, (int)GL_FAR, (int)GL_FAR);
-      }
-      if (std::abs(back_depth.at<cv::Vec4f>(r, c)[0] - GL_FAR) > EPS){
-        const cv::Vec2f &unprojected_pixel = unprojected_image_plane.at<cv::Vec2f>(r, c);
-        back_intersection_image.at<cv::Vec3f>(r, c) = back_depth.at<cv::Vec4f>(r, c)[0] * cv::Vec3f(unprojected_pixel[0], unprojected_pixel[1], 1);
-      }
-      else{
-        back_intersection_image.at<cv::Vec3f>(r, c) = cv::Vec3f((int)GL_FAR, (int)GL_FAR, (int)GL_FAR);
-      }
+  if (front_intersection_image.empty()) front_intersection_image = scratch_.Acquire(size, CV_32FC3);
+  if (back_intersection_image.empty()) back_intersection_image = scratch_.Acquire(size, CV_32FC3);
 
-    }
-  }
+  ComputeIntersectionImages(camera, front_depth, back_depth, front_intersection_image, back_intersection_image);
 
+  ScopedTimer distance_transform_timer(PROFILE_DISTANCE_TRANSFORM);
 
   //cv::Mat sdf_image;
   //distanceTransform(~component_contour_image, component_sdf_image, CV_DIST_L2, CV_DIST_MASK_PRECISE);
 
   for (size_t i = 1; i < components_.size(); i++){
-    components_[i].sdf_image = cv::Mat(front_depth.size(), CV_32FC1);
+    //the previous step's image goes back to the pool when it is replaced here
+    components_[i].sdf_image = scratch_.Acquire(front_depth.size(), CV_32FC1);
 
 #ifdef USE_CUDA
     ttrk::gpu::distanceTransform(components_[i].contour_image, components_[i].sdf_image);
@@ -572,6 +566,8 @@ void ComponentLevelSet::ProcessSDFAndIntersectionImage(const boost::shared_ptr<M
     }
   }
 
+  distance_transform_timer.Stop();
+
   //just do the first one
   if (components_.size() > 0)
     progress_frame_ = ComputePrettySDFImage(components_[1].sdf_image);
@@ -589,6 +585,8 @@ void ComponentLevelSet::RenderModelForDepthAndContour(const boost::shared_ptr<Mo
 
   assert(front_depth_framebuffer_.getWidth() == camera->Width() && front_depth_framebuffer_.getHeight() == camera->Height());
 
+  ScopedTimer render_timer(PROFILE_RENDER);
+
   //setup camera/transform/matrices etc
   ci::gl::pushMatrices();
 
@@ -669,6 +667,9 @@ void ComponentLevelSet::RenderModelForDepthAndContour(const boost::shared_ptr<Mo
 
   camera->ShutDownCameraAfterDrawing();
 
+  render_timer.Stop();
+  ScopedTimer readback_timer(PROFILE_READBACK);
+
   cv::Mat front_depth_flipped = ci::toOcv(front_depth_framebuffer_.getTexture());
   cv::flip(front_depth_flipped, front_depth, 0);
   front_depth_flipped.release();
@@ -681,13 +682,13 @@ void ComponentLevelSet::RenderModelForDepthAndContour(const boost::shared_ptr<Mo
   cv::flip(f_component_map, f_component_map, 0);
 
   float *comp_src = (float *)f_component_map.data;
-  component_map_ = cv::Mat(f_component_map.size(), CV_8UC1);
+  component_map_ = scratch_.Acquire(f_component_map.size(), CV_8UC1);
   unsigned char *comp_dst = (unsigned char *)component_map_.data;
 
   //get the binary component images and the component map.
   for (size_t i = 0; i < components_.size(); ++i){
-    components_[i].binary_image = cv::Mat::zeros(front_depth.size(), CV_8UC1);
-    components_[i].contour_image = cv::Mat::zeros(front_depth.size(), CV_8UC1);
+    components_[i].binary_image = scratch_.AcquireZeros(front_depth.size(), CV_8UC1);
+    components_[i].contour_image = scratch_.AcquireZeros(front_depth.size(), CV_8UC1);
   }
 
 
@@ -0,0 +1,112 @@
+#include <cmath>
+#include <stdexcept>
+
+#include "../../../../include/ttrack/track/localizer/levelsets/intersection_image.hpp"
+#include "../../../../include/ttrack/constants.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TTRK_INTERSECTION_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace ttrk;
+
+namespace {
+
+  inline void UnprojectPixel(const float depth, const float ray_x, const float ray_y, float *intersection){
+
+    if (std::abs(depth - GL_FAR) > EPS){
+      intersection[0] = depth * ray_x;
+      intersection[1] = depth * ray_y;
+      intersection[2] = depth;
+    }
+    else{
+      intersection[0] = intersection[1] = intersection[2] = (float)GL_FAR;
+    }
+
+  }
+
+#ifdef TTRK_INTERSECTION_SSE2
+
+  //the depth channel of 4 consecutive RGBA pixels
+  inline __m128 LoadDepth(const float *rgba){
+
+    const __m128 d01 = _mm_shuffle_ps(_mm_loadu_ps(rgba), _mm_loadu_ps(rgba + 4), _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 d23 = _mm_shuffle_ps(_mm_loadu_ps(rgba + 8), _mm_loadu_ps(rgba + 12), _MM_SHUFFLE(0, 0, 0, 0));
+    return _mm_shuffle_ps(d01, d23, _MM_SHUFFLE(2, 0, 2, 0));
+
+  }
+
+  //unproject 4 pixels and store them as 12 interleaved floats
+  inline void UnprojectAndStore(const __m128 depth, const __m128 ray_x, const __m128 ray_y, float *intersection){
+
+    const __m128 far_plane = _mm_set1_ps((float)GL_FAR);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    //|depth - far| > eps selects the depth, otherwise far
+    const __m128 hit = _mm_cmpgt_ps(_mm_and_ps(_mm_sub_ps(depth, far_plane), abs_mask), _mm_set1_ps(EPS));
+    const __m128 x = _mm_or_ps(_mm_and_ps(hit, _mm_mul_ps(depth, ray_x)), _mm_andnot_ps(hit, far_plane));
+    const __m128 y = _mm_or_ps(_mm_and_ps(hit, _mm_mul_ps(depth, ray_y)), _mm_andnot_ps(hit, far_plane));
+    const __m128 z = _mm_or_ps(_mm_and_ps(hit, depth), _mm_andnot_ps(hit, far_plane));
+
+    //x0 y0 x1 y1 and x2 y2 x3 y3
+    const __m128 xy01 = _mm_unpacklo_ps(x, y);
+    const __m128 xy23 = _mm_unpackhi_ps(x, y);
+
+    //x0 y0 z0 x1
+    _mm_storeu_ps(intersection, _mm_shuffle_ps(xy01, _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+    //y1 z1 x2 y2
+    _mm_storeu_ps(intersection + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), xy23, _MM_SHUFFLE(1, 0, 2, 0)));
+    //z2 x3 y3 z3
+    const __m128 z23xy3 = _mm_shuffle_ps(z, xy23, _MM_SHUFFLE(3, 2, 3, 2));
+    _mm_storeu_ps(intersection + 8, _mm_shuffle_ps(z23xy3, z23xy3, _MM_SHUFFLE(1, 3, 2, 0)));
+
+  }
+
+#endif
+
+}
+
+void ttrk::ComputeIntersectionRow(const float *front_depth, const float *back_depth, const float *rays, float *front_intersection, float *back_intersection, const int width){
+
+  int c = 0;
+
+#ifdef TTRK_INTERSECTION_SSE2
+
+  for (; c + 4 <= width; c += 4){
+
+    //the rays are interleaved x/z, y/z so split them while they are in registers rather than keeping planar copies
+    const __m128 rays01 = _mm_loadu_ps(rays + 2 * c);
+    const __m128 rays23 = _mm_loadu_ps(rays + 2 * c + 4);
+    const __m128 ray_x = _mm_shuffle_ps(rays01, rays23, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 ray_y = _mm_shuffle_ps(rays01, rays23, _MM_SHUFFLE(3, 1, 3, 1));
+
+    UnprojectAndStore(LoadDepth(front_depth + 4 * c), ray_x, ray_y, front_intersection + 3 * c);
+    UnprojectAndStore(LoadDepth(back_depth + 4 * c), ray_x, ray_y, back_intersection + 3 * c);
+
+  }
+
+#endif
+
+  for (; c < width; ++c){
+    UnprojectPixel(front_depth[4 * c], rays[2 * c], rays[2 * c + 1], front_intersection + 3 * c);
+    UnprojectPixel(back_depth[4 * c], rays[2 * c], rays[2 * c + 1], back_intersection + 3 * c);
+  }
+
+}
+
+void ttrk::ComputeIntersectionImagesFromDepth(const cv::Mat &front_depth, const cv::Mat &back_depth, const cv::Mat &unprojected_image_plane, cv::Mat &front_intersection_image, cv::Mat &back_intersection_image){
+
+  if (front_depth.type() != CV_32FC4 || back_depth.type() != CV_32FC4 || unprojected_image_plane.type() != CV_32FC2)
+    throw std::runtime_error("Error, intersection images need CV_32FC4 depth and a CV_32FC2 image plane.");
+  if (back_depth.size() != front_depth.size() || unprojected_image_plane.size() != front_depth.size())
+    throw std::runtime_error("Error, depth images and image plane must be the same size.");
+
+  front_intersection_image.create(front_depth.size(), CV_32FC3);
+  back_intersection_image.create(front_depth.size(), CV_32FC3);
+
+  for (int r = 0; r < front_depth.rows; ++r){
+    ComputeIntersectionRow(front_depth.ptr<float>(r), back_depth.ptr<float>(r), unprojected_image_plane.ptr<float>(r), front_intersection_image.ptr<float>(r), back_intersection_image.ptr<float>(r), front_depth.cols);
+  }
+
+}
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "../../../../include/ttrack/track/localizer/levelsets/level_set_functions.hpp"
+
+using namespace ttrk;
+
+namespace {
+
+  const double PI = 3.14159265358979323846;
+
+  //the largest interpolation error allowed, leaving headroom below 1e-6 for float rounding
+  const double MAX_INTERPOLATION_ERROR = 2.5e-7;
+
+}
+
+HeavisideTable::HeavisideTable(const int width) : width_(0), samples_per_pixel_(0) {
+
+  SetWidth(width);
+
+}
+
+void HeavisideTable::SetWidth(const int width){
+
+  if (width == width_) return;
+  if (width <= 0) throw std::runtime_error("Error, the heaviside width must be positive.");
+
+  width_ = width;
+
+  //linear interpolation with spacing h is within h^2/8 * max|f''|, the heaviside's second derivative peaks at pi/(2w^2) and the delta's at pi^2/(2w^3)
+  const double max_second_derivative = std::max(PI / (2.0 * width * width), PI * PI / (2.0 * width * width * width));
+  samples_per_pixel_ = (int)std::ceil(1.0 / std::sqrt(8.0 * MAX_INTERPOLATION_ERROR / max_second_derivative));
+
+  const size_t num_samples = 2 * width_ * samples_per_pixel_ + 2;
+  heaviside_.resize(num_samples);
+  delta_.resize(num_samples);
+
+  for (size_t i = 0; i < num_samples; ++i){
+    const float x = (float)((double)i / samples_per_pixel_ - width_);
+    heaviside_[i] = AnalyticHeaviside(x, width_);
+    delta_[i] = AnalyticDelta(x, width_);
+  }
+
+}
+
+float HeavisideTable::AnalyticHeaviside(const float x, const int width){
+
+  if (x > width) return 1.0f;
+  else if (x < -width) return 0.0f;
+  else return (float)(0.5 * (1.0 + (x / (double)width) + (1.0 / PI) * std::sin((PI * x) / width)));
+
+}
+
+float HeavisideTable::AnalyticDelta(const float x, const int width){
+
+  if (std::abs(x) > width) return 0.0f;
+  else return (float)((1.0 / (2.0 * width)) * (1.0 + std::cos(PI * x / width)));
+
+}
@@ -34,6 +34,7 @@ void MonoPWP3D::TrackTargetInFrame(boost::shared_ptr<Model> current_model, boost
 
   //point_registration_->ComputeDescriptorsForPointTracking(stereo_frame->GetLeftImage(), front_intersection_image, front_normal_image, current_model->GetBasePose());
 
+  point_registration_->SetFramePyramid(frame_->GetFeaturePyramid());
   point_registration_->TrackLocalPoints(frame_->GetImage(), current_model);
 
   float fg_area, bg_area = 0;
@@ -13,9 +13,11 @@
 #endif 
 
 #include "../../../../include/ttrack/track/localizer/levelsets/pwp3d.hpp"
+#include "../../../../include/ttrack/track/localizer/levelsets/intersection_image.hpp"
 #include "../../../../include/ttrack/utils/helpers.hpp"
 #include "../../../../include/ttrack/resources.hpp"
 #include "../../../../include/ttrack/constants.hpp"
+#include "../../../../include/ttrack/utils/profiler.hpp"
 #include "../include/ttrack/utils/UI.hpp"
 
 using namespace ttrk;
@@ -35,6 +37,7 @@ PWP3D::PWP3D(const int width, const int height) {
   back_depth_framebuffer_ = ci::gl::Fbo(width, height, format);
 
   HEAVYSIDE_WIDTH = 3; //if this value is changed the Delta/Heavside approximations will be invalid!
+  heaviside_table_.SetWidth(HEAVYSIDE_WIDTH);
 
   auto &ui = ttrk::UIController::Instance();
   ui.AddVar<int>("Gradient Descent Steps", &NUM_STEPS, 1, 50, 1);
@@ -320,16 +323,13 @@ void PWP3D::ComputeLKJacobian(boost::shared_ptr<Model> current_model, cv::Matx<f
 
   if (!point_registration_) return;
 
-  std::vector<float> derivs = point_registration_->GetDerivativesForPoints(current_model, current_model->GetBasePose());
+  //J^T r is half the summed point gradient this used to add, so scale by 2 to keep the gradient descent step the same
+  cv::Matx<float, 7, 7> points_jtj;
+  cv::Matx<float, 7, 1> points_jtr;
+  point_registration_->GetPointRegistrationSystem(current_model, current_model->GetBasePose(), points_jtj, points_jtr);
 
-  cv::Matx<float, 1, 7> points_jacobian = cv::Matx<float, 1, 7>::zeros();
-
-  for (int i = 0; i < derivs.size(); ++i){
-    points_jacobian(i) += derivs[i];
-  }
-
-  jacobian += points_jacobian.t();
-  hessian_approx += (points_jacobian.t() * points_jacobian);
+  jacobian += 2.0f * points_jtr;
+  hessian_approx += 2.0f * points_jtj;
 
 }
 
@@ -337,16 +337,15 @@ void PWP3D::ComputePointRegistrationJacobian(boost::shared_ptr<Model> current_mo
 
   if (!point_registration_) return;
 
-  std::vector<float> derivs = point_registration_->GetDerivativesForPoints(current_model, current_model->GetBasePose());
+  //the point term used to be weighted by 10 on the summed gradient, 2 J^T r, and a Gauss-Newton step needs the same weight on J^T J
+  const float point_weight = 20.0f;
 
-  cv::Matx<float, 1, 7> points_jacobian = cv::Matx<float, 1, 7>::zeros();
+  cv::Matx<float, 7, 7> points_jtj;
+  cv::Matx<float, 7, 1> points_jtr;
+  point_registration_->GetPointRegistrationSystem(current_model, current_model->GetBasePose(), points_jtj, points_jtr);
 
-  for (int i = 0; i < derivs.size(); ++i){
-    points_jacobian(i) += 10.0 * derivs[i]; //no scaling?
-  }
-
-  jacobian += points_jacobian.t();
-  hessian_approx += (points_jacobian.t() * points_jacobian);
+  jacobian += point_weight * points_jtr;
+  hessian_approx += point_weight * points_jtj;
 
 }
 
@@ -403,13 +402,15 @@ float PWP3D::GetErrorValue(const cv::Mat &classification_image, const int row_id
 
   float v = (heaviside_value * Pf) + ((1 - heaviside_value)*(Pb));
   v += 0.0000001f;
-  return -log(v);
+  return -FastLog(v);
 
 }
 
 void PWP3D::RenderModelForDepthAndContour(const boost::shared_ptr<Model> mesh, const boost::shared_ptr<MonocularCamera> camera, cv::Mat &front_depth, cv::Mat &back_depth, cv::Mat &contour) {
   assert(front_depth_framebuffer_.getWidth() == camera->Width() && front_depth_framebuffer_.getHeight() == camera->Height());
 
+  ScopedTimer render_timer(PROFILE_RENDER);
+
   //setup camera/transform/matrices etc
   ci::gl::pushMatrices();
 
@@ -470,6 +471,9 @@ void PWP3D::RenderModelForDepthAndContour(const boost::shared_ptr<Model> mesh, c
 
   camera->ShutDownCameraAfterDrawing();
 
+  render_timer.Stop();
+  ScopedTimer readback_timer(PROFILE_READBACK);
+
   front_depth_framebuffer_.getTexture();
   back_depth_framebuffer_.getTexture();
   back_depth_framebuffer_.getTexture(1);
@@ -477,12 +481,14 @@ void PWP3D::RenderModelForDepthAndContour(const boost::shared_ptr<Model> mesh, c
   cv::Mat front_depth_flipped = ci::toOcv(front_depth_framebuffer_.getTexture());
   cv::Mat back_depth_flipped = ci::toOcv(back_depth_framebuffer_.getTexture(0));
   cv::Mat mcontour = ci::toOcv(back_depth_framebuffer_.getTexture(1));
-  cv::Mat fmcontour;
+  cv::Mat fmcontour = scratch_.Acquire(mcontour.size(), mcontour.type());
   cv::flip(front_depth_flipped, front_depth, 0);
   cv::flip(back_depth_flipped, back_depth, 0);
   cv::flip(mcontour, fmcontour, 0);
 
-  contour = cv::Mat::zeros(mcontour.size(), CV_8UC1);
+  //the outputs may be pooled buffers, in which case this writes into them rather than allocating
+  contour.create(mcontour.size(), CV_8UC1);
+  contour.setTo(cv::Scalar(0));
   float *src = (float *)fmcontour.data;
   unsigned char *dst = (unsigned char*)contour.data;
 
@@ -518,11 +524,15 @@ cv::Mat PWP3D::ComputePrettySDFImage(const cv::Mat &sdf_image) const{
 
 cv::Mat PWP3D::ComputeSDFImageAndSetProgressFrame(const cv::Mat contour_image, const cv::Mat &front_depth_image){
 
-  cv::Mat sdf_image;
+  ScopedTimer distance_transform_timer(PROFILE_DISTANCE_TRANSFORM);
+
+  cv::Mat sdf_image = scratch_.Acquire(contour_image.size(), CV_32FC1);
 #ifdef USE_CUDA
   ttrk::gpu::distanceTransform(contour_image.clone(), sdf_image);
 #else
-  distanceTransform(~contour_image, sdf_image, CV_DIST_L2, CV_DIST_MASK_PRECISE);
+  cv::Mat inverted_contour_image = scratch_.Acquire(contour_image.size(), contour_image.type());
+  cv::bitwise_not(contour_image, inverted_contour_image);
+  distanceTransform(inverted_contour_image, sdf_image, CV_DIST_L2, CV_DIST_MASK_PRECISE);
 #endif    
 
   //flip the sign of the distance image for outside pixels
@@ -539,46 +549,37 @@ cv::Mat PWP3D::ComputeSDFImageAndSetProgressFrame(const cv::Mat contour_image, c
     }
   }
 
+  distance_transform_timer.Stop();
+
   progress_frame_ = ComputePrettySDFImage(sdf_image);
 
   return sdf_image;
 
 }
 
+void PWP3D::ComputeIntersectionImages(const boost::shared_ptr<MonocularCamera> camera, const cv::Mat &front_depth, const cv::Mat &back_depth, cv::Mat &front_intersection_image, cv::Mat &back_intersection_image) const {
+
+  ScopedTimer intersection_timer(PROFILE_INTERSECTION_IMAGE);
+
+  //if the outputs already have the right size (e.g. they are pooled) this doesn't allocate
+  ComputeIntersectionImagesFromDepth(front_depth, back_depth, camera->GetUnprojectedImagePlane(front_depth.cols, front_depth.rows), front_intersection_image, back_intersection_image);
+
+}
+
 void PWP3D::ProcessSDFAndIntersectionImage(const boost::shared_ptr<Model> mesh, const boost::shared_ptr<MonocularCamera> camera, cv::Mat &sdf_image, cv::Mat &front_intersection_image, cv::Mat &back_intersection_image) {
 
   //find all the pixels which project to intersection points on the model
-  sdf_image = cv::Mat(frame_->GetImageROI().size(),CV_32FC1);
-  front_intersection_image = cv::Mat::zeros(frame_->GetImageROI().size(),CV_32FC3);
-  back_intersection_image = cv::Mat::zeros(frame_->GetImageROI().size(),CV_32FC3);
-
-  cv::Mat front_depth, back_depth, contour;
+  const cv::Size size(camera->Width(), camera->Height());
+  cv::Mat front_depth = scratch_.Acquire(size, CV_32FC4), back_depth = scratch_.Acquire(size, CV_32FC4), contour = scratch_.Acquire(size, CV_8UC1);
   RenderModelForDepthAndContour(mesh, camera, front_depth, back_depth, contour );
   
   Localizer::UpdateOcclusionImage(front_depth);
 
-  cv::Mat unprojected_image_plane = camera->GetUnprojectedImagePlane(front_intersection_image.cols, front_intersection_image.rows);
-
-  for (int r = 0; r < front_intersection_image.rows; r++){
-    for (int c = 0; c < front_intersection_image.cols; c++){
-
-      if (std::abs(front_depth.at<cv::Vec4f>(r, c)[0] - GL_FAR) > EPS){
-        const cv::Vec2f &unprojected_pixel = unprojected_image_plane.at<cv::Vec2f>(r, c);
-        front_intersection_image.at<cv::Vec3f>(r, c) = front_depth.at<cv::Vec4f>(r, c)[0]*cv::Vec3f(unprojected_pixel[0], unprojected_pixel[1], 1);
-      }
-      else{
-        front_intersection_image.at<cv::Vec3f>(r, c) = cv::Vec3f((int)GL_FAR, (int)GL_FAR, (int)GL_FAR);
-      }
-      if (std::abs(back_depth.at<cv::Vec4f>(r, c)[0] - GL_FAR) > EPS){
-        const cv::Vec2f &unprojected_pixel = unprojected_image_plane.at<cv::Vec2f>(r, c);
-        back_intersection_image.at<cv::Vec3f>(r, c) = back_depth.at<cv::Vec4f>(r, c)[0]*cv::Vec3f(unprojected_pixel[0], unprojected_pixel[1], 1);
-      }
-      else{
-        back_intersection_image.at<cv::Vec3f>(r, c) = cv::Vec3f((int)GL_FAR, (int)GL_FAR, (int)GL_FAR);
-      }
+  //callers often pass empty images (or temporaries) for outputs they don't need, write those into pooled buffers too
+  if (front_intersection_image.empty()) front_intersection_image = scratch_.Acquire(size, CV_32FC3);
+  if (back_intersection_image.empty()) back_intersection_image = scratch_.Acquire(size, CV_32FC3);
 
-    }
-  }
+  ComputeIntersectionImages(camera, front_depth, back_depth, front_intersection_image, back_intersection_image);
 
   sdf_image = ComputeSDFImageAndSetProgressFrame(contour, front_intersection_image);
      
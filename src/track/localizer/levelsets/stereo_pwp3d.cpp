@@ -3,6 +3,7 @@
 
 #include "../../../include/ttrack/track/localizer/levelsets/stereo_pwp3d.hpp"
 #include "../../../include/ttrack/utils/helpers.hpp"
+#include "../../../include/ttrack/utils/profiler.hpp"
 
 #ifdef USE_CUDA
 #include "../../../../include/ttrack/track/localizer/levelsets/pwp3d_cuda.hpp"
@@ -53,10 +54,11 @@ float StereoPWP3D::DoAlignmentStep(boost::shared_ptr<Model> current_model){
 
 #else
 
+  //the region and point terms share one Gauss-Newton step
   std::vector<float> jacs(7);
-  jacobian = hessian_approx.inv() * jacobian;
+  region_jacobian = region_hessian_approx.inv() * region_jacobian;
   for (size_t v = 0; v < 7; ++v){
-    jacs[v] = -jacobian(v);
+    jacs[v] = -region_jacobian(v);
   }
   current_model->UpdatePose(jacs);
 
@@ -183,8 +185,8 @@ void StereoPWP3D::TrackTargetInFrame(boost::shared_ptr<Model> current_model, boo
   if (curr_step == 0) {
 
     cv::Mat left_sdf_image;
-    cv::Mat front_intersection_image, back_intersection_image, front_normal_image;
-    cv::Mat sdf_image(frame_->GetImage().rows, frame_->GetImage().cols, CV_32FC1), right_sdf_image;
+    cv::Mat front_intersection_image, back_intersection_image;
+    cv::Mat sdf_image = scratch_.Acquire(frame_->GetImage().size(), CV_32FC1), right_sdf_image;
     ProcessSDFAndIntersectionImage(current_model, stereo_camera_->right_eye(), right_sdf_image, front_intersection_image, back_intersection_image);
     Localizer::ResetOcclusionImage();
     ProcessSDFAndIntersectionImage(current_model, stereo_camera_->left_eye(), left_sdf_image, front_intersection_image, back_intersection_image);
@@ -194,7 +196,7 @@ void StereoPWP3D::TrackTargetInFrame(boost::shared_ptr<Model> current_model, boo
 
     if (current_model->NeedsModelRetrain()){
 
-      cv::Mat label_image = cv::Mat::zeros(left_sdf_image.size(), CV_8UC1);
+      cv::Mat label_image = scratch_.AcquireZeros(left_sdf_image.size(), CV_8UC1);
       for (int r = 0; r < label_image.rows; ++r){
         for (int c = 0; c < label_image.cols; ++c){
           if (left_sdf_image.at<float>(r, c) > 0){
@@ -211,6 +213,11 @@ void StereoPWP3D::TrackTargetInFrame(boost::shared_ptr<Model> current_model, boo
     right_sdf_image.copyTo(sdf_image(cv::Rect(left_sdf_image.cols, 0, left_sdf_image.cols, left_sdf_image.rows)));
     current_model->ClassifyFrame(frame_, sdf_image);
 
+    ScopedTimer lk_timer(PROFILE_LK);
+
+    //every model in the frame shares the gray image and pyramid
+    if (point_registration_) point_registration_->SetFramePyramid(stereo_frame->GetFeaturePyramid());
+
     if (point_registration_ && !current_model->mps.is_initialised){
       point_registration_->SetFrontIntersectionImage(front_intersection_image, current_model);
       point_registration_->InitializeTracker(stereo_frame->GetLeftImage(), current_model);
@@ -220,6 +227,8 @@ void StereoPWP3D::TrackTargetInFrame(boost::shared_ptr<Model> current_model, boo
       point_registration_->TrackLocalPoints(stereo_frame->GetLeftImage(), current_model);
     }
 
+    lk_timer.Stop();
+
   }
 
   
@@ -227,7 +236,9 @@ void StereoPWP3D::TrackTargetInFrame(boost::shared_ptr<Model> current_model, boo
   // float right_error = DoRegionBasedAlignmentStepForRightEye(current_model);
   //float point_error = DoPointBasedAlignmentStepForLeftEye(current_model);
 
+  ScopedTimer step_timer(PROFILE_ALIGNMENT_STEP);
   float error = DoAlignmentStep(current_model);
+  step_timer.Stop();
 
   //UpdateWithErrorValue(left_error + right_error + point_error);
   //errors_.push_back(left_error + right_error + point_error);
@@ -248,11 +259,14 @@ void StereoPWP3D::ComputeJacobiansForEye(const cv::Mat &classification_image, bo
 
   ProcessSDFAndIntersectionImage(current_model, camera, sdf_image, front_intersection_image, back_intersection_image);
 
+  ScopedTimer jacobian_timer(PROFILE_JACOBIAN);
+
   auto stereo_frame = boost::dynamic_pointer_cast<sv::StereoFrame>(frame_);
 
   float fg_area = 1.0f, bg_area = 1.0f;
   size_t contour_area = 0;
   ComputeAreas(sdf_image, fg_area, bg_area, contour_area);
+  ProfileCount(COUNTER_CONTOUR_PIXELS, contour_area);
   
   float *sdf_im_data = (float *)sdf_image.data;
   float *front_intersection_data = (float *)front_intersection_image.data;
@@ -0,0 +1,299 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "../../../include/ttrack/track/localizer/localizer_recording.hpp"
+#include "../../../include/ttrack/track/localizer/features/descriptor_map.hpp"
+
+using namespace ttrk;
+
+namespace {
+
+  const char RECORDING_MAGIC[8] = "TTRKLOC";
+
+  template<typename T>
+  void Write(std::ostream &os, const T &value){
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template<typename T>
+  void Read(std::istream &is, T &value){
+    is.read(reinterpret_cast<char *>(&value), sizeof(T));
+    if (!is) throw std::runtime_error("Error, localizer input recording is truncated.");
+  }
+
+  //rows, cols and type then the pixels row by row
+  void WriteMat(std::ostream &os, const cv::Mat &m){
+
+    Write(os, (boost::int32_t)m.rows);
+    Write(os, (boost::int32_t)m.cols);
+    Write(os, (boost::int32_t)m.type());
+
+    const size_t row_size = m.cols * m.elemSize();
+    for (int r = 0; r < m.rows; ++r)
+      os.write(reinterpret_cast<const char *>(m.ptr(r)), row_size);
+
+  }
+
+  void ReadMat(std::istream &is, cv::Mat &m){
+
+    boost::int32_t rows, cols, type;
+    Read(is, rows);
+    Read(is, cols);
+    Read(is, type);
+
+    if (rows == 0 || cols == 0){
+      m = cv::Mat();
+      return;
+    }
+
+    m.create(rows, cols, type);
+    is.read(reinterpret_cast<char *>(m.data), m.total() * m.elemSize());
+    if (!is) throw std::runtime_error("Error, localizer input recording is truncated.");
+
+  }
+
+  template<typename T>
+  void WriteVector(std::ostream &os, const std::vector<T> &v){
+    Write(os, (boost::uint32_t)v.size());
+    if (!v.empty()) os.write(reinterpret_cast<const char *>(&v[0]), v.size() * sizeof(T));
+  }
+
+  template<typename T>
+  void ReadVector(std::istream &is, std::vector<T> &v){
+    boost::uint32_t size;
+    Read(is, size);
+    v.resize(size);
+    if (size > 0) is.read(reinterpret_cast<char *>(&v[0]), size * sizeof(T));
+    if (!is) throw std::runtime_error("Error, localizer input recording is truncated.");
+  }
+
+  void WriteTrackedPoint(std::ostream &os, const TrackedPoint &p){
+
+    Write(os, p.model_point);
+    Write(os, p.frame_point);
+    Write(os, p.found_image_point);
+    Write(os, p.component_idx);
+    Write(os, (unsigned char)p.point_in_view);
+    Write(os, (unsigned char)p.point_tracked_on_model);
+
+    WriteMat(os, p.subwindow);
+    WriteMat(os, p.surface_at_point);
+
+    Write(os, (boost::uint32_t)p.spatial_derivatives.size());
+    for (auto &d : p.spatial_derivatives) WriteMat(os, d);
+    WriteVector(os, p.temporal_derivatives);
+
+  }
+
+  TrackedPoint ReadTrackedPoint(std::istream &is){
+
+    cv::Vec3f model_point;
+    cv::Vec2f frame_point;
+    Read(is, model_point);
+    Read(is, frame_point);
+
+    TrackedPoint p(model_point, frame_point);
+
+    unsigned char in_view, tracked_on_model;
+    Read(is, p.found_image_point);
+    Read(is, p.component_idx);
+    Read(is, in_view);
+    Read(is, tracked_on_model);
+    p.point_in_view = in_view != 0;
+    p.point_tracked_on_model = tracked_on_model != 0;
+
+    ReadMat(is, p.subwindow);
+    ReadMat(is, p.surface_at_point);
+
+    boost::uint32_t num_spatial_derivatives;
+    Read(is, num_spatial_derivatives);
+    p.spatial_derivatives.resize(num_spatial_derivatives);
+    for (auto &d : p.spatial_derivatives) ReadMat(is, d);
+    ReadVector(is, p.temporal_derivatives);
+
+    return p;
+
+  }
+
+  //a size of zero for no map, then the descriptors with their match counts
+  void WriteDescriptorMap(std::ostream &os, const boost::shared_ptr<DescriptorMap> &descriptor_map){
+
+    Write(os, (boost::uint32_t)(descriptor_map ? descriptor_map->GetMaxSize() : 0));
+    if (!descriptor_map) return;
+
+    Write(os, (boost::uint32_t)descriptor_map->Size());
+    for (auto &d : descriptor_map->GetDescriptors()){
+      Write(os, d.GetModelPoint());
+      Write(os, d.GetModelNormal());
+      WriteMat(os, d.GetDescriptor());
+      Write(os, (boost::uint64_t)d.GetTimesMatched());
+      Write(os, (boost::uint64_t)d.GetTotalNumberOfAttempts());
+    }
+
+  }
+
+  void ReadDescriptorMap(std::istream &is, boost::shared_ptr<DescriptorMap> &descriptor_map){
+
+    boost::uint32_t max_size;
+    Read(is, max_size);
+    if (max_size == 0){
+      descriptor_map.reset();
+      return;
+    }
+
+    descriptor_map.reset(new DescriptorMap(max_size));
+
+    boost::uint32_t size;
+    Read(is, size);
+    for (boost::uint32_t i = 0; i < size; ++i){
+      cv::Vec3f point, normal;
+      cv::Mat descriptor;
+      boost::uint64_t times_matched, total_num_attempts;
+      Read(is, point);
+      Read(is, normal);
+      ReadMat(is, descriptor);
+      Read(is, times_matched);
+      Read(is, total_num_attempts);
+      descriptor_map->Add(Descriptor(point, normal, descriptor, (size_t)times_matched, (size_t)total_num_attempts));
+    }
+
+  }
+
+  void WritePointSet(std::ostream &os, const ModelPointSet &mps){
+
+    Write(os, (unsigned char)mps.is_initialised);
+
+    Write(os, (boost::uint32_t)mps.tracked_points_.size());
+    for (auto &p : mps.tracked_points_) WriteTrackedPoint(os, p);
+
+    WriteVector(os, mps.points_test[0]);
+    WriteVector(os, mps.points_test[1]);
+
+    WriteMat(os, mps.front_intersection_image_);
+    WriteMat(os, mps.previous_intersection_image_);
+    WriteMat(os, mps.current_frame);
+    WriteMat(os, mps.previous_frame);
+    WriteVector(os, mps.previous_keypoints);
+    WriteMat(os, mps.previous_descriptors);
+    WriteDescriptorMap(os, mps.descriptor_map);
+
+  }
+
+  void ReadPointSet(std::istream &is, ModelPointSet &mps){
+
+    unsigned char is_initialised;
+    Read(is, is_initialised);
+    mps.is_initialised = is_initialised != 0;
+
+    boost::uint32_t num_points;
+    Read(is, num_points);
+    mps.tracked_points_.clear();
+    mps.tracked_points_.reserve(num_points);
+    for (boost::uint32_t i = 0; i < num_points; ++i) mps.tracked_points_.push_back(ReadTrackedPoint(is));
+
+    ReadVector(is, mps.points_test[0]);
+    ReadVector(is, mps.points_test[1]);
+
+    ReadMat(is, mps.front_intersection_image_);
+    ReadMat(is, mps.previous_intersection_image_);
+    ReadMat(is, mps.current_frame);
+    ReadMat(is, mps.previous_frame);
+    ReadVector(is, mps.previous_keypoints);
+    ReadMat(is, mps.previous_descriptors);
+    ReadDescriptorMap(is, mps.descriptor_map);
+
+  }
+
+}
+
+void ttrk::RestorePointSet(const ModelPointSet &source, ModelPointSet &destination){
+
+  destination.tracked_points_.clear();
+  destination.tracked_points_.reserve(source.tracked_points_.size());
+  for (auto &p : source.tracked_points_) destination.tracked_points_.push_back(p);
+
+  destination.points_test[0] = source.points_test[0];
+  destination.points_test[1] = source.points_test[1];
+
+  //the localizer writes into these so give the model its own copy and keep the recording intact for another replay
+  destination.front_intersection_image_ = source.front_intersection_image_.clone();
+  destination.previous_intersection_image_ = source.previous_intersection_image_.clone();
+  destination.current_frame = source.current_frame.clone();
+  destination.previous_frame = source.previous_frame.clone();
+  destination.previous_pyramid.reset();
+  destination.previous_keypoints = source.previous_keypoints;
+  destination.previous_descriptors = source.previous_descriptors.clone();
+  //the descriptor matrices are never written to so only the match counts need copying
+  if (source.descriptor_map) destination.descriptor_map.reset(new DescriptorMap(*source.descriptor_map));
+  else destination.descriptor_map.reset();
+  destination.is_initialised = source.is_initialised;
+
+}
+
+LocalizerInputWriter::LocalizerInputWriter(const std::string &path) : num_frames_(0) {
+
+  ofs_.open(path.c_str(), std::ios::binary | std::ios::trunc);
+  if (!ofs_.is_open()) throw std::runtime_error("Error, could not open localizer input recording " + path);
+
+  LocalizerRecordingHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+  header.version = LocalizerRecordingHeader::VERSION;
+  Write(ofs_, header);
+
+}
+
+void LocalizerInputWriter::Append(const LocalizerInput &input){
+
+  if (input.poses.size() != input.point_sets.size()) throw std::runtime_error("Error, localizer input needs a point set for every pose.");
+
+  Write(ofs_, input.frame_index);
+  WriteMat(ofs_, input.image);
+  WriteMat(ofs_, input.classification_map);
+
+  Write(ofs_, (boost::uint32_t)input.poses.size());
+  for (size_t i = 0; i < input.poses.size(); ++i){
+    WriteVector(ofs_, input.poses[i]);
+    WritePointSet(ofs_, input.point_sets[i]);
+  }
+
+  //each frame is complete on disk so a crashed run can still be replayed up to the crash
+  ofs_.flush();
+  num_frames_++;
+
+}
+
+LocalizerInputReader::LocalizerInputReader(const std::string &path) : path_(path) {
+
+  ifs_.open(path.c_str(), std::ios::binary);
+  if (!ifs_.is_open()) throw std::runtime_error("Error, could not open localizer input recording " + path);
+
+  LocalizerRecordingHeader header;
+  ifs_.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!ifs_ || std::memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0) throw std::runtime_error("Error, " + path + " is not a localizer input recording.");
+  if (header.version != LocalizerRecordingHeader::VERSION) throw std::runtime_error("Error, unsupported localizer input recording version in " + path);
+
+}
+
+bool LocalizerInputReader::Read(LocalizerInput &input){
+
+  //a clean end of file is only allowed between frames
+  if (ifs_.peek() == std::char_traits<char>::eof()) return false;
+
+  ::Read(ifs_, input.frame_index);
+  ReadMat(ifs_, input.image);
+  ReadMat(ifs_, input.classification_map);
+
+  boost::uint32_t num_models;
+  ::Read(ifs_, num_models);
+  input.poses.resize(num_models);
+  input.point_sets.clear();
+  input.point_sets.resize(num_models);
+  for (boost::uint32_t i = 0; i < num_models; ++i){
+    ReadVector(ifs_, input.poses[i]);
+    ReadPointSet(ifs_, input.point_sets[i]);
+  }
+
+  return true;
+
+}
@@ -1,4 +1,5 @@
 #include <fstream>
+#include <sstream>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <cinder/gl/gl.h>
@@ -12,7 +13,7 @@ using namespace ttrk;
 
 size_t Model::total_model_count_ = 0;
 
-Model::Model(const std::string &model_parameter_file, const std::string &save_file) : save_file_(save_file) {
+Model::Model(const std::string &model_parameter_file, const std::string &save_file) : save_file_(save_file), use_recorded_classification_(false) {
   
   total_model_count_++;
 
@@ -22,7 +23,9 @@ Model::Model(const std::string &model_parameter_file, const std::string &save_fi
 
 }
 
-void Model::WriteICLData(const cv::Mat &occlusion_image) {
+std::string Model::GetICLDataAsString(const cv::Mat &occlusion_image) {
+
+  std::stringstream icl_output;
 
   for (auto &pt : icl_data){
 
@@ -36,55 +39,40 @@ void Model::WriteICLData(const cv::Mat &occlusion_image) {
     float point_in_occlusion_image = occlusion_image.at<float>(in_frame_coords.y, in_frame_coords.x);
 
     if (std::abs(point_in_occlusion_image - point_in_camera_coords[2]) < 3){
-      icl_output_file << pt.name << "\n";
-      icl_output_file << point_in_camera_coords << "\n";
+      icl_output << pt.name << "\n";
+      icl_output << point_in_camera_coords << "\n";
     }
     else{
-      icl_output_file << pt.name << " not in view \n";
+      icl_output << pt.name << " not in view \n";
     }
 
   }
 
-  icl_output_file << std::endl;
+  icl_output << "\n";
+
+  return icl_output.str();
 
 }
 
-Model::Model(Node::Ptr component, const ci::Matrix44f &world_to_model_transform){
+Model::Model(Node::Ptr component, const ci::Matrix44f &world_to_model_transform) : frame_count_(0), use_recorded_classification_(false) {
 
   model_ = component;
   world_to_model_coordinates_ = Pose(component->GetWorldTransform(world_to_model_transform)); //need to write the get world transform bit
 
 }
 
-void Model::WritePoseToFile() {
-
-  if (!ofs_.is_open())
-    ofs_.open(save_file_);
-  
-  if (!ofs_.is_open()) {
-    ci::app::console() << "Model file is not open!" << std::endl;
-    throw std::runtime_error("");
-  }
-
+std::string Model::GetPoseAsString() {
 
   std::vector<float> current_pose;
   GetPose(current_pose);
 
+  std::stringstream ss;
   for (auto &c : current_pose)
-    ofs_ << c << " ";
+    ss << c << " ";
 
-  //ci::Matrix44f m = world_to_model_coordinates_;
-  ////float a1 = 
-
-  //for (int r = 0; r < 4; ++r){
-  //  for (int c = 0; c < 4; ++c){
-  //    ofs_ << m.at(r, c);
-  //    if (c != 3) ofs_ << " ";
-  //  }
-  //  ofs_ << "\n";
-  //}
+  ss << "\n\n";
 
-  ofs_ << "\n" << std::endl;
+  return ss.str();
 
 }
 
@@ -199,6 +187,7 @@ size_t Model::GetNumberOfDofs(){
 }
 
 bool Model::NeedsModelRetrain() {
+  if (use_recorded_classification_) return false;
   if (frame_count_ == 0 || frame_count_ % 5 == 0) {
     frame_count_++;
     return true;
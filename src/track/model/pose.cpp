@@ -99,13 +99,21 @@ Pose::Pose(const ci::Matrix44f &t) : translation_(t.getTranslate().xyz()) {
 
 }
 
-std::vector<ci::Vec3f> Pose::ComputeJacobian(const ci::Vec3f &point_) const {
+std::vector<ci::Vec3f> Pose::ComputeJacobian(const ci::Vec3f &point) const {
+
+  std::vector<ci::Vec3f> data;
+  ComputeJacobian(point, data);
+  return data;
+
+}
+
+void Pose::ComputeJacobian(const ci::Vec3f &point_, std::vector<ci::Vec3f> &data) const {
 
   ci::Matrix44f self_pose = *this;
   
   ci::Vec3f point = self_pose.inverted() * point_;
 
-  std::vector<ci::Vec3f> data(7);
+  data.resize(7);
 
   //translation dofs
   data[0] = ci::Vec3f(1.0f, 0.0f, 0.0f);
@@ -179,7 +187,6 @@ std::vector<ci::Vec3f> Pose::ComputeJacobian(const ci::Vec3f &point_) const {
   //data[19] = (2 * rotation_.w*point[0]) - (4 * rotation_.X()*point[1]) + (2 * rotation_.Y()*point[2]);
   //data[20] = (2 * rotation_.X()*point[0]) + (2 * rotation_.Y()*point[1]);
 
-  return data;
 }
 
 void Pose::UpdatePose(const std::vector<float> &updates) {
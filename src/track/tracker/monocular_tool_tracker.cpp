@@ -7,8 +7,18 @@ using namespace ttrk;
 
 MonocularToolTracker::MonocularToolTracker(const std::string &model_parameter_file, const std::string &calibration_filename, const std::string &results_dir, const LocalizerType &localizer_type, const size_t number_of_labels) :SurgicalToolTracker(model_parameter_file, results_dir), camera_(new MonocularCamera(calibration_filename)){
   
-  if (localizer_type == LocalizerType::PWP3D_LK || localizer_type == LocalizerType::PWP3D_SIFT)
+  if (localizer_type == LocalizerType::PWP3D_SIFT){
     localizer_.reset(new MonoPWP3D(camera_));
+    localizer_->SetFeatureLocalizer(boost::shared_ptr<FeatureLocalizer>(new PointRegistration(camera_)));
+  }
+  else if (localizer_type == LocalizerType::PWP3D_LK){
+    localizer_.reset(new MonoPWP3D(camera_));
+    localizer_->SetFeatureLocalizer(boost::shared_ptr<FeatureLocalizer>(new LKTracker(camera_)));
+  }
+  else if (localizer_type == LocalizerType::PWP3D_ORB){
+    localizer_.reset(new MonoPWP3D(camera_));
+    localizer_->SetFeatureLocalizer(boost::shared_ptr<FeatureLocalizer>(new ORBRegistration(camera_)));
+  }
   else
     throw std::runtime_error("");
 
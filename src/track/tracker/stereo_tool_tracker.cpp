@@ -27,6 +27,10 @@ StereoToolTracker::StereoToolTracker(const std::string &model_parameter_file, co
     localizer_.reset(new StereoPWP3D(camera_));
     localizer_->SetFeatureLocalizer(boost::shared_ptr<FeatureLocalizer>(new LKTracker(camera_->left_eye())));
   }
+  else if (localizer_type == LocalizerType::PWP3D_ORB){
+    localizer_.reset(new StereoPWP3D(camera_));
+    localizer_->SetFeatureLocalizer(boost::shared_ptr<FeatureLocalizer>(new ORBRegistration(camera_->left_eye())));
+  }
   else if (localizer_type == LocalizerType::ComponentLS_SIFT){
     localizer_.reset(new ComponentLevelSet(number_of_labels, camera_));
     localizer_->SetFeatureLocalizer(boost::shared_ptr<FeatureLocalizer>(new PointRegistration(camera_->left_eye())));
@@ -4,6 +4,7 @@
 #include "../../../include/ttrack/track/tracker/tracker.hpp"
 #include "../../../include/ttrack/utils/helpers.hpp"
 #include "../../../include/ttrack/utils/camera.hpp"
+#include "../../../include/ttrack/utils/tracer.hpp"
 using namespace ttrk;
 
 Tracker::Tracker(const std::string &model_parameter_file, const std::string &results_dir) : model_parameter_file_(model_parameter_file), results_dir_(results_dir), tracking_(false), frame_count_(-1) {
@@ -21,17 +22,39 @@ void Tracker::operator()(boost::shared_ptr<sv::Frame> image, const bool found){
 
 void Tracker::RunStep(){
 
+  TraceScope trace("Tracker::RunStep");
+
   ttrk::Localizer::ResetOcclusionImage();
 
+  //everything the localizer reads is fixed by the end of the first step on a frame
+  const bool record_inputs = localizer_recorder_ && localizer_->GetStepCount() == 0;
+  LocalizerInput recorded_input;
+
   for (current_model_ = tracked_models_.begin(); current_model_ != tracked_models_.end(); current_model_++){
 
+    if (record_inputs){
+      recorded_input.poses.push_back(std::vector<float>());
+      current_model_->model->GetPose(recorded_input.poses.back());
+      recorded_input.point_sets.push_back(ModelPointSet());
+      RestorePointSet(current_model_->model->mps, recorded_input.point_sets.back());
+    }
+
     localizer_->SetFrameCount(frame_count_);
+
+    TraceScope localizer_trace("Localizer::TrackTargetInFrame");
     localizer_->TrackTargetInFrame(current_model_->model, frame_);
   
     localizer_image_ = localizer_->GetProgressFrame();
 
   }
 
+  if (record_inputs){
+    recorded_input.frame_index = frame_count_;
+    recorded_input.image = frame_->GetImage();
+    recorded_input.classification_map = frame_->GetClassificationMap();
+    localizer_recorder_->Append(recorded_input);
+  }
+
   localizer_->UpdateStepCount();
 
   if (localizer_->IsFirstRun()) localizer_->DoneFirstStep();  
@@ -41,6 +64,8 @@ void Tracker::RunStep(){
 
 void Tracker::Run(boost::shared_ptr<sv::Frame> image, const bool found){
 
+  TraceScope trace("Tracker::Run");
+
   SetHandleToFrame(image);
 
   frame_count_++;
@@ -75,6 +100,51 @@ void Tracker::Run(boost::shared_ptr<sv::Frame> image, const bool found){
 }
 
 
+bool Tracker::ReplayLocalizerInput(const LocalizerInput &input, boost::shared_ptr<sv::Frame> frame){
+
+  TraceScope trace("Tracker::ReplayLocalizerInput");
+
+  SetHandleToFrame(frame);
+
+  cv::Mat classification_map = frame_->GetClassificationMap();
+  if (classification_map.size() != input.classification_map.size() || classification_map.type() != input.classification_map.type())
+    throw std::runtime_error("Error, the recorded classification map doesn't match the frame.");
+  input.classification_map.copyTo(classification_map);
+
+  frame_count_++;
+
+  if (!tracking_){
+
+    tracked_models_.clear();
+
+    if (!Init() || !InitTemporalModels())
+      return false;
+    tracking_ = true;
+
+  }
+
+  if (tracked_models_.size() != input.poses.size()) throw std::runtime_error("Error, the recording has a different number of models to the tracker.");
+
+  for (size_t i = 0; i < tracked_models_.size(); ++i){
+
+    boost::shared_ptr<Model> model = tracked_models_[i].model;
+    std::vector<float> pose = input.poses[i];
+    model->SetPose(pose);
+    RestorePointSet(input.point_sets[i], model->mps);
+    model->UseRecordedClassification(true);
+
+  }
+
+  localizer_->ResetStepCount();
+
+  do {
+    RunStep();
+  } while (!localizer_->HasConverged());
+
+  return true;
+
+}
+
 bool Tracker::InitTemporalModels(){
 
   for (auto i = tracked_models_.begin(); i != tracked_models_.end(); i++){
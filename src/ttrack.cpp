@@ -14,11 +14,20 @@
 
 using namespace ttrk;
 
-void TTrack::SetUp(const std::string &model_parameter_file, const std::string &camera_calibration_file, const std::string &classifier_path, const std::string &results_dir, const LocalizerType &localizer_type, const ClassifierType classifier_type, const std::string &left_media_file, const std::string &right_media_file, const std::vector< std::vector<float> > &starting_poses, const size_t number_of_labels, const size_t skip_frames){
+void TTrack::SetUp(const std::string &model_parameter_file, const std::string &camera_calibration_file, const std::string &classifier_path, const std::string &results_dir, const LocalizerType &localizer_type, const ClassifierType classifier_type, const std::string &left_media_file, const std::string &right_media_file, const std::vector< std::vector<float> > &starting_poses, const size_t number_of_labels, const size_t skip_frames, const std::string &frame_cache_file){
   
   SetUp(model_parameter_file, camera_calibration_file, classifier_path, results_dir, localizer_type, classifier_type, CameraType::STEREO, starting_poses, number_of_labels);
   tracker_->Tracking(false); 
-  handler_.reset(new StereoVideoHandler(left_media_file,right_media_file, results_dir_ + "/tracked_video.avi", skip_frames));
+
+  //replay the decoded frames if they've been cached, otherwise decode the videos (and cache them if asked)
+  if (!frame_cache_file.empty() && boost::filesystem::exists(frame_cache_file))
+    handler_.reset(new CachedFrameHandler(frame_cache_file, results_dir_ + "/tracked_video.avi"));
+  else if (!frame_cache_file.empty())
+    handler_.reset(new CacheRecordingHandler(new StereoVideoHandler(left_media_file, right_media_file, results_dir_ + "/tracked_video.avi", skip_frames), frame_cache_file));
+  else if (boost::filesystem::is_directory(boost::filesystem::path(left_media_file)))
+    handler_.reset(new StereoImageHandler(left_media_file, right_media_file, results_dir_ + "/tracked_frames/"));
+  else
+    handler_.reset(new StereoVideoHandler(left_media_file,right_media_file, results_dir_ + "/tracked_video.avi", skip_frames));
 
 }
 
@@ -53,12 +62,26 @@ void TTrack::SetUp(const std::string &model_parameter_file, const std::string &c
 
 void TTrack::SetUp(const std::string &model_parameter_file, const std::string &camera_calibration_file, const std::string &classifier_path, const std::string &results_dir, const LocalizerType &localizer_type, ClassifierType classifier_type, const CameraType camera_type, const std::vector< std::vector<float> > &starting_poses, const size_t number_of_labels){
   
+  StopTrackingThread();
+
   camera_type_ = camera_type;
   results_dir_ = results_dir;
+  results_writer_.reset(new ResultsWriter());
+  trajectory_logs_.clear();
   
   //if train type is NA, training is skipped
   //detector_.reset(new Detect(classifier_path, classifier_type, number_of_labels));
 
+  //the localizers create their framebuffers on construction and framebuffers can't be shared between contexts, so build the tracker 
+  //with the context it will run in current
+  if (tracking_context_){
+    tracking_context_->MakeCurrent();
+    tracker_.reset();
+    tracking_context_->Release();
+  }
+  tracking_context_.reset(new SharedGLContext());
+  tracking_context_->MakeCurrent();
+
   //load the correct type of tool tracker
   switch (camera_type_){
   case STEREO:
@@ -73,6 +96,8 @@ void TTrack::SetUp(const std::string &model_parameter_file, const std::string &c
   }
 
 
+  tracking_context_->Release();
+
   for (auto &starting_pose : starting_poses)
     tracker_->AddStartPose(starting_pose);
 
@@ -83,7 +108,17 @@ void TTrack::SetUp(const std::string &model_parameter_file, const std::string &c
 
 void TTrack::GetUpdate(std::vector<boost::shared_ptr<Model> > &models, const bool force_new_frame){
 
-  static int count = 0;
+  TraceScope trace("TTrack::GetUpdate");
+
+  tracking_context_->MakeCurrent();
+  UpdateTracker(models, force_new_frame);
+  tracking_context_->Release();
+
+}
+
+void TTrack::UpdateTracker(std::vector<boost::shared_ptr<Model> > &models, const bool force_new_frame){
+
+  TraceScope trace("TTrack::UpdateTracker");
 
   if (tracker_->HasConverged() || force_new_frame || tracker_->IsFirstRun()){
   
@@ -91,47 +126,165 @@ void TTrack::GetUpdate(std::vector<boost::shared_ptr<Model> > &models, const boo
 
     //detector_->Run(GetPtrToNewFrame());
 
+    //everything timed since the last frame was loaded belongs to that frame
+    if (frame_index_ > 0) Profiler::Instance().EndFrame();
+
+    const int64 load_start = cv::getTickCount();
+    boost::shared_ptr<sv::Frame> frame = GetPtrToNewFrame();
+    const int64 track_start = cv::getTickCount();
+
     //tracker_->Run(GetPtrToClassifiedFrame(), detector_->Found());
-    tracker_->Run(GetPtrToNewFrame(), true);
+    tracker_->Run(frame, true);
+
+    frame_load_time_ = (track_start - load_start) / cv::getTickFrequency();
+    frame_track_time_ = (cv::getTickCount() - track_start) / cv::getTickFrequency();
 
-    count++;
+    frame_index_++;
 
   }
   else{
+    const int64 track_start = cv::getTickCount();
     tracker_->RunStep();
+    frame_track_time_ += (cv::getTickCount() - track_start) / cv::getTickFrequency();
     localizer_image_ = tracker_->GetLocalizerProgressFrame();
   }
 
 
   tracker_->GetTrackedModels(models);
 
-  //if (count > 1000){
-  //  handler_.reset();
+}
 
-  //}
+void TTrack::StartTrackingThread(){
+
+  if (tracking_thread_.joinable()) return;
+
+  stop_tracking_ = false;
+
+  //the tracker can only render on another thread if it has its own context, otherwise it stays on this one
+  if (!tracking_context_->IsShared()){
+    step_on_caller_ = true;
+    return;
+  }
+
+  tracking_thread_ = boost::thread(boost::ref(*this));
+
+}
+
+void TTrack::StopTrackingThread(){
+
+  step_on_caller_ = false;
+
+  if (!tracking_thread_.joinable()) return;
+
+  {
+    //wake the thread up if it is waiting for a rendered frame
+    boost::lock_guard<boost::mutex> lock(rendered_frame_mutex_);
+    stop_tracking_ = true;
+    rendered_frame_ready_.notify_all();
+  }
+  tracking_thread_.join();
 
 }
 
 void TTrack::RunThreaded(){
 
-  //detector_->Run( GetPtrToNewFrame() ); 
-  //
-  //while( !handler_->Done() ){ //signals done by reading an empty image file either from a video or a directory of images
-  //  
-  //  boost::thread TrackThread(boost::ref(*(tracker_.get())), GetPtrToClassifiedFrame() , detector_->Found() );
-  //  boost::thread DetectThread(boost::ref(*(detector_.get())), GetPtrToNewFrame() );
+  Tracer::Instance().SetThreadName("tracking");
+
+  tracking_context_->MakeCurrent();
+
+  while (!stop_tracking_){
+
+    if (pause_tracking_){
+      boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+      continue;
+    }
+
+    if (!StepTracking()) break;
+
+  }
+
+  tracking_context_->Release();
 
-  //  TrackThread.join();
-  //  DetectThread.join();
- 
-  //}
-  
 }  
 
+bool TTrack::StepTracking(){
+
+  std::vector<boost::shared_ptr<Model> > models;
+  UpdateTracker(models, force_new_frame_.exchange(false));
+
+  //the results saved here are the ones that don't need the GUI, the rendered views are saved when the GUI sees a converged snapshot
+  if (frame_ != nullptr && tracker_->HasConverged())
+    SaveResults();
+
+  PublishSnapshot(models);
+
+  return !handler_->Done();
+
+}
+
+bool TTrack::UpdateSnapshot(){
+
+  if (step_on_caller_ && !pause_tracking_){
+    tracking_context_->MakeCurrent();
+    step_on_caller_ = StepTracking();
+    tracking_context_->Release();
+  }
+
+  return snapshots_.Update();
+
+}
+
+void TTrack::PublishSnapshot(std::vector<boost::shared_ptr<Model> > &models){
+
+  TrackingSnapshot &snapshot = snapshots_.GetWriteBuffer();
+
+  snapshot.frame_index = frame_index_;
+  snapshot.done = handler_->Done() || frame_ == nullptr;
+  snapshot.converged = !snapshot.done && tracker_->HasConverged();
+
+  if (snapshot.converged){
+    boost::lock_guard<boost::mutex> lock(rendered_frame_mutex_);
+    awaited_frame_index_ = frame_index_;
+  }
+
+  snapshot.poses.resize(models.size());
+  for (size_t i = 0; i < models.size(); ++i)
+    models[i]->GetPose(snapshot.poses[i]);
+
+  //the input images don't change between steps so only copy them when a new frame is loaded, the copies are never written to again
+  //so the snapshots can share them
+  if (frame_ != published_frame_){
+
+    published_frame_ = frame_;
+
+    boost::shared_ptr<sv::StereoFrame> stereo_frame = boost::dynamic_pointer_cast<sv::StereoFrame>(frame_);
+    if (stereo_frame){
+      published_left_image_ = stereo_frame->GetLeftImage().clone();
+      published_right_image_ = stereo_frame->GetRightImage().clone();
+    }
+    else if (frame_ != nullptr){
+      published_left_image_ = frame_->GetImage().clone();
+      published_right_image_ = cv::Mat();
+    }
+
+    published_detector_image_ = GetCurrentDetectorImage().clone();
+
+  }
+
+  snapshot.left_image = published_left_image_;
+  snapshot.right_image = published_right_image_;
+  snapshot.detector_image = published_detector_image_;
+  snapshot.localizer_image = localizer_image_.clone();
+
+  snapshots_.Publish();
+
+}
+
 LocalizerType TTrack::LocalizerTypeFromString(const std::string &str){
 
   if (str == "PWP3D_SIFT" ) return LocalizerType::PWP3D_SIFT;
   else if (str == "PWP3D_LK") return LocalizerType::PWP3D_LK;
+  else if (str == "PWP3D_ORB") return LocalizerType::PWP3D_ORB;
   else if (str == "CompLS_SIFT") return LocalizerType::ComponentLS_SIFT;
   else if (str == "CompLS_LK") return LocalizerType::ComponentLS_LK;
   else if (str == "LSForest") return LocalizerType::LevelSetForest;
@@ -174,10 +327,7 @@ ClassifierType TTrack::ClassifierFromString(const std::string &classifier_name){
 
 }
 
-void TTrack::SaveFrame(const cv::Mat &frame, bool flip) {
-
-  if (!boost::filesystem::exists(results_dir_))
-    boost::filesystem::create_directories(results_dir_);
+void TTrack::SaveFrame(const cv::Mat &frame, const size_t frame_index, bool flip) {
 
   cv::Mat f;
   if (flip){
@@ -187,15 +337,44 @@ void TTrack::SaveFrame(const cv::Mat &frame, bool flip) {
     f = frame.clone();
   }
 
-  //request the handler to save it to a video/image
-  handler_->SaveFrame(f);
+  //the handler belongs to the tracking thread, hand the frame over and let it do the saving
+  boost::lock_guard<boost::mutex> lock(rendered_frame_mutex_);
+  rendered_frame_ = f;
+  rendered_frame_index_ = frame_index;
+  rendered_frame_ready_.notify_all();
+
+}
+
+void TTrack::SaveRenderedFrame(const bool wait){
+
+  cv::Mat frame;
+
+  {
+    boost::unique_lock<boost::mutex> lock(rendered_frame_mutex_);
 
+    while (wait && rendered_frame_index_ != awaited_frame_index_ && !stop_tracking_)
+      rendered_frame_ready_.wait(lock);
 
+    if (rendered_frame_index_ != awaited_frame_index_ || rendered_frame_.empty()) return;
+
+    frame = rendered_frame_;
+    rendered_frame_ = cv::Mat();
+    awaited_frame_index_ = 0;
+  }
+
+  if (!boost::filesystem::exists(results_dir_))
+    boost::filesystem::create_directories(results_dir_);
+
+  //request the handler to save it to a video/image
+  ScopedTimer save_timer(PROFILE_RESULTS_IO);
+  handler_->SaveFrame(frame);
 
 }
 
 void TTrack::SaveResults() {
   
+  TraceScope trace("TTrack::SaveResults");
+
   if (!boost::filesystem::exists(results_dir_))
     boost::filesystem::create_directories(results_dir_);
 
@@ -207,11 +386,30 @@ void TTrack::SaveResults() {
     std::stringstream model_ss;
     model_ss << "icl_data_inst_" << i << ".txt";
 
-    if (!models[i]->icl_output_file.is_open()) models[i]->icl_output_file.open(results_dir_ + "/" + model_ss.str());
-
-    models[i]->WriteICLData(Localizer::occlusion_image);
+    //the records are formatted here as they depend on the current pose, the writer just does the I/O
+    results_writer_->WriteText(results_dir_ + "/" + model_ss.str(), models[i]->GetICLDataAsString(Localizer::occlusion_image));
+
+    results_writer_->WriteText(models[i]->GetSaveFile(), models[i]->GetPoseAsString());
+
+    TrajectoryRecord record;
+    record.frame_index = frame_index_;
+    record.score = tracker_->GetLocalizerError();
+    record.iterations = tracker_->GetLocalizerStepCount();
+    record.timings.push_back((float)frame_load_time_);
+    record.timings.push_back((float)frame_track_time_);
+    models[i]->GetPose(record.dofs);
+
+    if (trajectory_logs_.size() <= i){
+      std::stringstream log_ss;
+      log_ss << results_dir_ << "/trajectory_model_" << i << ".bin";
+      std::vector<std::string> stages;
+      stages.push_back("load_frame");
+      stages.push_back("track");
+      trajectory_logs_.push_back(boost::shared_ptr<TrajectoryLogWriter>(new TrajectoryLogWriter(log_ss.str(), record.dofs.size(), stages)));
+    }
 
-    models[i]->WritePoseToFile();
+    record.timestamp = trajectory_logs_[i]->GetElapsedTime();
+    trajectory_logs_[i]->Append(record);
 
     auto &model_debug_info = models[i]->debug_info;
     if (model_debug_info.tracked_feature_points.empty()) {
@@ -219,26 +417,35 @@ void TTrack::SaveResults() {
       continue;
     }
 
-    if (!model_debug_info.tracked_feature_points_writer.isOpened()){
-      ci::app::console() << "Opening file" << std::endl;
-      std::stringstream ss;
-      ss << "feature_points_debug_model_" << i << ".avi";
-      model_debug_info.tracked_feature_points_writer.open(results_dir_ + "/" + ss.str(), CV_FOURCC('M', 'J', 'P', 'G'), 25, model_debug_info.tracked_feature_points.size());
-    }
+    std::stringstream ss;
+    ss << "feature_points_debug_model_" << i << ".avi";
+    results_writer_->WriteFrame(results_dir_ + "/" + ss.str(), model_debug_info.tracked_feature_points.clone(), true);
 
+  }
 
-    ci::app::console() << "Writing to frame..." << std::endl;
-    model_debug_info.tracked_feature_points_writer << model_debug_info.tracked_feature_points;
+  results_writer_->WriteFrame(results_dir_ + "/detector_output.avi", GetCurrentDetectorImage().clone(), true);
 
-  }
+}
 
-  cv::Mat d = GetCurrentDetectorImage();
+void TTrack::SaveProfile() const {
 
-  static cv::VideoWriter writer(results_dir_ + "/detector_output.avi", CV_FOURCC('M', 'J', 'P', 'G'), 25, d.size());
+  if (results_dir_.empty()) return;
 
-  if (writer.isOpened()){
-    writer << d;
-  }
+  if (!boost::filesystem::exists(results_dir_))
+    boost::filesystem::create_directories(results_dir_);
+
+  Profiler::Instance().WriteCSV(results_dir_ + "/profile.csv");
+  Profiler::Instance().WriteJSON(results_dir_ + "/profile.json");
+  if (AllocationTracker::IsEnabled()) Profiler::Instance().WriteAllocationsCSV(results_dir_ + "/allocations.csv");
+
+}
+
+void TTrack::StartTrace(){
+
+  if (!boost::filesystem::exists(results_dir_))
+    boost::filesystem::create_directories(results_dir_);
+
+  Tracer::Instance().Start(results_dir_ + "/trace.json");
 
 }
 
@@ -248,7 +455,12 @@ boost::shared_ptr<const sv::Frame> TTrack::GetPtrToCurrentFrame() const {
 
 boost::shared_ptr<sv::Frame> TTrack::GetPtrToNewFrame(){
   
-  cv::Mat frame = handler_->GetNewFrame();
+  cv::Mat frame;
+  {
+    TraceScope trace("Handler::GetNewFrame");
+    ScopedTimer load_timer(PROFILE_FRAME_LOAD);
+    frame = handler_->GetNewFrame();
+  }
 
   //if the input data has run out frame will be empty, if this is so
   //reset the frame_ pointer to empty and return it. this will signal to 
@@ -268,6 +480,12 @@ boost::shared_ptr<sv::Frame> TTrack::GetPtrToNewFrame(){
     frame_.reset(new sv::MonoFrame(frame));
     break;
   }
+
+  //once per frame so every localizer and the detector see the same deinterlaced pixels
+  if (deinterlace_mode_ != sv::DEINTERLACE_NONE){
+    TraceScope trace("Deinterlace");
+    frame_->Deinterlace(deinterlace_mode_);
+  }
   
   return frame_;
 
@@ -306,9 +524,22 @@ bool TTrack::constructed_ = false;
 
 boost::scoped_ptr<TTrack> TTrack::instance_;
 
-TTrack::TTrack(){}
+TTrack::TTrack() : deinterlace_mode_(sv::DEINTERLACE_NONE), stop_tracking_(false), pause_tracking_(false), force_new_frame_(false), step_on_caller_(false), frame_index_(0), awaited_frame_index_(0), rendered_frame_index_(0), frame_load_time_(0), frame_track_time_(0) {}
 
-TTrack::~TTrack(){}
+TTrack::~TTrack(){
+
+  StopTrackingThread();
+
+  Tracer::Instance().Stop();
+
+  try{
+    SaveProfile();
+  }
+  catch (std::runtime_error &e){
+    ci::app::console() << e.what() << std::endl;
+  }
+
+}
 
 void TTrack::Destroy(){
 
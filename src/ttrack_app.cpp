@@ -2,6 +2,7 @@
 #include <cinder/Json.h>
 #include <vector>
 #include <utility>
+#include <cstdlib>
 #include <boost/ref.hpp>
 #include <CinderOpenCV.h>
 #include <cinder/gl/Fbo.h>
@@ -83,6 +84,14 @@ void TTrackApp::SetupFromConfig(const std::string &path){
   catch (...){
   }
 
+  //optionally replay (or record) the decoded frames rather than decoding the videos
+  std::string frame_cache;
+  try{
+    frame_cache = root_dir + "/" + reader.get_element("frame-cache");
+  }
+  catch (std::runtime_error &){
+  }
+
   //throwing errors here? did you remember the zero at element 15 of start pose or alteranatively set the trackable dir to absolute in the cfg file
   ttrack.SetUp(reader.get_element("trackable"),
                root_dir + "/" + reader.get_element("camera-config"),
@@ -93,10 +102,55 @@ void TTrackApp::SetupFromConfig(const std::string &path){
                root_dir + "/" + reader.get_element("left-input-video"),
                root_dir + "/" + reader.get_element("right-input-video"),
                starting_poses,
-               number_of_labels, skip_frames);
+               number_of_labels, skip_frames, frame_cache);
  
 
+  //optionally record a timeline of the tracking pipeline, this is cheap enough to leave on
+  try{
+    if (reader.get_element_as_type<int>("trace")) ttrack.StartTrace();
+  }
+  catch (std::runtime_error &){
+  }
+
+  //optionally count the allocations made in each stage, this needs a build with WITH_ALLOCATION_TRACKING
+  try{
+    if (reader.get_element_as_type<int>("track-allocations") && !ttrk::AllocationTracker::Enable())
+      ci::app::console() << "Allocation tracking was not compiled in, rebuild with WITH_ALLOCATION_TRACKING to use track-allocations" << std::endl;
+  }
+  catch (std::runtime_error &){
+  }
+
+  //optionally deinterlace frames as they are loaded, for capture which is interlaced at source. the SIFT point registration always 
+  //line doubled the even field itself, so configs using it keep that unless they say otherwise
+  const ttrk::LocalizerType localizer_type = ttrk::TTrack::LocalizerTypeFromString(reader.get_element("localizer-type"));
+  const bool uses_sift_registration = localizer_type == ttrk::LocalizerType::PWP3D_SIFT || localizer_type == ttrk::LocalizerType::ComponentLS_SIFT;
+  std::string deinterlace = uses_sift_registration ? "even" : "none";
+  try{
+    deinterlace = reader.get_element("deinterlace");
+  }
+  catch (std::runtime_error &){
+  }
+  ttrack.SetDeinterlaceMode(sv::DeinterlaceModeFromString(deinterlace));
+
   ttrk::Tracker *t = ttrack.GetTracker();
+
+  //optionally record what the localizer sees on every frame so it can be profiled with ttrack_replay
+  int record_localizer_inputs = 0;
+  try{
+    record_localizer_inputs = reader.get_element_as_type<int>("record-localizer-inputs");
+  }
+  catch (std::runtime_error &){
+  }
+  if (record_localizer_inputs){
+    if (!boost::filesystem::exists(output_dir_this_run)) boost::filesystem::create_directories(output_dir_this_run);
+    try{
+      t->RecordLocalizerInputs(output_dir_this_run + "/localizer_inputs.bin");
+    }
+    catch (std::runtime_error &e){
+      ci::app::console() << e.what() << std::endl;
+      throw;
+    }
+  }
   try{
     t->SetLocalizerIterations(reader.get_element_as_type<int>("localizer-iterations"));
   }
@@ -171,6 +225,12 @@ void TTrackApp::SetupFromConfig(const std::string &path){
 
   t->SetupPointTracker(use_point_rotation, use_point_translation, use_point_articulation, use_global_roll_search_first, use_global_roll_search_last);
 
+  //the tracker's models belong to the tracking thread so keep our own copies to draw with the published poses
+  models_to_draw_.clear();
+  for (size_t i = 0; i < starting_poses.size(); ++i){
+    models_to_draw_.push_back(boost::shared_ptr<ttrk::Model>(new ttrk::DenavitHartenbergArticulatedModel(reader.get_element("trackable"), "")));
+  }
+
   camera_.reset(new ttrk::StereoCamera(root_dir + "/" + reader.get_element("camera-config")));
   
   windows_[0].Init("Left Eye", toolbar_.GetRect().x2, 0, camera_->left_eye()->Width(), camera_->left_eye()->Height(), 625, 500, false);
@@ -202,6 +262,12 @@ void TTrackApp::startTracking(){
 
   run_tracking_ = !run_tracking_;
 
+  auto &ttrack = ttrk::TTrack::Instance();
+  if (!ttrack.IsRunning()) return;
+
+  ttrack.PauseTracking(!run_tracking_);
+  if (run_tracking_) ttrack.StartTrackingThread();
+
 }
 
 void TTrackApp::setup(){
@@ -212,6 +278,8 @@ void TTrackApp::setup(){
 
   std::vector<std::string> cmd_line_args = getArgs();
 
+  ttrk::Tracer::Instance().SetThreadName("gui");
+
   const size_t width_of_toolbar = 375;
 
   toolbar_.Init("GUI", 0, 0, width_of_toolbar, 500, false);
@@ -242,6 +310,7 @@ void TTrackApp::setup(){
     ui.AddFunction("View Left Eye Detector Output", std::bind(&TTrackApp::showDetectorOutput, this));
     ui.AddFunction("View Localizer Output", std::bind(&TTrackApp::showLocalizerOutput, this));
     ui.AddFunction("Reset 3D Scene", std::bind(&TTrackApp::reset3DViewerPosition, this));
+    ui.AddFunction("Export Timing Profile", [](){ ttrk::TTrack::Instance().SaveProfile(); });
 
     ui.AddSeparator();
 
@@ -260,13 +329,18 @@ void TTrackApp::setup(){
   force_new_frame_ = false;
   reset_3D_viewport_ = true;
   run_tracking_ = false;
+  save_results_ = false;
+  displayed_frame_index_ = 0;
+  saved_frame_index_ = 0;
    
   if (cmd_line_args.size() > 1){
 
+    const bool autostart = cmd_line_args.size() == 3 && cmd_line_args[2] == "--autostart";
+
     try{
 
       SetupFromConfig(cmd_line_args[1]);
-      if (cmd_line_args.size() == 3 && cmd_line_args[2] == "--autostart"){
+      if (autostart){
         startTracking();
         //ci::app::getWindow()->hide();
       }
@@ -277,6 +351,9 @@ void TTrackApp::setup(){
 
       ci::app::console() << "Error, input file is bad!\n";
 
+      //nobody is watching an autostarted run (e.g. the localizer comparison) so don't sit waiting for input
+      if (autostart) std::exit(EXIT_FAILURE);
+
     }
 
   }
@@ -296,38 +373,57 @@ void TTrackApp::update(){
   auto &ttrack = ttrk::TTrack::Instance();
   if (!ttrack.IsRunning() || !run_tracking_) return;
 
-  models_to_draw_.clear();
-  ttrack.GetUpdate(models_to_draw_, force_new_frame_);
+  if (force_new_frame_){
+    ttrack.ForceNewFrame();
+    force_new_frame_ = false;
+  }
 
-  if (ttrack.IsDone()) {
+  //tracking runs in its own thread, just pick up whatever it has published since the last update
+  if (!ttrack.UpdateSnapshot()) return;
+
+  const ttrk::TrackingSnapshot &snapshot = ttrack.GetSnapshot();
+
+  if (snapshot.done) {
     shutdown();
     quit();
     return;
   }  
-  
-  force_new_frame_ = false;
 
-  boost::shared_ptr<const sv::StereoFrame> stereo_frame = boost::dynamic_pointer_cast<const sv::StereoFrame>(ttrack.GetPtrToCurrentFrame());
- 
-  left_eye_image_ = ci::fromOcv(stereo_frame->GetLeftImage());
-  right_eye_image_ = ci::fromOcv(stereo_frame->GetRightImage());
+  for (size_t i = 0; i < snapshot.poses.size() && i < models_to_draw_.size(); ++i){
+    std::vector<float> pose = snapshot.poses[i];
+    models_to_draw_[i]->SetPose(pose);
+  }
 
-  cv::Mat &d = ttrack.GetCurrentDetectorImage();
-    
-  if (!d.empty()){
-   
-    cv::Mat left_d = d(cv::Rect(0, 0, d.cols / 2, d.rows)).clone();
-    cv::Mat right_d = d(cv::Rect(d.cols / 2, 0, d.cols / 2, d.rows)).clone();
+  if (snapshot.frame_index != displayed_frame_index_){
+
+    left_eye_image_ = ci::fromOcv(snapshot.left_image);
+    right_eye_image_ = ci::fromOcv(snapshot.right_image);
+
+    const cv::Mat &d = snapshot.detector_image;
+
+    if (!d.empty()){
+
+      cv::Mat left_d = d(cv::Rect(0, 0, d.cols / 2, d.rows)).clone();
+      cv::Mat right_d = d(cv::Rect(d.cols / 2, 0, d.cols / 2, d.rows)).clone();
+
+      left_detector_image_ = ci::fromOcv(left_d);
+      right_detector_image_ = ci::fromOcv(right_d);
+
+    }
 
-    left_detector_image_ = ci::fromOcv(left_d);
-    right_detector_image_ = ci::fromOcv(right_d);
+    displayed_frame_index_ = snapshot.frame_index;
 
   }
 
-  cv::Mat l = ttrack.GetCurrentLocalizerImage();
+  const cv::Mat &l = snapshot.localizer_image;
   if (!l.empty())
     localizer_image_ = ci::fromOcv(l);
 
+  if (snapshot.converged && snapshot.frame_index != saved_frame_index_){
+    save_results_ = true;
+    saved_frame_index_ = snapshot.frame_index;
+  }
+
 }
 
 void TTrackApp::shutdown(){
@@ -414,9 +510,9 @@ void TTrackApp::drawEye(ttrk::SubWindow &window, ci::gl::Texture &background, co
 
 void TTrackApp::saveResults(){
   
+  //the pose and detector results are saved by the tracking thread, we just hand over what was rendered here for it to save
   auto &ttrack = ttrk::TTrack::Instance(); 
-  ttrack.SaveFrame(toOcv(windows_[0].GetContents()), true);
-  ttrack.SaveResults();
+  ttrack.SaveFrame(toOcv(windows_[0].GetContents()), saved_frame_index_, true);
 
   static cv::VideoWriter mask_writer(ttrk::SubWindow::output_directory + "/mask.avi", CV_FOURCC('M', 'J', 'P', 'G'), 25, depth_map.size(), false);
 
@@ -544,7 +640,7 @@ void TTrackApp::draw(){
     
     drawExtra();
 
-    if (ttrack.HasConverged()){
+    if (save_results_){
       static size_t frame_count = 0;
       ci::app::console() << "Saving results frame: " << frame_count << std::endl;
       frame_count++;
@@ -583,6 +679,7 @@ void TTrackApp::draw(){
       cv::flip(splitter[0], depth_map, 0);
 
       saveResults();
+      save_results_ = false;
 
     }
 
@@ -891,6 +988,12 @@ void TTrackApp::keyDown(KeyEvent k_event){
     force_new_frame_ = true;
 
   }
+
+  if (k_event.getChar() == 'p'){
+
+    ttrk::TTrack::Instance().SaveProfile();
+
+  }
   
 }
 
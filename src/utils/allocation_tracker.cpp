@@ -0,0 +1,172 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "../../include/ttrack/utils/allocation_tracker.hpp"
+
+#ifdef TTRK_TRACK_ALLOCATIONS
+#include <opencv2/core/core.hpp>
+#endif
+
+using namespace ttrk;
+
+namespace {
+
+  //zero initialised before any static constructor can allocate
+  std::atomic<bool> allocation_tracking_enabled;
+
+}
+
+void AllocationTracker::Record(const size_t bytes){
+
+  if (!allocation_tracking_enabled.load(std::memory_order_relaxed)) return;
+  Profiler::Instance().AddAllocation(bytes);
+
+}
+
+bool AllocationTracker::IsEnabled(){
+
+  return allocation_tracking_enabled;
+
+}
+
+#ifdef TTRK_TRACK_ALLOCATIONS
+
+#if CV_MAJOR_VERSION >= 3
+
+namespace {
+
+  /**
+  * @class CountingMatAllocator
+  * @brief Counts the cv::Mat buffers the default allocator hands out. The buffers are still owned and freed by the default allocator.
+  */
+  class CountingMatAllocator : public cv::MatAllocator {
+
+  public:
+
+    explicit CountingMatAllocator(cv::MatAllocator *allocator) : allocator_(allocator) {}
+
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step, int flags, cv::UMatUsageFlags usage_flags) const {
+      cv::UMatData *u = allocator_->allocate(dims, sizes, type, data, step, flags, usage_flags);
+      if (u && !data) AllocationTracker::Record(u->size);
+      return u;
+    }
+
+    bool allocate(cv::UMatData *data, int access_flags, cv::UMatUsageFlags usage_flags) const {
+      return allocator_->allocate(data, access_flags, usage_flags);
+    }
+
+    void deallocate(cv::UMatData *data) const {
+      allocator_->deallocate(data);
+    }
+
+  protected:
+
+    cv::MatAllocator *allocator_; /**< The allocator which does the work. */
+
+  };
+
+}
+
+#endif
+
+bool AllocationTracker::Enable(){
+
+  //make sure the profiler exists before the hooks start using it
+  Profiler::Instance();
+
+#if CV_MAJOR_VERSION >= 3
+  //never destroyed as matrices allocated through it can outlive everything else
+  static CountingMatAllocator *mat_allocator = new CountingMatAllocator(cv::Mat::getStdAllocator());
+  cv::Mat::setDefaultAllocator(mat_allocator);
+#else
+  //OpenCV 2.x allocates cv::Mat buffers with fastMalloc, which has no hook, so only the matrix headers and other C++ allocations are counted
+#endif
+
+  allocation_tracking_enabled = true;
+  return true;
+
+}
+
+void AllocationTracker::Disable(){
+
+  allocation_tracking_enabled = false;
+
+}
+
+bool AllocationTracker::IsAvailable(){
+
+  return true;
+
+}
+
+void *operator new(size_t size){
+
+  void *p = std::malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  AllocationTracker::Record(size);
+  return p;
+
+}
+
+void *operator new[](size_t size){
+
+  return operator new(size);
+
+}
+
+void *operator new(size_t size, const std::nothrow_t &) throw() {
+
+  void *p = std::malloc(size ? size : 1);
+  if (p) AllocationTracker::Record(size);
+  return p;
+
+}
+
+void *operator new[](size_t size, const std::nothrow_t &nt) throw() {
+
+  return operator new(size, nt);
+
+}
+
+void operator delete(void *p) throw() {
+
+  std::free(p);
+
+}
+
+void operator delete[](void *p) throw() {
+
+  std::free(p);
+
+}
+
+void operator delete(void *p, const std::nothrow_t &) throw() {
+
+  std::free(p);
+
+}
+
+void operator delete[](void *p, const std::nothrow_t &) throw() {
+
+  std::free(p);
+
+}
+
+#else
+
+bool AllocationTracker::Enable(){
+
+  return false;
+
+}
+
+void AllocationTracker::Disable(){}
+
+bool AllocationTracker::IsAvailable(){
+
+  return false;
+
+}
+
+#endif
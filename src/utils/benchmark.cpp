@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <boost/chrono.hpp>
+
+#include "../../include/ttrack/utils/benchmark.hpp"
+
+using namespace ttrk;
+
+namespace {
+
+  typedef boost::chrono::high_resolution_clock Clock;
+
+  double ElapsedMilliseconds(const Clock::time_point &begin, const Clock::time_point &end){
+    return boost::chrono::duration<double, boost::milli>(end - begin).count();
+  }
+
+}
+
+Benchmark::Benchmark(const double min_time, const size_t min_iterations, const size_t max_iterations) : min_time_(min_time), min_iterations_(std::max<size_t>(min_iterations, 1)), max_iterations_(std::max(max_iterations, min_iterations)) {}
+
+void Benchmark::Add(const std::string &name, const std::string &params, const std::function<void()> &run, const std::function<void()> &setup){
+
+  Case c;
+  c.name = name;
+  c.params = params;
+  c.run = run;
+  c.setup = setup;
+  cases_.push_back(c);
+
+}
+
+BenchmarkResult Benchmark::RunCase(const Case &c) const {
+
+  BenchmarkResult result;
+  result.name = c.name;
+  result.params = c.params;
+
+  //warm up
+  if (c.setup) c.setup();
+  c.run();
+
+  std::vector<double> times;
+  double total = 0;
+
+  while (times.size() < max_iterations_ && (times.size() < min_iterations_ || total < min_time_ * 1000)){
+
+    if (c.setup) c.setup();
+
+    const Clock::time_point begin = Clock::now();
+    c.run();
+    const Clock::time_point end = Clock::now();
+
+    times.push_back(ElapsedMilliseconds(begin, end));
+    total += times.back();
+
+  }
+
+  std::sort(times.begin(), times.end());
+
+  result.iterations = times.size();
+  result.mean = total / times.size();
+  result.median = times.size() % 2 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+  result.min = times.front();
+  result.max = times.back();
+
+  return result;
+
+}
+
+void Benchmark::Run(std::ostream &log, const std::string &filter){
+
+  results_.clear();
+
+  for (auto &c : cases_){
+
+    if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+
+    try{
+      results_.push_back(RunCase(c));
+    }
+    catch (std::exception &e){
+      log << c.name << " [" << c.params << "] failed: " << e.what() << std::endl;
+      continue;
+    }
+
+    const BenchmarkResult &r = results_.back();
+    log << r.name << " [" << r.params << "] median " << r.median << " ms, mean " << r.mean << " ms, min " << r.min << " ms (" << r.iterations << " runs)" << std::endl;
+
+  }
+
+}
+
+void Benchmark::WriteCSV(const std::string &path) const {
+
+  std::ofstream ofs(path.c_str());
+  if (!ofs.is_open()) throw std::runtime_error("Error, could not open " + path);
+
+  ofs << "name,params,iterations,mean_ms,median_ms,min_ms,max_ms\n";
+
+  for (auto &r : results_)
+    ofs << r.name << "," << r.params << "," << r.iterations << "," << r.mean << "," << r.median << "," << r.min << "," << r.max << "\n";
+
+}
+
+std::vector<BenchmarkResult> Benchmark::ReadCSV(const std::string &path){
+
+  std::ifstream ifs(path.c_str());
+  if (!ifs.is_open()) throw std::runtime_error("Error, could not open " + path);
+
+  std::vector<BenchmarkResult> results;
+  std::string line;
+
+  //skip the header
+  std::getline(ifs, line);
+
+  while (std::getline(ifs, line)){
+
+    if (line.empty()) continue;
+
+    std::stringstream ss(line);
+    std::string iterations, mean, median, min, max;
+    BenchmarkResult r;
+
+    std::getline(ss, r.name, ',');
+    std::getline(ss, r.params, ',');
+    std::getline(ss, iterations, ',');
+    std::getline(ss, mean, ',');
+    std::getline(ss, median, ',');
+    std::getline(ss, min, ',');
+    std::getline(ss, max, ',');
+
+    if (max.empty()) throw std::runtime_error("Error, bad line in benchmark results " + path + ": " + line);
+
+    r.iterations = std::stoul(iterations);
+    r.mean = std::stod(mean);
+    r.median = std::stod(median);
+    r.min = std::stod(min);
+    r.max = std::stod(max);
+
+    results.push_back(r);
+
+  }
+
+  return results;
+
+}
+
+size_t Benchmark::CompareToBaseline(const std::vector<BenchmarkResult> &baseline, const double tolerance, std::ostream &log) const {
+
+  size_t regressions = 0;
+
+  for (auto &r : results_){
+
+    auto b = std::find_if(baseline.begin(), baseline.end(), [&r](const BenchmarkResult &b) { return b.name == r.name && b.params == r.params; });
+    if (b == baseline.end() || b->median <= 0) continue;
+
+    const double change = (r.median - b->median) / b->median;
+    if (change > tolerance){
+      log << "Regression: " << r.name << " [" << r.params << "] median " << r.median << " ms vs baseline " << b->median << " ms (+" << 100 * change << "%)" << std::endl;
+      regressions++;
+    }
+
+  }
+
+  return regressions;
+
+}
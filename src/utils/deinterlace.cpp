@@ -0,0 +1,90 @@
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../../include/ttrack/utils/deinterlace.hpp"
+
+using namespace sv;
+
+namespace {
+
+  //the fixed point weights cv::cvtColor uses for CV_BGR2GRAY, so the cached gray frame is the same as converting it there
+  const int GRAY_SHIFT = 14;
+  const int GRAY_B = 1868, GRAY_G = 9617, GRAY_R = 4899;
+
+  void ConvertRowToGray(const unsigned char *bgr, unsigned char *gray, const int cols, const int channels){
+
+    if (channels == 1){
+      std::memcpy(gray, bgr, cols);
+      return;
+    }
+
+    for (int c = 0; c < cols; ++c, bgr += 3)
+      gray[c] = (unsigned char)((bgr[0] * GRAY_B + bgr[1] * GRAY_G + bgr[2] * GRAY_R + (1 << (GRAY_SHIFT - 1))) >> GRAY_SHIFT);
+
+  }
+
+}
+
+void sv::DeinterlaceAndConvertToGray(cv::Mat &frame, cv::Mat &gray, const DeinterlaceMode mode){
+
+  if (frame.type() != CV_8UC3 && frame.type() != CV_8UC1)
+    throw std::runtime_error("Error, can only deinterlace 8 bit BGR or grayscale frames.");
+
+  gray = cv::Mat(frame.size(), CV_8UC1);
+
+  const int cols = frame.cols, channels = frame.channels();
+  const size_t row_bytes = cols * channels;
+
+  for (int r = 0; r < frame.rows; r += 2){
+
+    unsigned char *even = frame.ptr<unsigned char>(r);
+    //a frame with an odd number of rows has a last even row with no partner, which is left as it is
+    unsigned char *odd = r + 1 < frame.rows ? frame.ptr<unsigned char>(r + 1) : 0x0;
+    unsigned char *gray_even = gray.ptr<unsigned char>(r);
+
+    if (odd == 0x0 || mode == DEINTERLACE_NONE){
+      ConvertRowToGray(even, gray_even, cols, channels);
+      if (odd) ConvertRowToGray(odd, gray.ptr<unsigned char>(r + 1), cols, channels);
+      continue;
+    }
+
+    switch (mode){
+
+    case DEINTERLACE_EVEN_FIELD:
+      std::memcpy(odd, even, row_bytes);
+      break;
+
+    case DEINTERLACE_ODD_FIELD:
+      std::memcpy(even, odd, row_bytes);
+      break;
+
+    case DEINTERLACE_BLEND:
+      for (size_t i = 0; i < row_bytes; ++i) even[i] = (unsigned char)((even[i] + odd[i] + 1) >> 1);
+      std::memcpy(odd, even, row_bytes);
+      break;
+
+    default:
+      break;
+
+    }
+
+    ConvertRowToGray(even, gray_even, cols, channels);
+    std::memcpy(gray.ptr<unsigned char>(r + 1), gray_even, cols);
+
+  }
+
+}
+
+DeinterlaceMode sv::DeinterlaceModeFromString(const std::string &mode_name){
+
+  std::string mode_name_lower = mode_name;
+  std::transform(mode_name.begin(), mode_name.end(), mode_name_lower.begin(), ::tolower);
+
+  if (mode_name_lower == "none") return DEINTERLACE_NONE;
+  else if (mode_name_lower == "even") return DEINTERLACE_EVEN_FIELD;
+  else if (mode_name_lower == "odd") return DEINTERLACE_ODD_FIELD;
+  else if (mode_name_lower == "blend") return DEINTERLACE_BLEND;
+  else throw std::runtime_error("Error, bad deinterlace mode, use none, even, odd or blend.");
+
+}
@@ -0,0 +1,44 @@
+#include <stdexcept>
+#include <opencv2/video/tracking.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "../../include/ttrack/utils/frame_pyramid.hpp"
+
+using namespace sv;
+
+FramePyramid::FramePyramid(cv::Mat image) : image_(image), pyramid_max_level_(-1) {}
+
+FramePyramid::FramePyramid(cv::Mat image, cv::Mat gray) : image_(image), gray_(gray), pyramid_max_level_(-1) {
+
+  if (gray.type() != CV_8UC1 || gray.size() != image.size())
+    throw std::runtime_error("Error, the frame pyramid's gray image must be CV_8UC1 and the same size as the image.");
+
+}
+
+const cv::Mat &FramePyramid::GetGray(){
+
+  if (!gray_.empty()) return gray_;
+
+  if (image_.type() == CV_8UC3)
+    cv::cvtColor(image_, gray_, CV_BGR2GRAY);
+  else if (image_.type() == CV_8UC1)
+    gray_ = image_;
+  else
+    throw std::runtime_error("Error, the frame pyramid needs an 8 bit BGR or grayscale image.");
+
+  return gray_;
+
+}
+
+const std::vector<cv::Mat> &FramePyramid::GetPyramid(const cv::Size win_size, const int max_level){
+
+  if (!pyramid_.empty() && win_size == pyramid_win_size_ && max_level == pyramid_max_level_) return pyramid_;
+
+  pyramid_.clear();
+  cv::buildOpticalFlowPyramid(GetGray(), pyramid_, win_size, max_level, true);
+  pyramid_win_size_ = win_size;
+  pyramid_max_level_ = max_level;
+
+  return pyramid_;
+
+}
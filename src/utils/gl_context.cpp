@@ -0,0 +1,102 @@
+#include <stdexcept>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#elif defined( __APPLE__ )
+#include <OpenGL/OpenGL.h>
+#endif
+
+#include "../../include/ttrack/utils/gl_context.hpp"
+
+using namespace ttrk;
+
+#if defined( _WIN32 )
+
+SharedGLContext::SharedGLContext() : previous_device_context_(0x0), previous_gl_context_(0x0) {
+
+  HDC dc = wglGetCurrentDC();
+  HGLRC parent = wglGetCurrentContext();
+  if (dc == 0x0 || parent == 0x0) throw std::runtime_error("Error, cannot create a shared GL context without a current context.");
+
+  HGLRC ctx = wglCreateContext(dc);
+  if (ctx == 0x0) throw std::runtime_error("Error, could not create GL context.");
+
+  if (!wglShareLists(parent, ctx)){
+    wglDeleteContext(ctx);
+    throw std::runtime_error("Error, could not share GL objects with the current context.");
+  }
+
+  device_context_ = dc;
+  gl_context_ = ctx;
+
+}
+
+SharedGLContext::~SharedGLContext(){
+
+  wglDeleteContext((HGLRC)gl_context_);
+
+}
+
+void SharedGLContext::MakeCurrent(){
+
+  previous_device_context_ = wglGetCurrentDC();
+  previous_gl_context_ = wglGetCurrentContext();
+
+  if (!wglMakeCurrent((HDC)device_context_, (HGLRC)gl_context_)) throw std::runtime_error("Error, could not make GL context current.");
+
+}
+
+void SharedGLContext::Release(){
+
+  wglMakeCurrent((HDC)previous_device_context_, (HGLRC)previous_gl_context_);
+  previous_device_context_ = 0x0;
+  previous_gl_context_ = 0x0;
+
+}
+
+#elif defined( __APPLE__ )
+
+SharedGLContext::SharedGLContext() : device_context_(0x0), previous_device_context_(0x0), previous_gl_context_(0x0) {
+
+  CGLContextObj parent = CGLGetCurrentContext();
+  if (parent == 0x0) throw std::runtime_error("Error, cannot create a shared GL context without a current context.");
+
+  CGLContextObj ctx = 0x0;
+  if (CGLCreateContext(CGLGetPixelFormat(parent), parent, &ctx) != kCGLNoError) throw std::runtime_error("Error, could not create GL context.");
+
+  gl_context_ = ctx;
+
+}
+
+SharedGLContext::~SharedGLContext(){
+
+  CGLReleaseContext((CGLContextObj)gl_context_);
+
+}
+
+void SharedGLContext::MakeCurrent(){
+
+  previous_gl_context_ = CGLGetCurrentContext();
+  if (CGLSetCurrentContext((CGLContextObj)gl_context_) != kCGLNoError) throw std::runtime_error("Error, could not make GL context current.");
+
+}
+
+void SharedGLContext::Release(){
+
+  CGLSetCurrentContext((CGLContextObj)previous_gl_context_);
+  previous_gl_context_ = 0x0;
+
+}
+
+#else
+
+//no shared contexts here, this is a placeholder so the tracker runs in whichever context is current on the GUI thread (see IsShared)
+SharedGLContext::SharedGLContext() : device_context_(0x0), gl_context_(0x0), previous_device_context_(0x0), previous_gl_context_(0x0) {}
+
+SharedGLContext::~SharedGLContext(){}
+
+void SharedGLContext::MakeCurrent(){}
+
+void SharedGLContext::Release(){}
+
+#endif
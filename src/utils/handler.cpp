@@ -1,9 +1,49 @@
 #include "../../include/ttrack/utils/handler.hpp"
+#include <cstring>
+#include <algorithm>
 #include <boost/filesystem.hpp>
 #include <cinder/app/App.h>
 
+#include "../../include/ttrack/utils/helpers.hpp"
+#include "../../include/ttrack/utils/tracer.hpp"
+
 using namespace ttrk;
 
+namespace {
+
+  const char FRAME_CACHE_MAGIC[8] = "TTRKFRM";
+
+  void WriteFrameToVideo(cv::VideoWriter &writer, const std::string &output_url, const cv::Mat &image){
+
+    if(!writer.isOpened()){  
+    // open the writer to create the processed video
+      writer.open(output_url,CV_FOURCC('M','J','P','G'), 25, 
+                  cv::Size(image.cols,image.rows));
+      if(!writer.isOpened()){
+        throw std::runtime_error("Unable to open videofile: " + output_url + " for saving.\nPlease enter a new filename.\n");
+      }
+    }
+  
+    cv::Mat rgb(image.size(), CV_8UC3);
+
+    if (image.type() == CV_8UC4){
+      for (int r = 0; r < rgb.rows; ++r){
+        for (int c = 0; c < rgb.cols; ++c){
+          const auto &t = image.at<cv::Vec4b>(r, c);
+          rgb.at<cv::Vec3b>(r, c) = cv::Vec3b(t[0], t[1], t[2]);
+        }
+      }
+    }
+    else{
+      rgb = image;
+    }
+
+    writer << rgb;
+
+  }
+
+}
+
 Handler::Handler(const std::string &input_url, const std::string &output_url):
   done_(false),
   input_url_(input_url),
@@ -99,52 +139,188 @@ cv::Mat StereoVideoHandler::GetNewFrame(){
 
 }
 
-ImageHandler::ImageHandler(const std::string &input_url, const std::string &output_url):
-  Handler(input_url,output_url){
+ImageHandler::ImageHandler(const std::string &input_url, const std::string &output_url, const size_t num_threads, const size_t max_prefetched):
+  Handler(input_url,output_url),
+  num_threads_(std::max<size_t>(num_threads, 1)),
+  max_prefetched_(std::max<size_t>(max_prefetched, 1)),
+  next_to_decode_(0),
+  next_frame_(0),
+  stop_(false){
+
+  using namespace boost::filesystem;
+  
+  path out_dir(output_url_);
+  if(!is_directory(out_dir)) create_directory(out_dir);
+
+  paths_ = FindImages(input_url_);
+
+  //read the size once here rather than every time someone asks for it
+  cv::Mat first = cv::imread(input_url_ + "/" + paths_[0]);
+  frame_size_ = first.size();
+
+  save_iter_ = paths_.begin();
+
+}
+
+ImageHandler::~ImageHandler(){
+
+  StopDecoders();
+
+}
+
+std::vector<std::string> ImageHandler::FindImages(const std::string &directory){
 
   using namespace boost::filesystem;
   
   // create a directory object
-  path in_dir(input_url_),out_dir(output_url_);
+  path in_dir(directory);
   if(!is_directory(in_dir)){
-    throw std::runtime_error("Error, " + input_url_ + " is not a valid directory.\nTracking cannot be performed.");
+    throw std::runtime_error("Error, " + directory + " is not a valid directory.\nTracking cannot be performed.");
   }
-  
-  if(!is_directory(out_dir)) create_directory(out_dir);
 
-  // create a vector to save the filenames in the directory
-  std::vector<path> images;
-  copy(directory_iterator(in_dir),directory_iterator(),back_inserter(images));
+  //push the actual filenames into the paths vector
+  std::vector<std::string> paths;
+  for (directory_iterator it(in_dir); it != directory_iterator(); ++it){
+    if (is_regular_file(it->status()) && IS_IMAGE(it->path().extension().string()))
+      paths.push_back(it->path().filename().string());
+  }
   
-  if(images.size() == 0){
-    throw std::runtime_error("Error, no image files found in directory: " + input_url_ + "\nPlease enter a new filename.\n");
+  if(paths.size() == 0){
+    throw std::runtime_error("Error, no image files found in directory: " + directory + "\nPlease enter a new filename.\n");
   }
 
-  //push the actual filenames into the paths_ vector
-  for(size_t i=0;i<images.size();i++){
-    paths_.push_back( images[i].filename().string() );
-  }
-  std::cout.flush();
+  //directory iteration order is unspecified
+  std::sort(paths.begin(), paths.end());
+
+  return paths;
+
+}
 
-  open_iter_ = save_iter_ = paths_.begin();
+cv::Mat ImageHandler::LoadFrame(const size_t idx){
+
+  cv::Mat frame = cv::imread(input_url_ + "/" + paths_[idx]);
+  if(frame.data == 0x0) ci::app::console() << "Error, no data in " << paths_[idx] << std::endl;
+  return frame;
 
 }
 
+void ImageHandler::Prefetch(){
+
+  Tracer::Instance().SetThreadName("image_decoder");
+
+  while (true){
+
+    size_t idx;
+
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
 
+      //don't get more than max_prefetched_ ahead of the frame being used
+      while (!stop_ && next_to_decode_ < paths_.size() && next_to_decode_ >= next_frame_ + max_prefetched_)
+        frame_taken_.wait(lock);
+
+      if (stop_ || next_to_decode_ >= paths_.size()) return;
+
+      idx = next_to_decode_++;
+    }
+
+    cv::Mat frame;
+    {
+      TraceScope trace("ImageHandler::LoadFrame");
+      frame = LoadFrame(idx);
+    }
+
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      decoded_[idx] = frame;
+    }
+    frame_decoded_.notify_all();
+
+  }
+
+}
+
+void ImageHandler::StopDecoders(){
+
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  frame_taken_.notify_all();
+  decoders_.join_all();
+
+}
 
 cv::Mat ImageHandler::GetNewFrame(){
 
-  
-  if(open_iter_ == paths_.end()) {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+
+  if(next_frame_ >= paths_.size()) {
     done_ = true;
     return cv::Mat(); //return an empty shared ptr
   }
-  
-  //load next image in the list and return it
-  cv::Mat to_return = cv::imread(input_url_ + "/" + *open_iter_);
-  
-  open_iter_++;
-  if(to_return.data == 0x0) std::cout << "Error, no data" << std::endl;
+
+  if (decoders_.size() == 0){
+    for (size_t i = 0; i < num_threads_; ++i)
+      decoders_.create_thread(boost::bind(&ImageHandler::Prefetch, this));
+  }
+
+  std::map<size_t, cv::Mat>::iterator it;
+  while ((it = decoded_.find(next_frame_)) == decoded_.end())
+    frame_decoded_.wait(lock);
+
+  cv::Mat to_return = it->second;
+  decoded_.erase(it);
+  next_frame_++;
+
+  lock.unlock();
+  frame_taken_.notify_all();
+
+  return to_return;
+
+}
+
+StereoImageHandler::StereoImageHandler(const std::string &left_input_url, const std::string &right_input_url, const std::string &output_url) :
+  ImageHandler(left_input_url, output_url),
+  right_input_url_(right_input_url){
+
+  right_paths_ = FindImages(right_input_url_);
+
+  if (right_paths_.size() != paths_.size()){
+    throw std::runtime_error("Error, different numbers of left and right images in: " + input_url_ + " and " + right_input_url_ + "\n");
+  }
+
+  frame_size_ = LoadFrame(0).size();
+
+}
+
+StereoImageHandler::~StereoImageHandler(){
+
+  StopDecoders();
+
+}
+
+cv::Mat StereoImageHandler::LoadFrame(const size_t idx){
+
+  cv::Mat left_frame = cv::imread(input_url_ + "/" + paths_[idx]);
+  cv::Mat right_frame = cv::imread(right_input_url_ + "/" + right_paths_[idx]);
+
+  if (left_frame.data == 0x0 || right_frame.data == 0x0 || left_frame.size() != right_frame.size() || left_frame.type() != right_frame.type()){
+    ci::app::console() << "Error, bad image pair " << paths_[idx] << " and " << right_paths_[idx] << std::endl;
+    return cv::Mat();
+  }
+
+  //create one big frame to return the image data in
+  cv::Mat to_return(right_frame.rows, 2 * right_frame.cols, right_frame.type());
+  left_frame.copyTo(to_return(cv::Rect(0, 0, right_frame.cols, right_frame.rows)));
+  right_frame.copyTo(to_return(cv::Rect(right_frame.cols, 0, right_frame.cols, right_frame.rows)));
+
+  if (right_frame.size() == cv::Size(1920, 1080)){
+    cv::Mat resized;
+    cv::resize(to_return, resized, cv::Size(0, 0), 0.5, 0.5);
+    to_return = resized;
+  }
+
   return to_return;
 
 }
@@ -176,32 +352,122 @@ void ImageHandler::SaveFrame(const cv::Mat image){
 
 void VideoHandler::SaveFrame(const cv::Mat image){
 
-  if(!writer_.isOpened()){  
-  // open the writer to create the processed video
-    writer_.open(output_url_,CV_FOURCC('M','J','P','G'), 25, 
-                 cv::Size(image.cols,image.rows));
-    if(!writer_.isOpened()){
-      throw std::runtime_error("Unable to open videofile: " + output_url_ + " for saving.\nPlease enter a new filename.\n");
-    }
+  WriteFrameToVideo(writer_, output_url_, image);
+
+}
+
+CacheRecordingHandler::CacheRecordingHandler(Handler *source, const std::string &cache_url) :
+  Handler(cache_url, ""),
+  source_(source){
+
+  std::memset(&header_, 0, sizeof(header_));
+  std::memcpy(header_.magic, FRAME_CACHE_MAGIC, sizeof(header_.magic));
+  header_.version = FrameCacheHeader::VERSION;
+
+  cache_.open(cache_url.c_str(), std::ios::binary | std::ios::trunc);
+  if (!cache_.is_open()){
+    throw std::runtime_error("Unable to open frame cache: " + cache_url + " for writing.\n");
   }
-  
-  
-  if(!writer_.isOpened()) throw std::runtime_error("Error, attempt to save frame without available video writer.\n");
-  
-  cv::Mat rgb(image.size(), CV_8UC3);
 
-  if (image.type() == CV_8UC4){
-    for (int r = 0; r < rgb.rows; ++r){
-      for (int c = 0; c < rgb.cols; ++c){
-        const auto &t = image.at<cv::Vec4b>(r, c);
-        rgb.at<cv::Vec3b>(r, c) = cv::Vec3b(t[0], t[1], t[2]);
-      }
-    }
+  cache_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+
+}
+
+CacheRecordingHandler::~CacheRecordingHandler(){
+
+  //now we know how many frames there are
+  cache_.seekp(0);
+  cache_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+  cache_.close();
+
+}
+
+cv::Mat CacheRecordingHandler::GetNewFrame(){
+
+  cv::Mat frame = source_->GetNewFrame();
+  if (frame.data == 0x0) return frame;
+
+  if (header_.num_frames == 0 && header_.frame_stride == 0){
+    header_.rows = frame.rows;
+    header_.cols = frame.cols;
+    header_.type = frame.type();
+    header_.frame_stride = (frame.total() * frame.elemSize() + FrameCacheHeader::FRAME_ALIGNMENT - 1) & ~boost::uint64_t(FrameCacheHeader::FRAME_ALIGNMENT - 1);
+  }
+
+  if (frame.rows != header_.rows || frame.cols != header_.cols || frame.type() != header_.type){
+    throw std::runtime_error("Error, frames of different sizes cannot be recorded in the same frame cache.\n");
+  }
+
+  const size_t row_bytes = frame.cols * frame.elemSize();
+  for (int r = 0; r < frame.rows; ++r)
+    cache_.write(reinterpret_cast<const char *>(frame.ptr(r)), row_bytes);
+
+  const size_t padding = header_.frame_stride - frame.rows * row_bytes;
+  static const char zeros[FrameCacheHeader::FRAME_ALIGNMENT] = { 0 };
+  cache_.write(zeros, padding);
+
+  if (header_.num_frames == 0){
+    //rewrite the header with the frame geometry so a recording that is never closed can still be replayed from the frames on disk
+    cache_.seekp(0);
+    cache_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+    cache_.seekp(0, std::ios::end);
+    cache_.flush();
+  }
+
+  header_.num_frames++;
+
+  return frame;
+
+}
+
+CachedFrameHandler::CachedFrameHandler(const std::string &input_url, const std::string &output_url) :
+  Handler(input_url, output_url),
+  num_frames_(0),
+  next_frame_(0){
+
+  try{
+    file_.reset(new boost::interprocess::file_mapping(input_url.c_str(), boost::interprocess::read_only));
+    //copy on write so that anything that modifies the frame in place gets private pages rather than a crash
+    region_.reset(new boost::interprocess::mapped_region(*file_, boost::interprocess::copy_on_write));
   }
-  else{
-    rgb = image;
+  catch (boost::interprocess::interprocess_exception &e){
+    throw std::runtime_error("Unable to open frame cache: " + input_url + "\n" + e.what());
   }
 
-  writer_ << rgb;
+  const char *data = static_cast<const char *>(region_->get_address());
+  const size_t size = region_->get_size();
+
+  if (size < sizeof(header_)) throw std::runtime_error("Error, " + input_url + " is not a frame cache.\n");
+  std::memcpy(&header_, data, sizeof(header_));
+
+  if (std::memcmp(header_.magic, FRAME_CACHE_MAGIC, sizeof(header_.magic)) != 0 || header_.version != FrameCacheHeader::VERSION){
+    throw std::runtime_error("Error, " + input_url + " is not a frame cache.\n");
+  }
+
+  //a recording that wasn't closed has no frame count, use whatever complete frames made it to disk
+  const size_t frames_on_disk = header_.frame_stride ? (size - sizeof(header_)) / header_.frame_stride : 0;
+  num_frames_ = header_.num_frames ? std::min<size_t>(header_.num_frames, frames_on_disk) : frames_on_disk;
+
+  ci::app::console() << "Loaded frame cache with " << num_frames_ << " frames" << std::endl;
+
+}
+
+cv::Mat CachedFrameHandler::GetNewFrame(){
+
+  if (next_frame_ >= num_frames_){
+    done_ = true;
+    return cv::Mat();
+  }
+
+  char *frame_data = static_cast<char *>(region_->get_address()) + sizeof(header_) + next_frame_ * header_.frame_stride;
+  next_frame_++;
+
+  return cv::Mat(header_.rows, header_.cols, header_.type, frame_data);
+
+}
+
+void CachedFrameHandler::SaveFrame(const cv::Mat image){
+
+  WriteFrameToVideo(writer_, output_url_, image);
 
 }
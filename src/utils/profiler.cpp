@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+#include "../../include/ttrack/utils/profiler.hpp"
+#include "../../include/ttrack/utils/allocation_tracker.hpp"
+
+using namespace ttrk;
+
+namespace {
+
+  const char *STAGE_NAMES[NUM_PROFILE_STAGES] = { "frame_load", "alignment_step", "render", "readback", "distance_transform", "intersection_image", "jacobian", "classification", "lk", "retrain", "results_io" };
+  const char *COUNTER_NAMES[NUM_PROFILE_COUNTERS] = { "contour_pixels", "tracked_points" };
+
+  //allocations outside any stage
+  const char *OTHER_ALLOCATIONS_NAME = "other";
+
+  const char *GetAllocationScopeName(const size_t scope){
+    return scope < NUM_PROFILE_STAGES ? STAGE_NAMES[scope] : OTHER_ALLOCATIONS_NAME;
+  }
+
+  //plain thread local storage rather than boost::thread_specific_ptr as this is read from inside operator new
+#ifdef _MSC_VER
+  __declspec(thread) int current_allocation_scope = NUM_PROFILE_STAGES;
+#else
+  __thread int current_allocation_scope = NUM_PROFILE_STAGES;
+#endif
+
+  //nearest rank percentile of sorted samples
+  double Percentile(const std::vector<float> &sorted, const double p){
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    if (rank > 0) rank--;
+    return sorted[std::min(rank, sorted.size() - 1)];
+  }
+
+}
+
+Profiler &Profiler::Instance(){
+
+  //never destroyed so stages can still be timed (and the profile saved) from other objects' destructors at exit
+  static Profiler *profiler = new Profiler;
+  return *profiler;
+
+}
+
+Profiler::Profiler() : num_frames_(0) {
+
+  for (size_t i = 0; i < NUM_PROFILE_STAGES; ++i){
+    stage_time_[i] = 0;
+    stage_calls_[i] = 0;
+    total_calls_[i] = 0;
+  }
+
+  for (size_t i = 0; i < NUM_PROFILE_COUNTERS; ++i) counters_[i] = 0;
+
+  for (size_t i = 0; i <= NUM_PROFILE_STAGES; ++i){
+    allocation_bytes_[i] = 0;
+    allocation_count_[i] = 0;
+  }
+
+}
+
+int Profiler::EnterAllocationScope(const int stage){
+
+  const int previous = current_allocation_scope;
+  current_allocation_scope = stage;
+  return previous;
+
+}
+
+void Profiler::LeaveAllocationScope(const int previous){
+
+  current_allocation_scope = previous;
+
+}
+
+int Profiler::GetAllocationScope(){
+
+  return current_allocation_scope;
+
+}
+
+const char *Profiler::GetStageName(const ProfileStage stage){
+
+  if (stage < 0 || stage >= NUM_PROFILE_STAGES) throw std::runtime_error("Error, unknown profile stage.");
+  return STAGE_NAMES[stage];
+
+}
+
+std::string Profiler::GetCounterName(const ProfileCounter counter){
+
+  if (counter < 0 || counter >= NUM_PROFILE_COUNTERS) throw std::runtime_error("Error, unknown profile counter.");
+  return COUNTER_NAMES[counter];
+
+}
+
+void Profiler::EndFrame(){
+
+  boost::lock_guard<boost::mutex> lock(mutex_);
+
+  for (size_t i = 0; i < NUM_PROFILE_STAGES; ++i){
+    const boost::int64_t calls = stage_calls_[i].exchange(0);
+    const boost::int64_t time = stage_time_[i].exchange(0);
+    if (calls == 0) continue;
+    stage_samples_[i].push_back((float)(time * 1e-6));
+    total_calls_[i] += calls;
+  }
+
+  for (size_t i = 0; i < NUM_PROFILE_COUNTERS; ++i)
+    counter_samples_[i].push_back((float)counters_[i].exchange(0));
+
+  //every stage gets a sample, including zero, so the per-frame report lines up
+  const bool track_allocations = AllocationTracker::IsEnabled();
+  for (size_t i = 0; i <= NUM_PROFILE_STAGES; ++i){
+    const boost::int64_t bytes = allocation_bytes_[i].exchange(0);
+    const boost::int64_t count = allocation_count_[i].exchange(0);
+    if (!track_allocations) continue;
+    allocation_bytes_samples_[i].push_back((float)bytes);
+    allocation_count_samples_[i].push_back((float)count);
+  }
+
+  num_frames_++;
+
+}
+
+void Profiler::Reset(){
+
+  boost::lock_guard<boost::mutex> lock(mutex_);
+
+  for (size_t i = 0; i < NUM_PROFILE_STAGES; ++i){
+    stage_time_[i] = 0;
+    stage_calls_[i] = 0;
+    total_calls_[i] = 0;
+    stage_samples_[i].clear();
+  }
+
+  for (size_t i = 0; i < NUM_PROFILE_COUNTERS; ++i){
+    counters_[i] = 0;
+    counter_samples_[i].clear();
+  }
+
+  for (size_t i = 0; i <= NUM_PROFILE_STAGES; ++i){
+    allocation_bytes_[i] = 0;
+    allocation_count_[i] = 0;
+    allocation_bytes_samples_[i].clear();
+    allocation_count_samples_[i].clear();
+  }
+
+  num_frames_ = 0;
+
+}
+
+size_t Profiler::GetNumberOfFrames() const {
+
+  boost::lock_guard<boost::mutex> lock(mutex_);
+  return num_frames_;
+
+}
+
+Profiler::Summary Profiler::Summarize(std::vector<float> samples, const boost::uint64_t calls){
+
+  Summary s;
+  s.calls = calls;
+  s.frames = samples.size();
+  if (samples.empty()) return s;
+
+  std::sort(samples.begin(), samples.end());
+
+  double total = 0;
+  for (auto v : samples) total += v;
+
+  s.mean = total / samples.size();
+  s.p50 = Percentile(samples, 0.50);
+  s.p95 = Percentile(samples, 0.95);
+  s.p99 = Percentile(samples, 0.99);
+  s.max = samples.back();
+
+  return s;
+
+}
+
+void Profiler::GetSummaries(std::vector<Summary> &stages, std::vector<Summary> &counters, std::vector<Summary> &allocation_bytes, std::vector<Summary> &allocation_counts) const {
+
+  boost::lock_guard<boost::mutex> lock(mutex_);
+
+  stages.clear();
+  counters.clear();
+  allocation_bytes.clear();
+  allocation_counts.clear();
+
+  for (size_t i = 0; i < NUM_PROFILE_STAGES; ++i) stages.push_back(Summarize(stage_samples_[i], total_calls_[i]));
+  for (size_t i = 0; i < NUM_PROFILE_COUNTERS; ++i) counters.push_back(Summarize(counter_samples_[i], 0));
+
+  if (allocation_bytes_samples_[NUM_PROFILE_STAGES].empty()) return;
+
+  for (size_t i = 0; i <= NUM_PROFILE_STAGES; ++i){
+    allocation_bytes.push_back(Summarize(allocation_bytes_samples_[i], 0));
+    allocation_counts.push_back(Summarize(allocation_count_samples_[i], 0));
+  }
+
+}
+
+void Profiler::WriteCSV(const std::string &path) const {
+
+  std::vector<Summary> stages, counters, allocation_bytes, allocation_counts;
+  GetSummaries(stages, counters, allocation_bytes, allocation_counts);
+
+  std::ofstream ofs(path.c_str());
+  if (!ofs.is_open()) throw std::runtime_error("Error, could not open " + path);
+
+  ofs << "name,type,frames,calls,mean,p50,p95,p99,max\n";
+
+  for (size_t i = 0; i < stages.size(); ++i){
+    const Summary &s = stages[i];
+    ofs << STAGE_NAMES[i] << ",stage_ms," << s.frames << "," << s.calls << "," << s.mean << "," << s.p50 << "," << s.p95 << "," << s.p99 << "," << s.max << "\n";
+  }
+
+  for (size_t i = 0; i < counters.size(); ++i){
+    const Summary &s = counters[i];
+    ofs << COUNTER_NAMES[i] << ",counter," << s.frames << ",," << s.mean << "," << s.p50 << "," << s.p95 << "," << s.p99 << "," << s.max << "\n";
+  }
+
+  for (size_t i = 0; i < allocation_bytes.size(); ++i){
+    const Summary &b = allocation_bytes[i], &c = allocation_counts[i];
+    ofs << GetAllocationScopeName(i) << ",alloc_bytes," << b.frames << ",," << b.mean << "," << b.p50 << "," << b.p95 << "," << b.p99 << "," << b.max << "\n";
+    ofs << GetAllocationScopeName(i) << ",allocs," << c.frames << ",," << c.mean << "," << c.p50 << "," << c.p95 << "," << c.p99 << "," << c.max << "\n";
+  }
+
+}
+
+void Profiler::WriteJSON(const std::string &path) const {
+
+  std::vector<Summary> stages, counters, allocation_bytes, allocation_counts;
+  GetSummaries(stages, counters, allocation_bytes, allocation_counts);
+
+  std::ofstream ofs(path.c_str());
+  if (!ofs.is_open()) throw std::runtime_error("Error, could not open " + path);
+
+  ofs << "{\n  \"frames\": " << GetNumberOfFrames() << ",\n  \"stages_ms\": {\n";
+
+  for (size_t i = 0; i < stages.size(); ++i){
+    const Summary &s = stages[i];
+    ofs << "    \"" << STAGE_NAMES[i] << "\": { \"frames\": " << s.frames << ", \"calls\": " << s.calls << ", \"mean\": " << s.mean << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95 << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << " }";
+    ofs << (i + 1 < stages.size() ? ",\n" : "\n");
+  }
+
+  ofs << "  },\n  \"counters\": {\n";
+
+  for (size_t i = 0; i < counters.size(); ++i){
+    const Summary &s = counters[i];
+    ofs << "    \"" << COUNTER_NAMES[i] << "\": { \"frames\": " << s.frames << ", \"mean\": " << s.mean << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95 << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << " }";
+    ofs << (i + 1 < counters.size() ? ",\n" : "\n");
+  }
+
+  ofs << "  }";
+
+  if (!allocation_bytes.empty()){
+
+    ofs << ",\n  \"allocations\": {\n";
+
+    for (size_t i = 0; i < allocation_bytes.size(); ++i){
+      const Summary &b = allocation_bytes[i], &c = allocation_counts[i];
+      ofs << "    \"" << GetAllocationScopeName(i) << "\": { \"bytes\": { \"mean\": " << b.mean << ", \"p50\": " << b.p50 << ", \"p95\": " << b.p95 << ", \"p99\": " << b.p99 << ", \"max\": " << b.max << " }";
+      ofs << ", \"count\": { \"mean\": " << c.mean << ", \"p50\": " << c.p50 << ", \"p95\": " << c.p95 << ", \"p99\": " << c.p99 << ", \"max\": " << c.max << " } }";
+      ofs << (i + 1 < allocation_bytes.size() ? ",\n" : "\n");
+    }
+
+    ofs << "  }";
+
+  }
+
+  ofs << "\n}\n";
+
+}
+
+void Profiler::WriteAllocationsCSV(const std::string &path) const {
+
+  boost::lock_guard<boost::mutex> lock(mutex_);
+
+  const size_t num_frames = allocation_bytes_samples_[NUM_PROFILE_STAGES].size();
+  if (num_frames == 0) return;
+
+  std::ofstream ofs(path.c_str());
+  if (!ofs.is_open()) throw std::runtime_error("Error, could not open " + path);
+
+  ofs << "frame";
+  for (size_t i = 0; i <= NUM_PROFILE_STAGES; ++i) ofs << "," << GetAllocationScopeName(i) << "_bytes," << GetAllocationScopeName(i) << "_allocs";
+  ofs << ",total_bytes,total_allocs\n";
+
+  for (size_t f = 0; f < num_frames; ++f){
+
+    double total_bytes = 0, total_count = 0;
+    ofs << f;
+    for (size_t i = 0; i <= NUM_PROFILE_STAGES; ++i){
+      ofs << "," << (boost::int64_t)allocation_bytes_samples_[i][f] << "," << (boost::int64_t)allocation_count_samples_[i][f];
+      total_bytes += allocation_bytes_samples_[i][f];
+      total_count += allocation_count_samples_[i][f];
+    }
+    ofs << "," << (boost::int64_t)total_bytes << "," << (boost::int64_t)total_count << "\n";
+
+  }
+
+}
@@ -0,0 +1,157 @@
+#include <set>
+#include <cinder/app/App.h>
+
+#include "../../include/ttrack/utils/results_writer.hpp"
+#include "../../include/ttrack/utils/profiler.hpp"
+
+using namespace ttrk;
+
+ResultsWriter::ResultsWriter(const size_t max_queued_frames, const size_t max_queued_texts, const double fps) : queued_frames_(0), queued_texts_(0), records_pushed_(0), records_written_(0), dropped_frames_(0), stop_(false), max_queued_frames_(max_queued_frames), max_queued_texts_(max_queued_texts), fps_(fps) {
+
+  thread_ = boost::thread(boost::bind(&ResultsWriter::Run, this));
+
+}
+
+ResultsWriter::~ResultsWriter(){
+
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_available_.notify_one();
+  thread_.join();
+
+}
+
+void ResultsWriter::WriteText(const std::string &path, const std::string &text){
+
+  if (path.empty()){
+    ci::app::console() << "Results file is not set!" << std::endl;
+    throw std::runtime_error("Error, no file to write the results to.");
+  }
+
+  Record r;
+  r.path = path;
+  r.text = text;
+
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    //results can't be dropped, so if the disk can't keep up the tracker waits rather than the queue growing without bound
+    while (queued_texts_ >= max_queued_texts_)
+      batch_written_.wait(lock);
+    queue_.push_back(r);
+    queued_texts_++;
+    records_pushed_++;
+  }
+  work_available_.notify_one();
+
+}
+
+void ResultsWriter::WriteFrame(const std::string &path, const cv::Mat &frame, const bool droppable){
+
+  if (frame.empty()) return;
+
+  Record r;
+  r.path = path;
+  r.frame = frame;
+
+  {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    if (droppable && queued_frames_ >= max_queued_frames_){
+      dropped_frames_++;
+      return;
+    }
+    queue_.push_back(r);
+    queued_frames_++;
+    records_pushed_++;
+  }
+  work_available_.notify_one();
+
+}
+
+void ResultsWriter::Flush(){
+
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  const size_t target = records_pushed_;
+  while (records_written_ < target)
+    batch_written_.wait(lock);
+
+}
+
+void ResultsWriter::Run(){
+
+  Tracer::Instance().SetThreadName("results_writer");
+
+  std::deque<Record> batch;
+
+  while (true){
+
+    size_t batch_end;
+
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      while (queue_.empty() && !stop_)
+        work_available_.wait(lock);
+
+      if (queue_.empty() && stop_) break;
+
+      //take everything that's waiting in one go so the tracker only ever contends for the lock for a push
+      batch.swap(queue_);
+      batch_end = records_pushed_;
+    }
+
+    WriteBatch(batch);
+
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      for (auto &r : batch){
+        if (!r.frame.empty()) queued_frames_--;
+        else queued_texts_--;
+      }
+      records_written_ = batch_end;
+    }
+    batch_written_.notify_all();
+
+    batch.clear();
+
+  }
+
+  for (auto &file : text_files_) file.second->flush();
+
+}
+
+void ResultsWriter::WriteBatch(std::deque<Record> &batch){
+
+  ScopedTimer io_timer(PROFILE_RESULTS_IO);
+
+  std::set<std::ofstream *> touched;
+
+  for (auto &r : batch){
+
+    if (r.frame.empty()){
+
+      boost::shared_ptr<std::ofstream> &ofs = text_files_[r.path];
+      if (!ofs){
+        ofs.reset(new std::ofstream(r.path.c_str()));
+        if (!ofs->is_open()) ci::app::console() << "Error, could not open " << r.path << " for writing." << std::endl;
+      }
+      ofs->write(r.text.c_str(), r.text.size());
+      touched.insert(ofs.get());
+
+    }
+    else{
+
+      boost::shared_ptr<cv::VideoWriter> &writer = video_files_[r.path];
+      if (!writer){
+        writer.reset(new cv::VideoWriter(r.path, CV_FOURCC('M', 'J', 'P', 'G'), fps_, r.frame.size(), r.frame.channels() == 3));
+        if (!writer->isOpened()) ci::app::console() << "Error, could not open " << r.path << " for writing." << std::endl;
+      }
+      if (writer->isOpened()) *writer << r.frame;
+
+    }
+
+  }
+
+  for (auto ofs : touched) ofs->flush();
+
+}
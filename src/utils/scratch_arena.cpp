@@ -0,0 +1,36 @@
+#include "../../include/ttrack/utils/scratch_arena.hpp"
+
+using namespace ttrk;
+
+namespace {
+
+  //a buffer is free when the pool holds the only reference to it
+  bool IsFree(const cv::Mat &buffer){
+#if CV_MAJOR_VERSION >= 3
+    return buffer.u != 0x0 && buffer.u->refcount == 1;
+#else
+    return buffer.refcount != 0x0 && *buffer.refcount == 1;
+#endif
+  }
+
+}
+
+cv::Mat ScratchArena::Acquire(const cv::Size &size, const int type){
+
+  for (auto &buffer : buffers_){
+    if (buffer.size() == size && buffer.type() == type && IsFree(buffer))
+      return buffer;
+  }
+
+  buffers_.push_back(cv::Mat(size, type));
+  return buffers_.back();
+
+}
+
+cv::Mat ScratchArena::AcquireZeros(const cv::Size &size, const int type){
+
+  cv::Mat m = Acquire(size, type);
+  m.setTo(cv::Scalar::all(0));
+  return m;
+
+}
@@ -0,0 +1,189 @@
+#include <stdexcept>
+
+#include "../../include/ttrack/utils/tracer.hpp"
+
+using namespace ttrk;
+
+Tracer &Tracer::Instance(){
+
+  //never destroyed so spans can still be recorded (and the trace stopped) from other objects' destructors at exit
+  static Tracer *tracer = new Tracer;
+  return *tracer;
+
+}
+
+Tracer::Tracer() : enabled_(false), full_chunks_(0x0), thread_state_(&Tracer::KeepThreadState), first_event_(true) {}
+
+Tracer::ThreadState *Tracer::GetThreadState(){
+
+  ThreadState *state = thread_state_.get();
+  if (state) return state;
+
+  boost::shared_ptr<ThreadState> new_state(new ThreadState);
+
+  {
+    boost::lock_guard<boost::mutex> lock(threads_mutex_);
+    new_state->id = (boost::uint32_t)threads_.size() + 1;
+    new_state->current = new Chunk(new_state->id);
+    threads_.push_back(new_state);
+  }
+
+  thread_state_.reset(new_state.get());
+  return new_state.get();
+
+}
+
+void Tracer::SetThreadName(const std::string &name){
+
+  ThreadState *state = GetThreadState();
+
+  boost::lock_guard<boost::mutex> lock(threads_mutex_);
+  state->name = name;
+
+}
+
+void Tracer::Record(const char *name, const Clock::time_point &begin, const Clock::time_point &end){
+
+  if (!enabled_.load(std::memory_order_acquire)) return;
+
+  ThreadState *state = GetThreadState();
+  Chunk *chunk = state->current.load(std::memory_order_relaxed);
+  size_t n = chunk->size.load(std::memory_order_relaxed);
+
+  if (n == Chunk::CAPACITY){
+
+    //switch to a fresh chunk before handing the full one over so the flusher never sees a chunk it has already deleted as current
+    Chunk *full = chunk;
+    chunk = new Chunk(state->id);
+    state->current.store(chunk, std::memory_order_release);
+
+    Chunk *head = full_chunks_.load(std::memory_order_relaxed);
+    do{
+      full->next = head;
+    } while (!full_chunks_.compare_exchange_weak(head, full, std::memory_order_release, std::memory_order_relaxed));
+
+    n = 0;
+
+  }
+
+  Event &e = chunk->events[n];
+  e.name = name;
+  e.begin = boost::chrono::duration_cast<boost::chrono::microseconds>(begin - origin_).count();
+  e.duration = boost::chrono::duration_cast<boost::chrono::microseconds>(end - begin).count();
+
+  chunk->size.store(n + 1, std::memory_order_release);
+
+}
+
+void Tracer::Start(const std::string &path){
+
+  boost::lock_guard<boost::mutex> lock(flush_mutex_);
+
+  if (enabled_) return;
+
+  ofs_.open(path.c_str(), std::ios::trunc);
+  if (!ofs_.is_open()) throw std::runtime_error("Error, could not open trace file " + path);
+
+  ofs_ << "{\"traceEvents\":[\n";
+  first_event_ = true;
+
+  //anything recorded before this trace started is dropped
+  {
+    boost::lock_guard<boost::mutex> threads_lock(threads_mutex_);
+    for (auto &thread : threads_){
+      Chunk *chunk = thread->current.load(std::memory_order_acquire);
+      chunk->exported = chunk->size.load(std::memory_order_acquire);
+    }
+  }
+
+  Chunk *full = full_chunks_.exchange(0x0, std::memory_order_acquire);
+  while (full){
+    Chunk *next = full->next;
+    delete full;
+    full = next;
+  }
+
+  origin_ = Clock::now();
+  enabled_.store(true, std::memory_order_release);
+
+  flush_thread_ = boost::thread(boost::bind(&Tracer::Run, this));
+
+}
+
+void Tracer::Stop(){
+
+  {
+    boost::lock_guard<boost::mutex> lock(flush_mutex_);
+    if (!enabled_) return;
+    enabled_.store(false, std::memory_order_release);
+  }
+
+  flush_thread_.interrupt();
+  flush_thread_.join();
+
+  boost::lock_guard<boost::mutex> lock(flush_mutex_);
+
+  Flush();
+
+  boost::lock_guard<boost::mutex> threads_lock(threads_mutex_);
+  for (auto &thread : threads_){
+    if (thread->name.empty()) continue;
+    ofs_ << (first_event_ ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id << ",\"args\":{\"name\":\"" << thread->name << "\"}}";
+    first_event_ = false;
+  }
+
+  ofs_ << "\n]}\n";
+  ofs_.close();
+
+}
+
+void Tracer::Run(){
+
+  try{
+    while (true){
+      boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+      boost::lock_guard<boost::mutex> lock(flush_mutex_);
+      Flush();
+    }
+  }
+  catch (boost::thread_interrupted &){
+  }
+
+}
+
+void Tracer::Flush(){
+
+  Chunk *full = full_chunks_.exchange(0x0, std::memory_order_acquire);
+  while (full){
+    Chunk *next = full->next;
+    WriteEvents(full, full->size.load(std::memory_order_acquire));
+    delete full;
+    full = next;
+  }
+
+  std::vector<boost::shared_ptr<ThreadState> > threads;
+  {
+    boost::lock_guard<boost::mutex> lock(threads_mutex_);
+    threads = threads_;
+  }
+
+  for (auto &thread : threads){
+    Chunk *chunk = thread->current.load(std::memory_order_acquire);
+    WriteEvents(chunk, chunk->size.load(std::memory_order_acquire));
+  }
+
+  ofs_.flush();
+
+}
+
+void Tracer::WriteEvents(Chunk *chunk, const size_t end){
+
+  for (size_t i = chunk->exported; i < end; ++i){
+    const Event &e = chunk->events[i];
+    ofs_ << (first_event_ ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << chunk->thread_id << ",\"ts\":" << e.begin << ",\"dur\":" << e.duration << "}";
+    first_event_ = false;
+  }
+
+  chunk->exported = end;
+
+}
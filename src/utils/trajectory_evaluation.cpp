@@ -0,0 +1,115 @@
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../../include/ttrack/utils/trajectory_evaluation.hpp"
+
+using namespace ttrk;
+
+PoseError ttrk::ComputePoseError(const std::vector<float> &estimate, const std::vector<float> &truth){
+
+  if (estimate.size() != truth.size() || truth.size() < 7) throw std::runtime_error("Error, poses to compare must have the same number of DOFs.");
+
+  PoseError error;
+
+  float squared_distance = 0.0f;
+  for (size_t i = 0; i < 3; ++i) squared_distance += (estimate[i] - truth[i]) * (estimate[i] - truth[i]);
+  error.translation = std::sqrt(squared_distance);
+
+  //the angle of the rotation between two unit quaternions, q and -q are the same orientation
+  float dot = 0.0f, estimate_norm = 0.0f, truth_norm = 0.0f;
+  for (size_t i = 3; i < 7; ++i){
+    dot += estimate[i] * truth[i];
+    estimate_norm += estimate[i] * estimate[i];
+    truth_norm += truth[i] * truth[i];
+  }
+  if (estimate_norm > 0 && truth_norm > 0){
+    const float cos_half_angle = std::min(1.0f, std::abs(dot) / std::sqrt(estimate_norm * truth_norm));
+    error.rotation = 2.0f * std::acos(cos_half_angle) * 180.0f / 3.14159265f;
+  }
+
+  if (truth.size() > 7){
+    for (size_t i = 7; i < truth.size(); ++i) error.articulation += std::abs(estimate[i] - truth[i]);
+    error.articulation /= (truth.size() - 7);
+  }
+
+  return error;
+
+}
+
+std::vector<std::vector<float> > ttrk::ReadPoseFile(const std::string &path){
+
+  std::ifstream ifs(path.c_str());
+  if (!ifs.is_open()) throw std::runtime_error("Error, could not open pose file " + path);
+
+  std::vector<std::vector<float> > poses;
+  std::string line;
+
+  while (std::getline(ifs, line)){
+
+    std::stringstream ss(line);
+    std::vector<float> pose;
+    float x;
+    while (ss >> x) pose.push_back(x);
+
+    if (!pose.empty()) poses.push_back(pose);
+
+  }
+
+  return poses;
+
+}
+
+TrajectoryEvaluation ttrk::EvaluateTrajectory(const TrajectoryLogReader &log, const std::vector<std::vector<float> > &ground_truth, const size_t first_frame_index){
+
+  TrajectoryEvaluation evaluation;
+
+  double total_iterations = 0, total_translation = 0, total_rotation = 0, total_articulation = 0;
+  std::vector<double> latencies;
+
+  for (size_t i = 0; i < log.GetNumberOfRecords(); ++i){
+
+    const TrajectoryRecord record = log.GetRecord(i);
+    if (record.frame_index < first_frame_index || record.frame_index - first_frame_index >= ground_truth.size()) continue;
+
+    const PoseError error = ComputePoseError(record.dofs, ground_truth[(size_t)(record.frame_index - first_frame_index)]);
+
+    double latency = 0;
+    for (auto t : record.timings) latency += t;
+    latencies.push_back(latency);
+
+    total_iterations += record.iterations;
+    total_translation += error.translation;
+    total_rotation += error.rotation;
+    total_articulation += error.articulation;
+
+    evaluation.max_translation_error = std::max<double>(evaluation.max_translation_error, error.translation);
+    evaluation.max_rotation_error = std::max<double>(evaluation.max_rotation_error, error.rotation);
+    evaluation.final_translation_error = error.translation;
+    evaluation.final_rotation_error = error.rotation;
+    evaluation.frames++;
+
+  }
+
+  if (evaluation.frames == 0) return evaluation;
+
+  double total_time = 0;
+  for (auto l : latencies) total_time += l;
+  evaluation.fps = total_time > 0 ? evaluation.frames / total_time : 0;
+  evaluation.mean_latency = 1000 * total_time / evaluation.frames;
+
+  //nearest rank percentile
+  std::sort(latencies.begin(), latencies.end());
+  const size_t p99_rank = (size_t)std::ceil(0.99 * latencies.size());
+  evaluation.p99_latency = 1000 * latencies[std::max<size_t>(p99_rank, 1) - 1];
+
+  evaluation.mean_iterations = total_iterations / evaluation.frames;
+  evaluation.mean_translation_error = total_translation / evaluation.frames;
+  evaluation.mean_rotation_error = total_rotation / evaluation.frames;
+  evaluation.mean_articulation_error = total_articulation / evaluation.frames;
+
+  return evaluation;
+
+}
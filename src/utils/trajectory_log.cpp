@@ -0,0 +1,282 @@
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <boost/chrono.hpp>
+
+#include "../../include/ttrack/utils/trajectory_log.hpp"
+
+using namespace ttrk;
+
+namespace {
+
+  const char LOG_MAGIC[8] = "TTRKTRJ";
+  const boost::uint32_t BLOCK_MAGIC = 0x4b4c4254; //"TBLK"
+
+  double Now(){
+    return boost::chrono::duration<double>(boost::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  //the size of a block's columns (excluding the block header) padded to 8 bytes
+  size_t BlockSize(const size_t num_records, const size_t num_dofs, const size_t num_stages){
+    const size_t size = num_records * (sizeof(boost::uint64_t) + sizeof(double) + sizeof(float) + sizeof(boost::uint32_t) + (num_dofs + num_stages) * sizeof(float));
+    return (size + 7) & ~size_t(7);
+  }
+
+  template<typename T>
+  void WriteColumn(std::vector<char> &block, size_t &offset, const T &value){
+    std::memcpy(&block[offset], &value, sizeof(T));
+    offset += sizeof(T);
+  }
+
+  template<typename T>
+  T ReadValue(const char *column, const size_t idx){
+    T value;
+    std::memcpy(&value, column + idx * sizeof(T), sizeof(T));
+    return value;
+  }
+
+}
+
+TrajectoryLogWriter::TrajectoryLogWriter(const std::string &path, const size_t num_dofs, const std::vector<std::string> &stage_names, const size_t block_capacity) {
+
+  if (stage_names.size() > TrajectoryLogHeader::MAX_STAGES) throw std::runtime_error("Error, too many stages for the trajectory log.");
+  if (block_capacity == 0) throw std::runtime_error("Error, block capacity must be positive.");
+
+  std::memset(&header_, 0, sizeof(header_));
+  std::memcpy(header_.magic, LOG_MAGIC, sizeof(header_.magic));
+  header_.version = TrajectoryLogHeader::VERSION;
+  header_.num_dofs = (boost::uint32_t)num_dofs;
+  header_.num_stages = (boost::uint32_t)stage_names.size();
+  header_.block_capacity = (boost::uint32_t)block_capacity;
+  header_.start_time = Now();
+  for (size_t i = 0; i < stage_names.size(); ++i)
+    std::strncpy(header_.stage_names[i], stage_names[i].c_str(), TrajectoryLogHeader::MAX_STAGE_NAME - 1);
+
+  ofs_.open(path.c_str(), std::ios::binary | std::ios::trunc);
+  if (!ofs_.is_open()) throw std::runtime_error("Error, could not open trajectory log " + path);
+
+  ofs_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+  ofs_.flush();
+
+  buffer_.reserve(block_capacity);
+
+}
+
+TrajectoryLogWriter::~TrajectoryLogWriter(){
+
+  Flush();
+
+}
+
+double TrajectoryLogWriter::GetElapsedTime() const {
+
+  return Now() - header_.start_time;
+
+}
+
+void TrajectoryLogWriter::Append(const TrajectoryRecord &record){
+
+  buffer_.push_back(record);
+
+  if (buffer_.size() >= header_.block_capacity) Flush();
+
+}
+
+void TrajectoryLogWriter::Flush(){
+
+  if (buffer_.empty()) return;
+
+  const size_t n = buffer_.size();
+  std::vector<char> block(sizeof(TrajectoryBlockHeader) + BlockSize(n, header_.num_dofs, header_.num_stages), 0);
+
+  TrajectoryBlockHeader block_header;
+  block_header.magic = BLOCK_MAGIC;
+  block_header.num_records = (boost::uint32_t)n;
+  std::memcpy(&block[0], &block_header, sizeof(block_header));
+
+  size_t offset = sizeof(block_header);
+  for (size_t i = 0; i < n; ++i) WriteColumn(block, offset, buffer_[i].frame_index);
+  for (size_t i = 0; i < n; ++i) WriteColumn(block, offset, buffer_[i].timestamp);
+  for (size_t i = 0; i < n; ++i) WriteColumn(block, offset, buffer_[i].score);
+  for (size_t i = 0; i < n; ++i) WriteColumn(block, offset, buffer_[i].iterations);
+
+  for (size_t d = 0; d < header_.num_dofs; ++d){
+    for (size_t i = 0; i < n; ++i) WriteColumn(block, offset, d < buffer_[i].dofs.size() ? buffer_[i].dofs[d] : 0.0f);
+  }
+
+  for (size_t s = 0; s < header_.num_stages; ++s){
+    for (size_t i = 0; i < n; ++i) WriteColumn(block, offset, s < buffer_[i].timings.size() ? buffer_[i].timings[s] : 0.0f);
+  }
+
+  ofs_.write(&block[0], block.size());
+  ofs_.flush();
+
+  buffer_.clear();
+
+}
+
+TrajectoryLogReader::TrajectoryLogReader(const std::string &path) : num_records_(0) {
+
+  try{
+    file_.reset(new boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only));
+    region_.reset(new boost::interprocess::mapped_region(*file_, boost::interprocess::read_only));
+  }
+  catch (boost::interprocess::interprocess_exception &e){
+    throw std::runtime_error("Error, could not map trajectory log " + path + ": " + e.what());
+  }
+
+  const char *data = static_cast<const char *>(region_->get_address());
+  const size_t size = region_->get_size();
+
+  if (size < sizeof(header_)) throw std::runtime_error("Error, " + path + " is too small to be a trajectory log.");
+  std::memcpy(&header_, data, sizeof(header_));
+
+  if (std::memcmp(header_.magic, LOG_MAGIC, sizeof(header_.magic)) != 0) throw std::runtime_error("Error, " + path + " is not a trajectory log.");
+  if (header_.version != TrajectoryLogHeader::VERSION) throw std::runtime_error("Error, unsupported trajectory log version.");
+  if (header_.num_stages > TrajectoryLogHeader::MAX_STAGES) throw std::runtime_error("Error, corrupt trajectory log header.");
+
+  size_t offset = sizeof(header_);
+  while (offset + sizeof(TrajectoryBlockHeader) <= size){
+
+    TrajectoryBlockHeader block_header;
+    std::memcpy(&block_header, data + offset, sizeof(block_header));
+    if (block_header.magic != BLOCK_MAGIC) throw std::runtime_error("Error, corrupt block in trajectory log.");
+
+    const size_t block_size = BlockSize(block_header.num_records, header_.num_dofs, header_.num_stages);
+
+    //a block cut short by a crash is ignored
+    if (offset + sizeof(block_header) + block_size > size) break;
+
+    Block block;
+    block.data = data + offset + sizeof(block_header);
+    block.num_records = block_header.num_records;
+    block.first_record = num_records_;
+    blocks_.push_back(block);
+
+    num_records_ += block.num_records;
+    offset += sizeof(block_header) + block_size;
+
+  }
+
+}
+
+std::vector<std::string> TrajectoryLogReader::GetStageNames() const {
+
+  std::vector<std::string> names;
+  for (size_t i = 0; i < header_.num_stages; ++i)
+    names.push_back(std::string(header_.stage_names[i], strnlen(header_.stage_names[i], TrajectoryLogHeader::MAX_STAGE_NAME)));
+  return names;
+
+}
+
+const char *TrajectoryLogReader::GetColumn(const Block &block, const size_t column) const {
+
+  const size_t n = block.num_records;
+
+  if (column == 0) return block.data;
+  if (column == 1) return block.data + n * sizeof(boost::uint64_t);
+  if (column == 2) return block.data + n * (sizeof(boost::uint64_t) + sizeof(double));
+  if (column == 3) return block.data + n * (sizeof(boost::uint64_t) + sizeof(double) + sizeof(float));
+
+  return block.data + n * (sizeof(boost::uint64_t) + sizeof(double) + sizeof(float) + sizeof(boost::uint32_t) + (column - 4) * sizeof(float));
+
+}
+
+TrajectoryRecord TrajectoryLogReader::GetRecord(const size_t idx) const {
+
+  if (idx >= num_records_) throw std::runtime_error("Error, trajectory record index out of range.");
+
+  //find the last block starting at or before idx
+  size_t lo = 0, hi = blocks_.size();
+  while (hi - lo > 1){
+    const size_t mid = (lo + hi) / 2;
+    if (blocks_[mid].first_record <= idx) lo = mid;
+    else hi = mid;
+  }
+
+  const Block &block = blocks_[lo];
+  const size_t i = idx - block.first_record;
+
+  TrajectoryRecord record;
+  record.frame_index = ReadValue<boost::uint64_t>(GetColumn(block, 0), i);
+  record.timestamp = ReadValue<double>(GetColumn(block, 1), i);
+  record.score = ReadValue<float>(GetColumn(block, 2), i);
+  record.iterations = ReadValue<boost::uint32_t>(GetColumn(block, 3), i);
+
+  for (size_t d = 0; d < header_.num_dofs; ++d)
+    record.dofs.push_back(ReadValue<float>(GetColumn(block, 4 + d), i));
+
+  for (size_t s = 0; s < header_.num_stages; ++s)
+    record.timings.push_back(ReadValue<float>(GetColumn(block, 4 + header_.num_dofs + s), i));
+
+  return record;
+
+}
+
+void TrajectoryLogReader::GetFrameIndexes(std::vector<boost::uint64_t> &frame_indexes) const {
+
+  frame_indexes.resize(num_records_);
+  for (auto &block : blocks_){
+    if (block.num_records) std::memcpy(&frame_indexes[block.first_record], GetColumn(block, 0), block.num_records * sizeof(boost::uint64_t));
+  }
+
+}
+
+void TrajectoryLogReader::GetDof(const size_t dof, std::vector<float> &values) const {
+
+  if (dof >= header_.num_dofs) throw std::runtime_error("Error, DOF index out of range.");
+
+  values.resize(num_records_);
+  for (auto &block : blocks_){
+    if (block.num_records) std::memcpy(&values[block.first_record], GetColumn(block, 4 + dof), block.num_records * sizeof(float));
+  }
+
+}
+
+void TrajectoryLogReader::GetStageTiming(const size_t stage, std::vector<float> &values) const {
+
+  if (stage >= header_.num_stages) throw std::runtime_error("Error, stage index out of range.");
+
+  values.resize(num_records_);
+  for (auto &block : blocks_){
+    if (block.num_records) std::memcpy(&values[block.first_record], GetColumn(block, 4 + header_.num_dofs + stage), block.num_records * sizeof(float));
+  }
+
+}
+
+void TrajectoryLogReader::WriteCSV(const std::string &path) const {
+
+  std::ofstream ofs(path.c_str());
+  if (!ofs.is_open()) throw std::runtime_error("Error, could not open " + path);
+
+  ofs << "frame,timestamp,score,iterations";
+  for (size_t d = 0; d < header_.num_dofs; ++d) ofs << ",dof_" << d;
+  for (auto &name : GetStageNames()) ofs << "," << name;
+  ofs << "\n";
+
+  for (size_t i = 0; i < num_records_; ++i){
+
+    const TrajectoryRecord record = GetRecord(i);
+    ofs << record.frame_index << "," << record.timestamp << "," << record.score << "," << record.iterations;
+    for (auto &d : record.dofs) ofs << "," << d;
+    for (auto &t : record.timings) ofs << "," << t;
+    ofs << "\n";
+
+  }
+
+}
+
+void TrajectoryLogReader::WritePoseText(const std::string &path) const {
+
+  std::ofstream ofs(path.c_str());
+  if (!ofs.is_open()) throw std::runtime_error("Error, could not open " + path);
+
+  for (size_t i = 0; i < num_records_; ++i){
+
+    const TrajectoryRecord record = GetRecord(i);
+    for (auto &d : record.dofs) ofs << d << " ";
+    ofs << "\n\n";
+
+  }
+
+}
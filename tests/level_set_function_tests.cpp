@@ -0,0 +1,67 @@
+//#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include "../include/ttrack/track/localizer/levelsets/level_set_functions.hpp"
+
+BOOST_AUTO_TEST_SUITE( level_set_function_test_suite )
+
+BOOST_AUTO_TEST_CASE( heaviside_table_matches_analytic ) {
+
+  for (int width = 1; width <= 8; ++width){
+
+    ttrk::HeavisideTable table(width);
+
+    float max_heaviside_error = 0, max_delta_error = 0;
+    for (float x = -width - 2.0f; x <= width + 2.0f; x += 0.0007f){
+      max_heaviside_error = std::max(max_heaviside_error, std::abs(table.Heaviside(x) - ttrk::HeavisideTable::AnalyticHeaviside(x, width)));
+      max_delta_error = std::max(max_delta_error, std::abs(table.Delta(x) - ttrk::HeavisideTable::AnalyticDelta(x, width)));
+    }
+
+    BOOST_CHECK_LT(max_heaviside_error, 1e-6f);
+    BOOST_CHECK_LT(max_delta_error, 1e-6f);
+
+  }
+
+}
+
+BOOST_AUTO_TEST_CASE( heaviside_table_band_edges ) {
+
+  ttrk::HeavisideTable table(3);
+
+  BOOST_CHECK_EQUAL(table.Heaviside(3.0f), 1.0f);
+  BOOST_CHECK_EQUAL(table.Heaviside(-3.0f), 0.0f);
+  BOOST_CHECK_EQUAL(table.Heaviside(100.0f), 1.0f);
+  BOOST_CHECK_EQUAL(table.Heaviside(-100.0f), 0.0f);
+  BOOST_CHECK_EQUAL(table.Delta(3.5f), 0.0f);
+  BOOST_CHECK_EQUAL(table.Delta(-3.5f), 0.0f);
+  BOOST_CHECK_CLOSE(table.Heaviside(0.0f), 0.5f, 1e-4);
+  BOOST_CHECK_CLOSE(table.Delta(0.0f), 1.0f / 3.0f, 1e-4);
+
+  //just inside the band, where the interpolation reads the last samples
+  BOOST_CHECK_LE(table.Heaviside(std::nextafter(3.0f, 0.0f)), 1.0f);
+  BOOST_CHECK_GE(table.Delta(std::nextafter(3.0f, 0.0f)), 0.0f);
+
+  table.SetWidth(5);
+  BOOST_CHECK_EQUAL(table.GetWidth(), 5);
+  BOOST_CHECK_CLOSE(table.Delta(0.0f), 1.0f / 5.0f, 1e-4);
+
+}
+
+BOOST_AUTO_TEST_CASE( fast_log_matches_log ) {
+
+  float max_error = 0;
+
+  //densely over the range of the region error terms (probabilities down to the 1e-7 floor) then sparsely over the rest of the floats
+  for (float x = 1e-7f; x < 2.0f; x *= 1.0001f)
+    max_error = std::max(max_error, std::abs(ttrk::FastLog(x) - std::log(x)) / std::max(1.0f, std::abs(std::log(x))));
+
+  for (float x = 1e-37f; x < 1e38f; x *= 1.37f)
+    max_error = std::max(max_error, std::abs(ttrk::FastLog(x) - std::log(x)) / std::max(1.0f, std::abs(std::log(x))));
+
+  BOOST_CHECK_LT(max_error, 1e-6f);
+  BOOST_CHECK_EQUAL(ttrk::FastLog(1.0f), 0.0f);
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
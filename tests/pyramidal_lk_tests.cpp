@@ -0,0 +1,115 @@
+//#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+#include "../include/ttrack/track/localizer/features/pyramidal_lk.hpp"
+
+namespace {
+
+  //a small sub-pixel shift so every point stays well inside the image and textured enough to track in both trackers
+  const cv::Point2f shift(1.7f, -0.8f);
+
+  struct ShiftedImageFixture {
+
+    ShiftedImageFixture() : lk(cv::Size(21, 21), 3) {
+
+      //smoothed noise gives every window plenty of texture while staying smooth enough for the bilinear shift to be accurate
+      cv::Mat noise(480, 640, CV_8UC1);
+      cv::RNG rng(0x5eed);
+      rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+      cv::GaussianBlur(noise, previous, cv::Size(0, 0), 2.0);
+      cv::normalize(previous, previous, 0, 255, cv::NORM_MINMAX);
+
+      //without WARP_INVERSE_MAP the image content moves by +shift
+      cv::Mat translation = (cv::Mat_<double>(2, 3) << 1, 0, shift.x, 0, 1, shift.y);
+      cv::warpAffine(previous, current, translation, previous.size(), cv::INTER_LINEAR, cv::BORDER_REFLECT);
+
+      cv::buildOpticalFlowPyramid(previous, previous_pyramid, lk.GetWindowSize(), lk.GetMaxLevel(), true);
+      cv::buildOpticalFlowPyramid(current, current_pyramid, lk.GetWindowSize(), lk.GetMaxLevel(), true);
+
+      for (int r = 60; r < previous.rows - 60; r += 40){
+        for (int c = 60; c < previous.cols - 60; c += 40){
+          previous_points.push_back(cv::Point2f(c + 0.25f, r + 0.5f));
+        }
+      }
+
+    }
+
+    ttrk::PyramidalLK lk;
+    cv::Mat previous, current;
+    std::vector<cv::Mat> previous_pyramid, current_pyramid;
+    std::vector<cv::Point2f> previous_points;
+
+  };
+
+}
+
+BOOST_FIXTURE_TEST_SUITE( pyramidal_lk_test_suite, ShiftedImageFixture )
+
+BOOST_AUTO_TEST_CASE( tracks_known_shift ) {
+
+  std::vector<cv::Point2f> current_points;
+  std::vector<unsigned char> status;
+  std::vector<float> forward_backward_error, residuals;
+  lk.Track(previous_pyramid, current_pyramid, previous_points, current_points, status, forward_backward_error, residuals);
+
+  BOOST_REQUIRE_EQUAL(current_points.size(), previous_points.size());
+  BOOST_REQUIRE_EQUAL(status.size(), previous_points.size());
+
+  for (size_t i = 0; i < previous_points.size(); ++i){
+
+    BOOST_REQUIRE_EQUAL((int)status[i], 1);
+
+    const cv::Point2f error = current_points[i] - (previous_points[i] + shift);
+    //iterating stops once an update moves less than the 0.03 pixel epsilon, so allow a few times that
+    BOOST_CHECK_LT(std::sqrt(error.dot(error)), 0.1f);
+    BOOST_CHECK_LT(forward_backward_error[i], 0.1f);
+    BOOST_CHECK_LT(residuals[i], 2.0f);
+
+  }
+
+}
+
+BOOST_AUTO_TEST_CASE( track_forward_matches_track ) {
+
+  std::vector<cv::Point2f> both_ways_points, forward_points;
+  std::vector<unsigned char> both_ways_status, forward_status;
+  std::vector<float> forward_backward_error, both_ways_residuals, forward_residuals;
+  lk.Track(previous_pyramid, current_pyramid, previous_points, both_ways_points, both_ways_status, forward_backward_error, both_ways_residuals);
+  lk.TrackForward(previous_pyramid, current_pyramid, previous_points, forward_points, forward_status, forward_residuals);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(forward_status.begin(), forward_status.end(), both_ways_status.begin(), both_ways_status.end());
+  for (size_t i = 0; i < previous_points.size(); ++i){
+    BOOST_CHECK_EQUAL(forward_points[i].x, both_ways_points[i].x);
+    BOOST_CHECK_EQUAL(forward_points[i].y, both_ways_points[i].y);
+    BOOST_CHECK_EQUAL(forward_residuals[i], both_ways_residuals[i]);
+  }
+
+}
+
+BOOST_AUTO_TEST_CASE( matches_opencv_lk ) {
+
+  std::vector<cv::Point2f> current_points;
+  std::vector<unsigned char> status;
+  std::vector<float> residuals;
+  lk.TrackForward(previous_pyramid, current_pyramid, previous_points, current_points, status, residuals);
+
+  //same window, levels, stopping criteria and eigenvalue threshold as the PyramidalLK defaults the fixture doesn't override
+  std::vector<cv::Point2f> opencv_points;
+  std::vector<unsigned char> opencv_status;
+  std::vector<float> opencv_error;
+  cv::calcOpticalFlowPyrLK(previous_pyramid, current_pyramid, previous_points, opencv_points, opencv_status, opencv_error, lk.GetWindowSize(), lk.GetMaxLevel(), cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 0.03), 0, 0.001);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(status.begin(), status.end(), opencv_status.begin(), opencv_status.end());
+
+  for (size_t i = 0; i < previous_points.size(); ++i){
+    if (!status[i] || !opencv_status[i]) continue;
+    const cv::Point2f difference = current_points[i] - opencv_points[i];
+    BOOST_CHECK_LT(std::sqrt(difference.dot(difference)), 0.05f);
+  }
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
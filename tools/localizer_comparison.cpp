@@ -0,0 +1,231 @@
+#include <boost/filesystem.hpp>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+
+#include "../include/ttrack/utils/config_reader.hpp"
+#include "../include/ttrack/utils/trajectory_log.hpp"
+#include "../include/ttrack/utils/trajectory_evaluation.hpp"
+
+using namespace ttrk;
+
+namespace {
+
+  /**
+  * @struct Combination
+  * @brief One localizer and classifier pair to run and its results.
+  */
+  struct Combination {
+
+    Combination() : succeeded(false), meets_accuracy(false) {}
+
+    std::string localizer; /**< The localizer type as named in the config files. */
+    std::string classifier; /**< The classifier type as named in the config files. */
+    bool succeeded; /**< Whether the tracking app ran and wrote a trajectory. */
+    bool meets_accuracy; /**< Whether the errors are within the configured limits. */
+    TrajectoryEvaluation evaluation; /**< The results. */
+
+  };
+
+  std::vector<std::string> SplitWords(const std::string &str){
+
+    std::vector<std::string> words;
+    std::stringstream ss(str);
+    std::string word;
+    while (ss >> word) words.push_back(word);
+    return words;
+
+  }
+
+  template<typename T>
+  T GetOptionalElement(const ConfigReader &reader, const std::string &key, const T &default_value){
+
+    try{
+      return reader.get_element_as_type<T>(key);
+    }
+    catch (std::runtime_error &){
+      return default_value;
+    }
+
+  }
+
+  //copy the tracking config with the localizer, classifier and output directory replaced
+  void WriteRunConfig(const std::string &tracking_config, const Combination &c, const std::string &output_dir, const std::string &run_config){
+
+    std::ifstream ifs(tracking_config.c_str());
+    if (!ifs.is_open()) throw std::runtime_error("Error, could not open tracking config " + tracking_config);
+
+    std::ofstream ofs(run_config.c_str());
+    if (!ofs.is_open()) throw std::runtime_error("Error, could not write config " + run_config);
+
+    std::string line;
+    while (std::getline(ifs, line)){
+
+      const std::string key = line.substr(0, line.find('='));
+      if (key == "localizer-type" || key == "classifier-type" || key == "output-dir") continue;
+      ofs << line << "\n";
+
+    }
+
+    ofs << "localizer-type=" << c.localizer << "\n";
+    ofs << "classifier-type=" << c.classifier << "\n";
+    ofs << "output-dir=" << output_dir << "\n";
+
+  }
+
+  int RunTrackingApp(const std::string &executable, const std::string &config){
+
+    std::stringstream command;
+#ifdef _WIN32
+    //the app is a GUI program so cmd won't wait for it without start /wait, and cmd strips the outer quotes
+    command << "\"start \"\" /wait \"" << executable << "\" \"" << config << "\" --autostart\"";
+#else
+    command << "\"" << executable << "\" \"" << config << "\" --autostart";
+#endif
+
+    return std::system(command.str().c_str());
+
+  }
+
+  void WriteTable(std::ostream &os, const std::vector<Combination> &combinations){
+
+    os << std::left << std::setw(50) << "localizer" << std::setw(11) << "classifier" << std::right << std::setw(8) << "frames" << std::setw(9) << "fps"
+       << std::setw(11) << "mean ms" << std::setw(11) << "p99 ms" << std::setw(11) << "steps" << std::setw(11) << "mean mm" << std::setw(11) << "final mm"
+       << std::setw(11) << "mean deg" << std::setw(11) << "final deg" << std::setw(7) << "ok" << "\n";
+
+    os << std::fixed << std::setprecision(2);
+
+    for (auto &c : combinations){
+
+      os << std::left << std::setw(50) << c.localizer << std::setw(11) << c.classifier << std::right;
+
+      if (!c.succeeded){
+        os << std::setw(8) << "failed" << "\n";
+        continue;
+      }
+
+      const TrajectoryEvaluation &e = c.evaluation;
+      os << std::setw(8) << e.frames << std::setw(9) << e.fps << std::setw(11) << e.mean_latency << std::setw(11) << e.p99_latency << std::setw(11) << e.mean_iterations
+         << std::setw(11) << e.mean_translation_error << std::setw(11) << e.final_translation_error << std::setw(11) << e.mean_rotation_error << std::setw(11) << e.final_rotation_error
+         << std::setw(7) << (c.meets_accuracy ? "yes" : "no") << "\n";
+
+    }
+
+  }
+
+  void WriteCSV(const std::string &path, const std::vector<Combination> &combinations){
+
+    std::ofstream ofs(path.c_str());
+    if (!ofs.is_open()) throw std::runtime_error("Error, could not open " + path);
+
+    ofs << "localizer,classifier,succeeded,frames,fps,mean_latency_ms,p99_latency_ms,steps_per_frame,mean_translation_error,max_translation_error,final_translation_error,mean_rotation_error_deg,max_rotation_error_deg,final_rotation_error_deg,mean_articulation_error,meets_accuracy\n";
+
+    for (auto &c : combinations){
+
+      const TrajectoryEvaluation &e = c.evaluation;
+      ofs << c.localizer << "," << c.classifier << "," << c.succeeded << "," << e.frames << "," << e.fps << "," << e.mean_latency << "," << e.p99_latency << "," << e.mean_iterations << ","
+          << e.mean_translation_error << "," << e.max_translation_error << "," << e.final_translation_error << "," << e.mean_rotation_error << "," << e.max_rotation_error << ","
+          << e.final_rotation_error << "," << e.mean_articulation_error << "," << c.meets_accuracy << "\n";
+
+    }
+
+  }
+
+}
+
+/**
+* Runs a tracking config through several localizer and classifier combinations and compares their speed and accuracy.
+*
+* Each combination is tracked by a separate run of the tracking app (with --autostart) so one combination can't affect the timings of
+* the next through caches, leaked GL state or a crash. The trajectory log of each run is compared to the reference poses and a single
+* table is written to comparison.csv and printed. See examples/comparison.cfg for the config.
+*/
+int main(int argc, char **argv){
+
+  const std::string config_file = argc > 1 ? argv[1] : "comparison.cfg";
+
+  try{
+
+    ConfigReader reader(config_file);
+
+    const std::string executable = reader.get_element("comparison-executable");
+    const std::string tracking_config = reader.get_element("comparison-tracking-config");
+    const std::string output_dir = reader.get_element("comparison-output-dir");
+    const std::vector<std::vector<float> > reference_poses = ReadPoseFile(reader.get_element("comparison-reference-poses"));
+
+    const double max_translation_error = GetOptionalElement<double>(reader, "comparison-max-translation-error", 5.0);
+    const double max_rotation_error = GetOptionalElement<double>(reader, "comparison-max-rotation-error", 10.0);
+
+    if (!boost::filesystem::is_directory(output_dir)) boost::filesystem::create_directories(output_dir);
+
+    std::vector<Combination> combinations;
+    for (auto &localizer : SplitWords(reader.get_element("comparison-localizers"))){
+      for (auto &classifier : SplitWords(reader.get_element("comparison-classifiers"))){
+        Combination c;
+        c.localizer = localizer;
+        c.classifier = classifier;
+        combinations.push_back(c);
+      }
+    }
+
+    for (auto &c : combinations){
+
+      const std::string run_dir = output_dir + "/" + c.localizer + "_" + c.classifier;
+      const std::string run_config = output_dir + "/" + c.localizer + "_" + c.classifier + ".cfg";
+
+      //the app creates the output directory and then writes into the first run_N subdirectory that doesn't exist, so clearing it first
+      //puts the results in run_0
+      if (boost::filesystem::exists(run_dir)) boost::filesystem::remove_all(run_dir);
+
+      WriteRunConfig(tracking_config, c, run_dir, run_config);
+
+      std::cout << "Running " << c.localizer << " with " << c.classifier << std::endl;
+
+      const int status = RunTrackingApp(executable, run_config);
+      const std::string trajectory = run_dir + "/run_0/trajectory_model_0.bin";
+
+      if (status != 0 || !boost::filesystem::exists(trajectory)){
+        std::cout << "Error, " << c.localizer << " with " << c.classifier << " failed (exit status " << status << ")" << std::endl;
+        continue;
+      }
+
+      try{
+        c.evaluation = EvaluateTrajectory(TrajectoryLogReader(trajectory), reference_poses);
+        c.succeeded = c.evaluation.frames > 0;
+        c.meets_accuracy = c.succeeded && c.evaluation.mean_translation_error <= max_translation_error && c.evaluation.mean_rotation_error <= max_rotation_error;
+      }
+      catch (std::runtime_error &e){
+        std::cout << "Error, could not evaluate " << trajectory << ": " << e.what() << std::endl;
+      }
+
+    }
+
+    WriteCSV(output_dir + "/comparison.csv", combinations);
+
+    std::cout << "\n";
+    WriteTable(std::cout, combinations);
+
+    const Combination *cheapest = nullptr;
+    for (auto &c : combinations){
+      if (c.meets_accuracy && (cheapest == nullptr || c.evaluation.fps > cheapest->evaluation.fps)) cheapest = &c;
+    }
+
+    if (cheapest)
+      std::cout << "\nFastest combination within " << max_translation_error << " mm and " << max_rotation_error << " deg: " << cheapest->localizer << " with " << cheapest->classifier << std::endl;
+    else
+      std::cout << "\nNo combination is within " << max_translation_error << " mm and " << max_rotation_error << " deg" << std::endl;
+
+  }
+  catch (std::exception &e){
+
+    std::cerr << "Error, comparison failed: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+
+  }
+
+  return EXIT_SUCCESS;
+
+}
@@ -0,0 +1,39 @@
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include "../include/ttrack/utils/trajectory_log.hpp"
+
+/**
+* Convert a binary trajectory log written by the tracker to text.
+* Usage: trajectory_convert <log.bin> <output> [csv|pose]
+* csv (the default) writes one row per frame with all of the logged columns, pose writes the DOFs in the tracked_model*.txt format.
+*/
+int main(int argc, char **argv){
+
+  if (argc < 3){
+    std::cerr << "Usage: " << argv[0] << " <log.bin> <output> [csv|pose]" << std::endl;
+    return 1;
+  }
+
+  const std::string format = argc > 3 ? argv[3] : "csv";
+
+  try{
+
+    ttrk::TrajectoryLogReader reader(argv[1]);
+
+    if (format == "csv") reader.WriteCSV(argv[2]);
+    else if (format == "pose") reader.WritePoseText(argv[2]);
+    else throw std::runtime_error("Error, unknown output format " + format);
+
+    std::cout << "Converted " << reader.GetNumberOfRecords() << " records." << std::endl;
+
+  }
+  catch (std::runtime_error &e){
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+}